@@ -0,0 +1,235 @@
+// Loop-kernel benchmark for the induction-variable pass.
+//
+// Runs a set of small NanoScript kernels (counted loops over flat arrays)
+// twice: as analyzed, and after InductionOptimizer. Each run is timed in
+// the interpreter (best of --repeat runs) and both runs must print the
+// same checksum; a mismatch is reported and the exit code is 1.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 bench/loop-bench.cpp src/compiler/*.cpp src/runtime/*.cpp -o loop-bench
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "../src/compiler/scanner.h"
+#include "../src/compiler/parser.h"
+#include "../src/compiler/semantic-analyzer.h"
+#include "../src/compiler/induction-optimizer.h"
+#include "../src/runtime/interpreter.h"
+#include "../src/util/error-handler.h"
+
+namespace {
+
+struct Kernel {
+    const char* name;
+    const char* what;
+    const char* source; // N stands for the problem size
+};
+
+// Each kernel prints a checksum so that both versions can be compared
+const std::vector<Kernel>& kernels() {
+    static const std::vector<Kernel> list = {
+        {"matmul", "n/4 x n/4 matrix product, row-major", R"(
+var int n = N / 4;
+var int[] a = int[n * n];
+var int[] b = int[n * n];
+var int[] c = int[n * n];
+var int i = 0;
+while (i < n * n) { a[i] = i - i / 7 * 7; b[i] = i - i / 5 * 5; i = i + 1; }
+i = 0;
+while (i < n) {
+    var int j = 0;
+    while (j < n) {
+        var int s = 0;
+        var int k = 0;
+        while (k < n) { s = s + a[i * n + k] * b[k * n + j]; k = k + 1; }
+        c[i * n + j] = s;
+        j = j + 1;
+    }
+    i = i + 1;
+}
+print(sum(c));
+)"},
+        {"transpose", "n x n transpose and symmetric sum", R"(
+var int n = N;
+var int[] m = int[n * n];
+var int[] t = int[n * n];
+var int r = 0;
+while (r < n) {
+    var int q = 0;
+    while (q < n) { m[r * n + q] = r * 3 + q; q = q + 1; }
+    r = r + 1;
+}
+r = 0;
+while (r < n) {
+    var int q = 0;
+    while (q < n) { t[q * n + r] = m[r * n + q] + m[q * n + r]; q = q + 1; }
+    r = r + 1;
+}
+print(sum(t));
+)"},
+        {"complex", "interleaved re/im pairs, strided access", R"(
+var int n = N * N;
+var int[] z = int[n * 2];
+var int i = 0;
+while (i < n) { z[i * 2] = i - i / 11 * 11; z[i * 2 + 1] = i - i / 13 * 13; i = i + 1; }
+var int re = 0;
+var int im = 0;
+i = 0;
+while (i < len(z) / 2) {
+    re = re + z[i * 2] * z[i * 2] - z[i * 2 + 1] * z[i * 2 + 1];
+    im = im + 2 * z[i * 2] * z[i * 2 + 1];
+    i = i + 1;
+}
+print(re + im);
+)"},
+        {"fir", "4-tap filter with a constant-trip inner loop", R"(
+var int n = N * N;
+var int[] x = int[n + 4];
+var int[] taps = [3, -1, 4, 1];
+var int i = 0;
+while (i < len(x)) { x[i] = i - i / 9 * 9; i = i + 1; }
+var int total = 0;
+i = 0;
+while (i < n) {
+    var int acc = 0;
+    var int t = 0;
+    while (t < 4) { acc = acc + taps[t] * x[i + t]; t = t + 1; }
+    total = total + acc;
+    i = i + 1;
+}
+print(total);
+)"},
+    };
+    return list;
+}
+
+struct BenchOptions {
+    int size = 256;
+    int repeat = 3;
+    std::vector<std::string> names;
+};
+
+void printUsage() {
+    std::cout << "Usage: loop-bench [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --size=N           Problem size n (default 256)" << std::endl;
+    std::cout << "  --kernels=LIST     matmul,transpose,complex,fir (default all)" << std::endl;
+    std::cout << "  --repeat=N         Runs per measurement; the fastest is kept (default 3)" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--size") {
+            options.size = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--kernels") {
+            std::stringstream stream(value);
+            std::string item;
+            while (std::getline(stream, item, ',')) {
+                bool known = false;
+                for (const Kernel& kernel : kernels()) known = known || item == kernel.name;
+                if (!known) {
+                    std::cerr << "Unknown kernel: " << item << std::endl;
+                    return false;
+                }
+                options.names.push_back(item);
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Compiles `source` (optionally through the pass) and runs it `repeat`
+// times. Returns false if it does not compile or fails at run time.
+bool measure(const std::string& source, bool optimize, int repeat, double& seconds, std::string& output,
+             InductionOptimizer::Result& changes) {
+    ErrorHandler::reset();
+    Scanner scanner(source);
+    Parser parser(scanner.scanTokens());
+    std::vector<std::unique_ptr<Statement>> ast = parser.parse();
+    SemanticAnalyzer analyzer;
+    analyzer.analyze(ast);
+    if (ErrorHandler::hadError) {
+        ErrorHandler::flush();
+        return false;
+    }
+    if (optimize) changes = InductionOptimizer().run(ast);
+
+    seconds = 1e30;
+    for (int run = 0; run < repeat; run++) {
+        std::ostringstream out;
+        Interpreter interpreter(Interpreter::Limits(), out);
+        auto start = std::chrono::steady_clock::now();
+        try {
+            interpreter.run(ast);
+        } catch (std::exception& error) {
+            std::cerr << error.what() << std::endl;
+            return false;
+        }
+        seconds = std::min(seconds, secondsSince(start));
+        output = out.str();
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    int mismatches = 0;
+    std::cout << "=== Loop kernel benchmark (n = " << options.size << ", best of " << options.repeat << ") ===" << std::endl;
+    std::cout << "  " << std::left << std::setw(11) << "kernel" << std::right << std::setw(12) << "plain" << std::setw(12)
+              << "induction" << std::setw(9) << "speedup" << "   reduced/hoisted/unrolled" << std::endl;
+    for (const Kernel& kernel : kernels()) {
+        bool wanted = options.names.empty();
+        for (const auto& name : options.names) wanted = wanted || name == kernel.name;
+        if (!wanted) continue;
+
+        std::string source = kernel.source;
+        for (size_t at = source.find('N'); at != std::string::npos; at = source.find('N', at)) {
+            source.replace(at, 1, std::to_string(options.size));
+        }
+
+        double plain = 0.0, optimized = 0.0;
+        std::string plainOutput, optimizedOutput;
+        InductionOptimizer::Result changes;
+        if (!measure(source, false, options.repeat, plain, plainOutput, changes) ||
+            !measure(source, true, options.repeat, optimized, optimizedOutput, changes)) {
+            std::cerr << "Kernel " << kernel.name << " failed." << std::endl;
+            return 2;
+        }
+
+        std::cout << "  " << std::left << std::setw(11) << kernel.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << plain * 1000.0 << " ms" << std::setw(9) << optimized * 1000.0 << " ms"
+                  << std::setw(8) << plain / optimized << "x   " << changes.reduced << "/" << changes.hoisted << "/"
+                  << changes.unrolled << "   (" << kernel.what << ")" << std::endl;
+        if (plainOutput != optimizedOutput) {
+            mismatches++;
+            std::cout << "  MISMATCH " << kernel.name << ": " << plainOutput << " vs " << optimizedOutput << std::endl;
+        }
+    }
+    return mismatches > 0 ? 1 : 0;
+}
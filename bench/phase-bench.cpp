@@ -0,0 +1,321 @@
+// Per-phase scaling benchmark for the front end.
+//
+// Generates programs of several shapes and sizes, times the Scanner, Parser
+// and SemanticAnalyzer separately (best of --repeat runs) and reports
+// throughput. With --baseline, every phase that got slower than the stored
+// result by more than --tolerance is flagged and the exit code is 1.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 bench/phase-bench.cpp src/compiler/*.cpp src/runtime/*.cpp -o phase-bench
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "../src/compiler/scanner.h"
+#include "../src/compiler/parser.h"
+#include "../src/compiler/semantic-analyzer.h"
+#include "../src/util/error-handler.h"
+#include "../src/util/stats.h"
+#include "program-generator.h"
+
+namespace {
+
+struct BenchOptions {
+    uint64_t seed = 42;
+    std::vector<size_t> sizes = {1 << 10, 64 << 10, 1 << 20, 8 << 20};
+    std::vector<std::string> shapes = ProgramGenerator::shapeNames();
+    int repeat = 3;
+    double tolerance = 0.20;       // Allowed slowdown before a phase is flagged
+    double noiseFloor = 0.001;     // Phases faster than this (seconds) are never flagged
+    std::string jsonPath;
+    std::string baselinePath;
+    std::string emitDir;
+    bool lazy = false;             // Parse function bodies only when a call reaches them
+};
+
+struct Result {
+    std::string shape;
+    size_t bytes = 0;       // Requested size; the key for baseline comparison
+    size_t textBytes = 0;   // Actual program size
+    std::string phase;
+    double seconds = 0.0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+};
+
+void printUsage() {
+    std::cout << "Usage: phase-bench [options]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --seed=N           Generator seed (default 42)" << std::endl;
+    std::cout << "  --sizes=LIST       Program sizes, e.g. 1K,64K,1M,1G (default 1K,64K,1M,8M)" << std::endl;
+    std::cout << "  --shapes=LIST      nesting,expressions,functions,scopes,comments,mixed (default all)" << std::endl;
+    std::cout << "  --repeat=N         Runs per measurement; the fastest is kept (default 3)" << std::endl;
+    std::cout << "  --json=FILE        Write the results as JSON" << std::endl;
+    std::cout << "  --baseline=FILE    Compare against a JSON file written by --json" << std::endl;
+    std::cout << "  --tolerance=F      Allowed slowdown vs. the baseline (default 0.20)" << std::endl;
+    std::cout << "  --emit=DIR         Also write each generated program to DIR" << std::endl;
+    std::cout << "  --lazy             Parse like nanoc --lazy (analyze includes the bodies it parses)" << std::endl;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// "64K" -> 65536. Returns 0 for malformed sizes.
+size_t parseSize(const std::string& text) {
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    std::string suffix(end);
+    if (suffix == "" || suffix == "B") return value;
+    if (suffix == "K" || suffix == "KB") return value << 10;
+    if (suffix == "M" || suffix == "MB") return value << 20;
+    if (suffix == "G" || suffix == "GB") return value << 30;
+    return 0;
+}
+
+std::string formatSize(size_t bytes) {
+    if (bytes >= (1u << 30) && bytes % (1u << 30) == 0) return std::to_string(bytes >> 30) + "G";
+    if (bytes >= (1u << 20) && bytes % (1u << 20) == 0) return std::to_string(bytes >> 20) + "M";
+    if (bytes >= (1u << 10) && bytes % (1u << 10) == 0) return std::to_string(bytes >> 10) + "K";
+    return std::to_string(bytes);
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "--sizes") {
+            options.sizes.clear();
+            for (const auto& item : splitList(value)) {
+                size_t size = parseSize(item);
+                if (size == 0) {
+                    std::cerr << "Invalid size: " << item << std::endl;
+                    return false;
+                }
+                options.sizes.push_back(size);
+            }
+        } else if (key == "--shapes") {
+            options.shapes = splitList(value);
+            for (const auto& shape : options.shapes) {
+                ProgramGenerator::Shape unused;
+                if (!ProgramGenerator::shapeFromName(shape, unused)) {
+                    std::cerr << "Unknown shape: " << shape << std::endl;
+                    return false;
+                }
+            }
+        } else if (key == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--json") {
+            options.jsonPath = value;
+        } else if (key == "--baseline") {
+            options.baselinePath = value;
+        } else if (key == "--tolerance") {
+            options.tolerance = std::atof(value.c_str());
+        } else if (key == "--emit") {
+            options.emitDir = value;
+        } else if (key == "--lazy") {
+            options.lazy = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Times the three front-end phases on one program. Returns false if the
+// program did not compile (a generator bug).
+bool measure(const std::string& source, int repeat, bool lazy, Result& scan, Result& parse, Result& analyze) {
+    scan.seconds = parse.seconds = analyze.seconds = 1e30;
+    for (int run = 0; run < repeat; run++) {
+        ErrorHandler::reset();
+
+        auto start = std::chrono::steady_clock::now();
+        Scanner scanner(source);
+        std::vector<Token> tokens = scanner.scanTokens();
+        scan.seconds = std::min(scan.seconds, secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        Parser parser(tokens, lazy);
+        std::vector<std::unique_ptr<Statement>> ast = parser.parse();
+        parse.seconds = std::min(parse.seconds, secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        SemanticAnalyzer analyzer;
+        analyzer.analyze(ast);
+        analyze.seconds = std::min(analyze.seconds, secondsSince(start));
+
+        if (ErrorHandler::hadError) {
+            ErrorHandler::flush();
+            return false;
+        }
+
+        ASTNodeCounter counter;
+        counter.walk(ast);
+        scan.tokens = parse.tokens = analyze.tokens = tokens.size();
+        parse.nodes = analyze.nodes = (size_t)counter.total;
+    }
+    return true;
+}
+
+void writeJson(const std::string& path, const BenchOptions& options, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    out << "{\n  \"seed\": " << options.seed << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"shape\": \"" << r.shape << "\", \"bytes\": " << r.bytes << ", \"phase\": \"" << r.phase
+            << "\", \"seconds\": " << std::setprecision(9) << r.seconds << ", \"tokens\": " << r.tokens
+            << ", \"nodes\": " << r.nodes << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads the files written by writeJson: the flat objects inside "results",
+// as key -> raw value text.
+std::vector<std::map<std::string, std::string>> readJson(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    std::vector<std::map<std::string, std::string>> objects;
+    size_t pos = text.find("\"results\"");
+    if (pos == std::string::npos) return objects;
+
+    while ((pos = text.find('{', pos)) != std::string::npos) {
+        size_t end = text.find('}', pos);
+        if (end == std::string::npos) break;
+        std::map<std::string, std::string> object;
+        size_t cursor = pos + 1;
+        while (true) {
+            size_t keyStart = text.find('"', cursor);
+            if (keyStart == std::string::npos || keyStart > end) break;
+            size_t keyEnd = text.find('"', keyStart + 1);
+            size_t colon = text.find(':', keyEnd);
+            size_t valueEnd = text.find_first_of(",}", colon);
+            std::string value = text.substr(colon + 1, valueEnd - colon - 1);
+            value.erase(0, value.find_first_not_of(" \""));
+            value.erase(value.find_last_not_of(" \"") + 1);
+            object[text.substr(keyStart + 1, keyEnd - keyStart - 1)] = value;
+            cursor = valueEnd + 1;
+        }
+        objects.push_back(object);
+        pos = end + 1;
+    }
+    return objects;
+}
+
+std::string resultKey(const std::string& shape, const std::string& bytes, const std::string& phase) {
+    return shape + "/" + bytes + "/" + phase;
+}
+
+// Returns the number of regressions
+int compareWithBaseline(const BenchOptions& options, const std::vector<Result>& results) {
+    std::map<std::string, double> baseline;
+    for (const auto& object : readJson(options.baselinePath)) {
+        if (!object.count("shape") || !object.count("bytes") || !object.count("phase") || !object.count("seconds")) continue;
+        baseline[resultKey(object.at("shape"), object.at("bytes"), object.at("phase"))] = std::atof(object.at("seconds").c_str());
+    }
+    if (baseline.empty()) {
+        std::cerr << "No results found in baseline " << options.baselinePath << std::endl;
+        return 0;
+    }
+
+    int regressions = 0;
+    int compared = 0;
+    std::cout << std::endl << "=== Baseline comparison (" << options.baselinePath << ") ===" << std::endl;
+    for (const Result& r : results) {
+        auto found = baseline.find(resultKey(r.shape, std::to_string(r.bytes), r.phase));
+        if (found == baseline.end()) continue;
+        compared++;
+        double ratio = found->second > 0 ? r.seconds / found->second : 1.0;
+        bool slower = ratio > 1.0 + options.tolerance;
+        bool measurable = std::max(r.seconds, found->second) >= options.noiseFloor;
+        if (slower && measurable) {
+            regressions++;
+            std::cout << "  REGRESSION " << std::left << std::setw(12) << r.shape << std::setw(6) << formatSize(r.bytes)
+                      << std::setw(9) << r.phase << std::right << std::fixed << std::setprecision(3)
+                      << found->second * 1000.0 << " ms -> " << r.seconds * 1000.0 << " ms  (x"
+                      << std::setprecision(2) << ratio << ")" << std::endl;
+        }
+    }
+    std::cout << "  " << compared << " measurement(s) compared, " << regressions << " regression(s)" << std::endl;
+    return regressions;
+}
+
+void printResult(const Result& r) {
+    double mb = r.textBytes / (1024.0 * 1024.0);
+    std::cout << "  " << std::left << std::setw(12) << r.shape << std::setw(6) << formatSize(r.bytes)
+              << std::setw(9) << r.phase << std::right << std::fixed << std::setprecision(3)
+              << std::setw(11) << r.seconds * 1000.0 << " ms"
+              << std::setw(10) << std::setprecision(1) << mb / r.seconds << " MB/s"
+              << std::setw(12) << std::setprecision(0) << r.tokens / r.seconds << " tok/s";
+    if (r.nodes > 0) std::cout << std::setw(12) << r.nodes / r.seconds << " nodes/s";
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Result> results;
+    std::cout << "=== Front-end phase benchmark (seed " << options.seed << ", best of " << options.repeat << ") ===" << std::endl;
+    for (const auto& shapeName : options.shapes) {
+        ProgramGenerator::Shape shape = ProgramGenerator::Shape::MIXED;
+        ProgramGenerator::shapeFromName(shapeName, shape);
+        for (size_t size : options.sizes) {
+            std::string source = ProgramGenerator(options.seed).generate(shape, size);
+            if (!options.emitDir.empty()) {
+                std::ofstream(options.emitDir + "/" + shapeName + "-" + formatSize(size) + ".ns") << source;
+            }
+
+            Result scan, parse, analyze;
+            scan.phase = "scan";
+            parse.phase = "parse";
+            analyze.phase = "analyze";
+            for (Result* r : {&scan, &parse, &analyze}) {
+                r->shape = shapeName;
+                r->bytes = size;
+                r->textBytes = source.size();
+            }
+            if (!measure(source, options.repeat, options.lazy, scan, parse, analyze)) {
+                std::cerr << "Generated " << shapeName << " program of " << formatSize(size) << " does not compile." << std::endl;
+                return 2;
+            }
+            for (Result* r : {&scan, &parse, &analyze}) {
+                printResult(*r);
+                results.push_back(*r);
+            }
+        }
+    }
+
+    if (!options.jsonPath.empty()) writeJson(options.jsonPath, options, results);
+    if (!options.baselinePath.empty() && compareWithBaseline(options, results) > 0) return 1;
+    return 0;
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Seeded generator for valid NanoScript programs of a given size.
+//
+// Output depends only on (shape, seed, target size): the random source is
+// splitmix64 and ranges are reduced by hand, so the same program comes out
+// on every platform and standard library.
+//
+// A program is a sequence of `func int fN(int a, int b)` units that may
+// call earlier ones, some followed by a top-level variable initialized by
+// a call. The shape decides what a unit's body looks like.
+class ProgramGenerator {
+public:
+    enum class Shape { NESTING, EXPRESSIONS, FUNCTIONS, SCOPES, COMMENTS, MIXED };
+
+    static const std::vector<std::string>& shapeNames() {
+        static const std::vector<std::string> names = {"nesting", "expressions", "functions", "scopes", "comments", "mixed"};
+        return names;
+    }
+
+    // Returns false if `name` is not a known shape
+    static bool shapeFromName(const std::string& name, Shape& outShape) {
+        const auto& names = shapeNames();
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) {
+                outShape = (Shape)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    uint64_t state;
+    std::string out;
+    int functionCount = 0;
+    int uniqueCounter = 0;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [lo, hi]
+    int range(int lo, int hi) { return lo + (int)(next() % (uint64_t)(hi - lo + 1)); }
+    bool chance(int percent) { return range(1, 100) <= percent; }
+
+    std::string fresh(const char* prefix) { return prefix + std::to_string(uniqueCounter++); }
+
+    void indent(int depth) { out.append(depth * 4, ' '); }
+
+    void line(int depth, const std::string& text) {
+        indent(depth);
+        out += text;
+        out += '\n';
+    }
+
+    // An int-typed expression of about `terms` operands over `vars`
+    std::string intExpr(const std::vector<std::string>& vars, int terms, int parenDepth = 0) {
+        static const char* ops[] = {" + ", " - ", " * "};
+        std::string expr;
+        for (int i = 0; i < terms; i++) {
+            if (i > 0) expr += ops[range(0, 2)];
+            int pick = range(0, 9);
+            if (pick < 5 && !vars.empty()) {
+                expr += vars[range(0, (int)vars.size() - 1)];
+            } else if (pick < 7 && parenDepth < 3 && terms - i > 2) {
+                int inner = range(2, 4);
+                expr += "(" + intExpr(vars, inner, parenDepth + 1) + ")";
+                i += inner - 1;
+            } else if (pick == 7 && functionCount > 0 && vars.size() >= 2) {
+                expr += callExpr(vars);
+            } else {
+                expr += std::to_string(range(0, 999));
+            }
+        }
+        return expr;
+    }
+
+    std::string boolExpr(const std::vector<std::string>& vars) {
+        static const char* cmps[] = {" < ", " <= ", " > ", " >= ", " == ", " != "};
+        std::string expr = intExpr(vars, range(1, 3)) + cmps[range(0, 5)] + intExpr(vars, range(1, 3));
+        if (chance(30)) expr = "(" + expr + ") and !(" + intExpr(vars, 1) + " == " + intExpr(vars, 1) + ")";
+        if (chance(20)) expr = "(" + expr + ") or false";
+        return expr;
+    }
+
+    std::string callExpr(const std::vector<std::string>& vars) {
+        int callee = range(std::max(0, functionCount - 8), functionCount - 1);
+        return "f" + std::to_string(callee) + "(" + vars[range(0, (int)vars.size() - 1)] + ", " +
+               std::to_string(range(0, 99)) + ")";
+    }
+
+    void comment(int depth, int words) {
+        static const char* vocabulary[] = {"compute", "the", "running", "total", "for", "each", "row", "in",
+                                           "table", "then", "fold", "into", "accumulator", "before", "return",
+                                           "note:", "bounds", "are", "checked", "by", "caller", "TODO", "tune"};
+        indent(depth);
+        out += "//";
+        for (int i = 0; i < words; i++) {
+            out += ' ';
+            out += vocabulary[range(0, 22)];
+        }
+        out += '\n';
+    }
+
+    // --- Function bodies, one per shape ---
+
+    void nestingBody(std::vector<std::string>& vars) {
+        int levels = range(8, 40);
+        std::vector<std::string> scope = vars;
+        for (int depth = 1; depth <= levels; depth++) {
+            std::string v = fresh("n");
+            if (depth % 2 == 1) {
+                line(depth, "if (" + boolExpr(scope) + ") {");
+                line(depth + 1, "var int " + v + " = " + intExpr(scope, 2) + ";");
+            } else {
+                line(depth, "var int " + v + " = " + std::to_string(range(1, 9)) + ";");
+                line(depth, "while (" + v + " > 0) {");
+                line(depth + 1, v + " = " + v + " - 1;");
+            }
+            scope.push_back(v);
+        }
+        line(levels + 1, "a = " + intExpr(scope, 3) + ";");
+        for (int depth = levels; depth >= 1; depth--) line(depth, "}");
+    }
+
+    void expressionsBody(std::vector<std::string>& vars) {
+        int count = range(2, 5);
+        for (int i = 0; i < count; i++) {
+            std::string v = fresh("e");
+            line(1, "var int " + v + " = " + intExpr(vars, range(20, 120)) + ";");
+            vars.push_back(v);
+        }
+        line(1, "var bool " + fresh("c") + " = " + boolExpr(vars) + ";");
+        std::string f = fresh("x");
+        line(1, "var float " + f + " = " + vars[range(0, (int)vars.size() - 1)] + " * 1.5 + 0.25;");
+    }
+
+    void functionsBody(std::vector<std::string>& vars) {
+        // Tiny bodies so that signatures dominate
+        if (functionCount > 0 && chance(70)) line(1, "a = " + callExpr(vars) + ";");
+    }
+
+    void scopesBody(std::vector<std::string>& vars) {
+        int width = range(50, 400);
+        line(1, "{");
+        for (int i = 0; i < width; i++) {
+            std::string v = fresh("w");
+            line(2, "var int " + v + " = " + intExpr(vars, range(1, 3)) + ";");
+            vars.push_back(v);
+        }
+        line(2, "a = " + intExpr(vars, 4) + ";");
+        line(1, "}");
+        vars.resize(2); // The block's names are gone
+    }
+
+    void commentsBody(std::vector<std::string>& vars) {
+        int statements = range(2, 6);
+        for (int i = 0; i < statements; i++) {
+            int comments = range(2, 8);
+            for (int c = 0; c < comments; c++) comment(1, range(4, 16));
+            line(1, "b = " + intExpr(vars, 2) + "; // " + std::to_string(i));
+        }
+    }
+
+    void unit(Shape shape) {
+        if (shape == Shape::MIXED) shape = (Shape)range(0, (int)Shape::MIXED - 1);
+
+        std::string name = "f" + std::to_string(functionCount);
+        if (shape == Shape::COMMENTS) comment(0, range(6, 20));
+        line(0, "func int " + name + "(int a, int b) {");
+        std::vector<std::string> vars = {"a", "b"};
+        switch (shape) {
+            case Shape::NESTING: nestingBody(vars); break;
+            case Shape::EXPRESSIONS: expressionsBody(vars); break;
+            case Shape::FUNCTIONS: functionsBody(vars); break;
+            case Shape::SCOPES: scopesBody(vars); break;
+            default: commentsBody(vars); break;
+        }
+        line(1, "return " + intExpr(vars, range(1, 4)) + ";");
+        line(0, "}");
+        functionCount++;
+
+        if (chance(25)) {
+            std::vector<std::string> none = {"1", "2"};
+            line(0, "var int g" + std::to_string(functionCount) + " = " + callExpr(none) + ";");
+        }
+    }
+
+public:
+    explicit ProgramGenerator(uint64_t seed) : state(seed) {}
+
+    // Generates units until the text reaches `targetBytes` (it may overshoot
+    // by one unit).
+    std::string generate(Shape shape, size_t targetBytes) {
+        out.clear();
+        out.reserve(targetBytes + 4096);
+        functionCount = 0;
+        uniqueCounter = 0;
+        line(0, "// Generated NanoScript program");
+        while (out.size() < targetBytes) unit(shape);
+        line(0, "print(f" + std::to_string(functionCount - 1) + "(1, 2));");
+        return std::move(out);
+    }
+};
@@ -0,0 +1,143 @@
+#include "ast-cloner.h"
+
+std::unique_ptr<Expression> ASTCloner::clone(Expression* expr) {
+    if (!expr) return nullptr;
+    expr->accept(this);
+    // A substituted parameter keeps the parameter's type, which is its argument's
+    lastExpr->type = expr->type;
+    lastExpr->promoted = expr->promoted;
+    return std::move(lastExpr);
+}
+
+std::unique_ptr<Statement> ASTCloner::clone(Statement* stmt) {
+    if (!stmt) return nullptr;
+    stmt->accept(this);
+    return std::move(lastStmt);
+}
+
+std::vector<std::unique_ptr<Statement>> ASTCloner::clone(const std::vector<std::unique_ptr<Statement>>& statements) {
+    std::vector<std::unique_ptr<Statement>> result;
+    for (const auto& stmt : statements) {
+        result.push_back(clone(stmt.get()));
+    }
+    return result;
+}
+
+// --- Expressions ---
+
+void ASTCloner::visitBinaryExpr(BinaryExpr* expr) {
+    auto left = clone(expr->left.get());
+    auto right = clone(expr->right.get());
+    lastExpr = std::make_unique<BinaryExpr>(std::move(left), expr->op, std::move(right));
+}
+
+void ASTCloner::visitGroupingExpr(GroupingExpr* expr) {
+    lastExpr = std::make_unique<GroupingExpr>(clone(expr->expression.get()));
+}
+
+void ASTCloner::visitLiteralExpr(LiteralExpr* expr) {
+    lastExpr = std::make_unique<LiteralExpr>(expr->value, expr->typeHint);
+}
+
+void ASTCloner::visitUnaryExpr(UnaryExpr* expr) {
+    lastExpr = std::make_unique<UnaryExpr>(expr->op, clone(expr->right.get()));
+}
+
+void ASTCloner::visitVariableExpr(VariableExpr* expr) {
+    auto found = substitutions.find(expr->name.lexeme);
+    if (found != substitutions.end()) {
+        // The substitute comes from another context; clone it without substitutions
+        std::map<std::string, Expression*> saved;
+        saved.swap(substitutions);
+        lastExpr = clone(found->second);
+        saved.swap(substitutions);
+        return;
+    }
+    lastExpr = std::make_unique<VariableExpr>(expr->name);
+}
+
+void ASTCloner::visitAssignExpr(AssignExpr* expr) {
+    lastExpr = std::make_unique<AssignExpr>(expr->name, clone(expr->value.get()));
+}
+
+void ASTCloner::visitCallExpr(CallExpr* expr) {
+    auto callee = clone(expr->callee.get());
+    std::vector<std::unique_ptr<Expression>> args;
+    for (const auto& arg : expr->arguments) {
+        args.push_back(clone(arg.get()));
+    }
+    auto call = std::make_unique<CallExpr>(std::move(callee), expr->paren, std::move(args));
+    call->resolved = expr->resolved;
+    call->builtin = expr->builtin;
+    lastExpr = std::move(call);
+}
+
+void ASTCloner::visitArrayExpr(ArrayExpr* expr) {
+    std::vector<std::unique_ptr<Expression>> elements;
+    for (const auto& element : expr->elements) {
+        elements.push_back(clone(element.get()));
+    }
+    lastExpr = std::make_unique<ArrayExpr>(expr->bracket, expr->elementType, std::move(elements), clone(expr->length.get()));
+}
+
+void ASTCloner::visitIndexExpr(IndexExpr* expr) {
+    auto array = clone(expr->array.get());
+    lastExpr = std::make_unique<IndexExpr>(std::move(array), expr->bracket, clone(expr->index.get()));
+}
+
+void ASTCloner::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    auto array = clone(expr->array.get());
+    auto index = clone(expr->index.get());
+    auto value = clone(expr->value.get());
+    lastExpr = std::make_unique<IndexAssignExpr>(std::move(array), expr->bracket, std::move(index), std::move(value));
+}
+
+// --- Statements ---
+
+void ASTCloner::visitBlockStmt(BlockStmt* stmt) {
+    lastStmt = std::make_unique<BlockStmt>(clone(stmt->statements));
+}
+
+void ASTCloner::visitExpressionStmt(ExpressionStmt* stmt) {
+    lastStmt = std::make_unique<ExpressionStmt>(clone(stmt->expression.get()));
+}
+
+void ASTCloner::visitFunctionStmt(FunctionStmt* stmt) {
+    lastStmt = std::make_unique<FunctionStmt>(stmt->name, stmt->returnType, stmt->params, stmt->paramTypes,
+                                              clone(stmt->body));
+}
+
+void ASTCloner::visitIfStmt(IfStmt* stmt) {
+    auto condition = clone(stmt->condition.get());
+    auto thenBranch = clone(stmt->thenBranch.get());
+    auto elseBranch = clone(stmt->elseBranch.get());
+    lastStmt = std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch), std::move(elseBranch),
+                                       stmt->line, stmt->column);
+}
+
+void ASTCloner::visitPrintStmt(PrintStmt* stmt) {
+    lastStmt = std::make_unique<PrintStmt>(clone(stmt->expression.get()));
+}
+
+void ASTCloner::visitReturnStmt(ReturnStmt* stmt) {
+    lastStmt = std::make_unique<ReturnStmt>(stmt->keyword, clone(stmt->value.get()));
+}
+
+void ASTCloner::visitVarStmt(VarStmt* stmt) {
+    lastStmt = std::make_unique<VarStmt>(stmt->name, stmt->type, clone(stmt->initializer.get()));
+}
+
+void ASTCloner::visitWhileStmt(WhileStmt* stmt) {
+    auto condition = clone(stmt->condition.get());
+    auto body = clone(stmt->body.get());
+    lastStmt = std::make_unique<WhileStmt>(std::move(condition), std::move(body), stmt->line, stmt->column);
+}
+
+void ASTCloner::visitParallelForStmt(ParallelForStmt* stmt) {
+    auto start = clone(stmt->start.get());
+    auto end = clone(stmt->end.get());
+    auto body = clone(stmt->body.get());
+    auto copy = std::make_unique<ParallelForStmt>(stmt->keyword, stmt->name, std::move(start), std::move(end), std::move(body));
+    copy->writes = stmt->writes;
+    lastStmt = std::move(copy);
+}
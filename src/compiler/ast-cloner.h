@@ -0,0 +1,41 @@
+#pragma once
+#include <map>
+#include "../data/AST.h"
+
+// Deep copies AST subtrees, keeping annotations such as CallExpr::resolved
+// and expression types.
+// Variables listed in `substitutions` are replaced by a copy of the mapped
+// expression, which is how the inliner binds arguments to parameters.
+class ASTCloner : public ASTVisitor {
+private:
+    std::unique_ptr<Expression> lastExpr;
+    std::unique_ptr<Statement> lastStmt;
+
+public:
+    std::map<std::string, Expression*> substitutions;
+
+    std::unique_ptr<Expression> clone(Expression* expr);
+    std::unique_ptr<Statement> clone(Statement* stmt);
+    std::vector<std::unique_ptr<Statement>> clone(const std::vector<std::unique_ptr<Statement>>& statements);
+
+    void visitBinaryExpr(BinaryExpr* expr) override;
+    void visitGroupingExpr(GroupingExpr* expr) override;
+    void visitLiteralExpr(LiteralExpr* expr) override;
+    void visitUnaryExpr(UnaryExpr* expr) override;
+    void visitVariableExpr(VariableExpr* expr) override;
+    void visitAssignExpr(AssignExpr* expr) override;
+    void visitCallExpr(CallExpr* expr) override;
+    void visitArrayExpr(ArrayExpr* expr) override;
+    void visitIndexExpr(IndexExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitExpressionStmt(ExpressionStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitIfStmt(IfStmt* stmt) override;
+    void visitPrintStmt(PrintStmt* stmt) override;
+    void visitReturnStmt(ReturnStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+    void visitWhileStmt(WhileStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+};
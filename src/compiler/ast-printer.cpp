@@ -0,0 +1,149 @@
+#include "ast-printer.h"
+#include "../data/module-interface.h"
+
+void ASTPrinter::print(const std::vector<std::unique_ptr<Statement>>& program) {
+    children(program);
+}
+
+void ASTPrinter::line(const std::string& text) {
+    out << std::string(depth * 2, ' ') << text << "\n";
+}
+
+void ASTPrinter::line(Expression* expr, const std::string& text) {
+    std::string typed = text + " : " + ModuleInterface::typeName(expr->type);
+    if (expr->promoted) typed += " -> float";
+    line(typed);
+}
+
+void ASTPrinter::child(ASTNode* node) {
+    if (!node) return;
+    depth++;
+    node->accept(this);
+    depth--;
+}
+
+void ASTPrinter::children(const std::vector<std::unique_ptr<Statement>>& statements) {
+    for (const auto& stmt : statements) {
+        if (stmt) stmt->accept(this);
+    }
+}
+
+// --- Expressions ---
+
+void ASTPrinter::visitBinaryExpr(BinaryExpr* expr) {
+    line(expr, "Binary " + expr->op.lexeme);
+    child(expr->left.get());
+    child(expr->right.get());
+}
+
+void ASTPrinter::visitGroupingExpr(GroupingExpr* expr) {
+    line(expr, "Grouping");
+    child(expr->expression.get());
+}
+
+void ASTPrinter::visitLiteralExpr(LiteralExpr* expr) {
+    line(expr, "Literal " + (expr->typeHint == TokenType::TYPE_STRING ? "\"" + expr->value + "\"" : expr->value));
+}
+
+void ASTPrinter::visitUnaryExpr(UnaryExpr* expr) {
+    line(expr, "Unary " + expr->op.lexeme);
+    child(expr->right.get());
+}
+
+void ASTPrinter::visitVariableExpr(VariableExpr* expr) {
+    line(expr, "Variable " + expr->name.lexeme);
+}
+
+void ASTPrinter::visitAssignExpr(AssignExpr* expr) {
+    line(expr, "Assign " + expr->name.lexeme);
+    child(expr->value.get());
+}
+
+void ASTPrinter::visitCallExpr(CallExpr* expr) {
+    VariableExpr* callee = dynamic_cast<VariableExpr*>(expr->callee.get());
+    line(expr, "Call " + (callee ? callee->name.lexeme : std::string("?")));
+    for (const auto& arg : expr->arguments) child(arg.get());
+}
+
+void ASTPrinter::visitArrayExpr(ArrayExpr* expr) {
+    line(expr, expr->length ? "NewArray" : "Array");
+    child(expr->length.get());
+    for (const auto& element : expr->elements) child(element.get());
+}
+
+void ASTPrinter::visitIndexExpr(IndexExpr* expr) {
+    line(expr, "Index");
+    child(expr->array.get());
+    child(expr->index.get());
+}
+
+void ASTPrinter::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    line(expr, "IndexAssign");
+    child(expr->array.get());
+    child(expr->index.get());
+    child(expr->value.get());
+}
+
+// --- Statements ---
+
+void ASTPrinter::visitBlockStmt(BlockStmt* stmt) {
+    line("Block");
+    depth++;
+    children(stmt->statements);
+    depth--;
+}
+
+void ASTPrinter::visitExpressionStmt(ExpressionStmt* stmt) {
+    line("Expression");
+    child(stmt->expression.get());
+}
+
+void ASTPrinter::visitFunctionStmt(FunctionStmt* stmt) {
+    std::string signature = "Function " + stmt->returnType.lexeme + " " + stmt->name.lexeme + "(";
+    for (size_t i = 0; i < stmt->params.size(); i++) {
+        if (i > 0) signature += ", ";
+        signature += stmt->paramTypes[i].lexeme + " " + stmt->params[i].lexeme;
+    }
+    line(signature + ")");
+    depth++;
+    children(stmt->body);
+    depth--;
+}
+
+void ASTPrinter::visitIfStmt(IfStmt* stmt) {
+    line("If");
+    child(stmt->condition.get());
+    child(stmt->thenBranch.get());
+    if (stmt->elseBranch) {
+        line("Else");
+        child(stmt->elseBranch.get());
+    }
+}
+
+void ASTPrinter::visitPrintStmt(PrintStmt* stmt) {
+    line("Print");
+    child(stmt->expression.get());
+}
+
+void ASTPrinter::visitReturnStmt(ReturnStmt* stmt) {
+    line("Return");
+    child(stmt->value.get());
+}
+
+void ASTPrinter::visitVarStmt(VarStmt* stmt) {
+    line("Var " + stmt->type.lexeme + " " + stmt->name.lexeme);
+    child(stmt->initializer.get());
+}
+
+void ASTPrinter::visitWhileStmt(WhileStmt* stmt) {
+    line("While");
+    child(stmt->condition.get());
+    child(stmt->body.get());
+}
+
+void ASTPrinter::visitParallelForStmt(ParallelForStmt* stmt) {
+    line("ParallelFor " + stmt->name.lexeme);
+    child(stmt->start.get());
+    child(stmt->end.get());
+    child(stmt->body.get());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../data/AST.h"
+
+// Textual dump of the analyzed AST, used by --dump-typed-ast. Each
+// expression is shown with the type SemanticAnalyzer gave it, and with
+// `-> float` when it is widened from int where it is used.
+class ASTPrinter : public ASTVisitor {
+private:
+    std::ostream& out;
+    int depth = 0;
+
+    void line(const std::string& text);
+    void line(Expression* expr, const std::string& text);
+    void child(ASTNode* node);
+    void children(const std::vector<std::unique_ptr<Statement>>& statements);
+
+public:
+    ASTPrinter(std::ostream& out) : out(out) {}
+
+    void print(const std::vector<std::unique_ptr<Statement>>& program);
+
+    void visitBinaryExpr(BinaryExpr* expr) override;
+    void visitGroupingExpr(GroupingExpr* expr) override;
+    void visitLiteralExpr(LiteralExpr* expr) override;
+    void visitUnaryExpr(UnaryExpr* expr) override;
+    void visitVariableExpr(VariableExpr* expr) override;
+    void visitAssignExpr(AssignExpr* expr) override;
+    void visitCallExpr(CallExpr* expr) override;
+    void visitArrayExpr(ArrayExpr* expr) override;
+    void visitIndexExpr(IndexExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitExpressionStmt(ExpressionStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitIfStmt(IfStmt* stmt) override;
+    void visitPrintStmt(PrintStmt* stmt) override;
+    void visitReturnStmt(ReturnStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+    void visitWhileStmt(WhileStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+};
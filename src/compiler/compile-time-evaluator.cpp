@@ -0,0 +1,103 @@
+#include "compile-time-evaluator.h"
+#include <cmath>
+
+namespace {
+
+Interpreter::Limits evaluationLimits() {
+    Interpreter::Limits limits;
+    limits.maxSteps = CompileTimeEvaluator::kStepBudget;
+    limits.maxDepth = CompileTimeEvaluator::kDepthBudget;
+    return limits;
+}
+
+} // namespace
+
+CompileTimeEvaluator::CompileTimeEvaluator() : interpreter(evaluationLimits(), discardedOutput) {}
+
+int CompileTimeEvaluator::run(std::vector<std::unique_ptr<Statement>>& program) {
+    folded = 0;
+    knownGlobals.clear();
+    scopes.clear();
+    purity.analyze(program);
+    rewrite(program);
+    return folded;
+}
+
+bool CompileTimeEvaluator::isConstant(Expression* expr) {
+    if (dynamic_cast<LiteralExpr*>(expr)) return true;
+    if (GroupingExpr* group = dynamic_cast<GroupingExpr*>(expr)) return isConstant(group->expression.get());
+    if (UnaryExpr* unary = dynamic_cast<UnaryExpr*>(expr)) return isConstant(unary->right.get());
+    if (BinaryExpr* binary = dynamic_cast<BinaryExpr*>(expr)) {
+        return isConstant(binary->left.get()) && isConstant(binary->right.get());
+    }
+    if (VariableExpr* var = dynamic_cast<VariableExpr*>(expr)) {
+        for (const auto& scope : scopes) {
+            if (scope.count(var->name.lexeme)) return false;
+        }
+        return knownGlobals.count(var->name.lexeme) > 0;
+    }
+    return false;
+}
+
+void CompileTimeEvaluator::rewrite(std::unique_ptr<Expression>& slot) {
+    ASTRewriter::rewrite(slot); // Fold the arguments first
+
+    CallExpr* call = dynamic_cast<CallExpr*>(slot.get());
+    if (!call || !call->resolved || !purity.isPure(call->resolved)) return;
+    for (const auto& arg : call->arguments) {
+        if (!isConstant(arg.get())) return;
+    }
+
+    Value result;
+    try {
+        interpreter.resetSteps();
+        result = interpreter.evaluateConstant(call);
+    } catch (RuntimeError&) {
+        return; // Out of budget or a run-time error: keep the call
+    }
+    if (result.type == TokenType::TYPE_FLOAT && !std::isfinite(result.f)) return;
+    if (isArrayType(result.type)) return; // No literal form that keeps reference semantics
+    if (result.str && result.str->length > kMaxFoldedString) return;
+
+    bool promoted = call->promoted;
+    slot = std::make_unique<LiteralExpr>(result.toLiteral(), result.type);
+    slot->promoted = promoted;
+    folded++;
+}
+
+void CompileTimeEvaluator::visitBlockStmt(BlockStmt* stmt) {
+    scopes.emplace_back();
+    ASTRewriter::visitBlockStmt(stmt);
+    scopes.pop_back();
+}
+
+void CompileTimeEvaluator::visitParallelForStmt(ParallelForStmt* stmt) {
+    rewrite(stmt->start);
+    rewrite(stmt->end);
+    scopes.emplace_back();
+    scopes.back().insert(stmt->name.lexeme);
+    rewrite(stmt->body);
+    scopes.pop_back();
+}
+
+void CompileTimeEvaluator::visitFunctionStmt(FunctionStmt* stmt) {
+    scopes.emplace_back();
+    for (const auto& param : stmt->params) scopes.back().insert(param.lexeme);
+    rewrite(stmt->body);
+    scopes.pop_back();
+}
+
+void CompileTimeEvaluator::visitVarStmt(VarStmt* stmt) {
+    ASTRewriter::visitVarStmt(stmt);
+    if (!scopes.empty()) {
+        scopes.back().insert(stmt->name.lexeme);
+        return;
+    }
+
+    // A top-level constant can feed later folds
+    LiteralExpr* literal = dynamic_cast<LiteralExpr*>(stmt->initializer.get());
+    if (literal && purity.isImmutableGlobal(stmt->name.lexeme)) {
+        interpreter.setGlobal(stmt->name.lexeme, literal->constant.convertTo(stmt->type.type));
+        knownGlobals.insert(stmt->name.lexeme);
+    }
+}
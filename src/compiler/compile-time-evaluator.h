@@ -0,0 +1,48 @@
+#pragma once
+#include <set>
+#include <sstream>
+#include <string>
+#include "../data/AST.h"
+#include "../runtime/interpreter.h"
+#include "purity-analyzer.h"
+
+// Replaces calls to pure functions whose arguments are constants with the
+// value they return, e.g. `var int fact_N = factorial(N);` -> `... = 120;`.
+//
+// Arguments count as constant when they are built from literals and
+// immutable globals whose initializer has already been folded. Each call is
+// evaluated by the interpreter under a step and recursion budget; a call
+// that runs out of budget, fails at run time (division by zero) or yields
+// a non-finite float is simply left in place.
+// Must run after semantic analysis (it relies on CallExpr::resolved).
+class CompileTimeEvaluator : public ASTRewriter {
+public:
+    static const long long kStepBudget = 1000000;
+    static const int kDepthBudget = 256;
+    // Longer string results stay calls rather than bloat the program's literal pool
+    static const size_t kMaxFoldedString = 1024;
+
+private:
+    PurityAnalyzer purity;
+    std::ostringstream discardedOutput; // Pure functions never print
+    Interpreter interpreter;
+    std::set<std::string> knownGlobals;             // Immutable globals with a folded value
+    std::vector<std::set<std::string>> scopes;      // Locals, to spot shadowed globals
+    int folded = 0;
+
+    bool isConstant(Expression* expr);
+
+public:
+    CompileTimeEvaluator();
+
+    // Returns the number of calls that were folded
+    int run(std::vector<std::unique_ptr<Statement>>& program);
+
+    void rewrite(std::unique_ptr<Expression>& slot) override;
+    using ASTRewriter::rewrite;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+};
@@ -0,0 +1,435 @@
+#include "induction-optimizer.h"
+#include <climits>
+#include <map>
+#include <set>
+#include "ast-cloner.h"
+
+namespace {
+
+Token synth(TokenType type, const std::string& lexeme, int line) {
+    return Token(type, lexeme, "", line);
+}
+
+// Expressions built here are typed the way the analyzer would have typed them
+template <typename T>
+std::unique_ptr<T> typed(std::unique_ptr<T> expr, TokenType type) {
+    expr->type = type;
+    return expr;
+}
+
+Expression* stripGrouping(Expression* expr) {
+    while (GroupingExpr* group = dynamic_cast<GroupingExpr*>(expr)) expr = group->expression.get();
+    return expr;
+}
+
+bool isIntLiteral(Expression* expr, long long& value) {
+    LiteralExpr* literal = dynamic_cast<LiteralExpr*>(stripGrouping(expr));
+    if (!literal || literal->typeHint != TokenType::TYPE_INT) return false;
+    value = literal->constant.i;
+    return true;
+}
+
+// What a loop writes and declares, how large it is, and whether it holds
+// anything that could write variables without an assignment in the loop
+class LoopScan : public ASTWalker {
+public:
+    const PurityAnalyzer& purity;
+    std::map<std::string, int> writes; // Assignments per variable name
+    std::set<std::string> declared;
+    int size = 0;
+    bool opaque = false;
+
+    explicit LoopScan(const PurityAnalyzer& purity) : purity(purity) {}
+
+    void visitBinaryExpr(BinaryExpr* expr) override { size++; ASTWalker::visitBinaryExpr(expr); }
+    void visitLiteralExpr(LiteralExpr*) override { size++; }
+    void visitUnaryExpr(UnaryExpr* expr) override { size++; ASTWalker::visitUnaryExpr(expr); }
+    void visitVariableExpr(VariableExpr*) override { size++; }
+    void visitAssignExpr(AssignExpr* expr) override {
+        size++;
+        writes[expr->name.lexeme]++;
+        ASTWalker::visitAssignExpr(expr);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        size++;
+        if (expr->resolved ? !purity.isPure(expr->resolved) : expr->builtin == Builtin::NONE) opaque = true;
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitArrayExpr(ArrayExpr* expr) override { size++; ASTWalker::visitArrayExpr(expr); }
+    void visitIndexExpr(IndexExpr* expr) override { size++; ASTWalker::visitIndexExpr(expr); }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override { size++; ASTWalker::visitIndexAssignExpr(expr); }
+
+    void visitExpressionStmt(ExpressionStmt* stmt) override { size++; ASTWalker::visitExpressionStmt(stmt); }
+    void visitFunctionStmt(FunctionStmt*) override { opaque = true; }
+    void visitIfStmt(IfStmt* stmt) override { size++; ASTWalker::visitIfStmt(stmt); }
+    void visitPrintStmt(PrintStmt* stmt) override { size++; ASTWalker::visitPrintStmt(stmt); }
+    void visitReturnStmt(ReturnStmt* stmt) override { size++; ASTWalker::visitReturnStmt(stmt); }
+    void visitVarStmt(VarStmt* stmt) override {
+        size++;
+        declared.insert(stmt->name.lexeme);
+        ASTWalker::visitVarStmt(stmt);
+    }
+    void visitWhileStmt(WhileStmt* stmt) override { size++; ASTWalker::visitWhileStmt(stmt); }
+    void visitParallelForStmt(ParallelForStmt*) override { opaque = true; }
+};
+
+// `i = i + step` (op PLUS) or `i = i - step` (op MINUS)
+struct InductionVariable {
+    std::string name;
+    size_t update; // Index of the update among the body's statements
+    TokenType op;
+    Expression* step;
+};
+
+class LoopFacts {
+public:
+    LoopScan scan;
+    std::vector<InductionVariable> variables;
+
+    explicit LoopFacts(const PurityAnalyzer& purity) : scan(purity) {}
+
+    bool invariant(Expression* expr) const {
+        expr = stripGrouping(expr);
+        if (dynamic_cast<LiteralExpr*>(expr)) return true;
+        if (VariableExpr* var = dynamic_cast<VariableExpr*>(expr)) {
+            return !scan.writes.count(var->name.lexeme) && !scan.declared.count(var->name.lexeme);
+        }
+        if (UnaryExpr* unary = dynamic_cast<UnaryExpr*>(expr)) return invariant(unary->right.get());
+        if (BinaryExpr* binary = dynamic_cast<BinaryExpr*>(expr)) {
+            return invariant(binary->left.get()) && invariant(binary->right.get());
+        }
+        CallExpr* call = dynamic_cast<CallExpr*>(expr);
+        return call && call->builtin == Builtin::LEN && call->arguments.size() == 1 && invariant(call->arguments[0].get());
+    }
+
+    const InductionVariable* variable(Expression* expr) const {
+        VariableExpr* var = dynamic_cast<VariableExpr*>(stripGrouping(expr));
+        if (!var) return nullptr;
+        for (const auto& candidate : variables) {
+            if (candidate.name == var->name.lexeme) return &candidate;
+        }
+        return nullptr;
+    }
+
+    void findVariables(BlockStmt* body) {
+        for (size_t k = 0; k < body->statements.size(); k++) {
+            ExpressionStmt* stmt = dynamic_cast<ExpressionStmt*>(body->statements[k].get());
+            AssignExpr* assign = stmt ? dynamic_cast<AssignExpr*>(stmt->expression.get()) : nullptr;
+            if (!assign || assign->type != TokenType::TYPE_INT) continue;
+            const std::string& name = assign->name.lexeme;
+            if (scan.writes.at(name) != 1 || scan.declared.count(name)) continue;
+
+            BinaryExpr* sum = dynamic_cast<BinaryExpr*>(stripGrouping(assign->value.get()));
+            if (!sum || sum->type != TokenType::TYPE_INT) continue;
+            if (sum->op.type != TokenType::PLUS && sum->op.type != TokenType::MINUS) continue;
+            VariableExpr* left = dynamic_cast<VariableExpr*>(stripGrouping(sum->left.get()));
+            VariableExpr* right = dynamic_cast<VariableExpr*>(stripGrouping(sum->right.get()));
+            Expression* step = nullptr;
+            if (left && left->name.lexeme == name) {
+                step = sum->right.get();
+            } else if (sum->op.type == TokenType::PLUS && right && right->name.lexeme == name) {
+                step = sum->left.get();
+            }
+            if (!step || step->type != TokenType::TYPE_INT || step->promoted || !invariant(step)) continue;
+            variables.push_back({name, k, sum->op.type, step});
+        }
+    }
+
+    // `i * k` with an invariant int k; `temp` is the name of the
+    // temporary that replaces it
+    bool matchProduct(Expression* expr, const InductionVariable*& base, Expression*& factor, std::string& temp) const {
+        BinaryExpr* binary = dynamic_cast<BinaryExpr*>(expr);
+        if (!binary || binary->op.type != TokenType::STAR || binary->type != TokenType::TYPE_INT) return false;
+        for (int side = 0; side < 2; side++) {
+            base = variable(side == 0 ? binary->left.get() : binary->right.get());
+            Expression* other = stripGrouping(side == 0 ? binary->right.get() : binary->left.get());
+            if (!base || other->type != TokenType::TYPE_INT) continue;
+            long long value = 0;
+            if (isIntLiteral(other, value)) {
+                temp = base->name + "$x" + std::to_string(value);
+            } else if (VariableExpr* var = dynamic_cast<VariableExpr*>(other); var && invariant(var)) {
+                temp = base->name + "$x" + var->name.lexeme;
+            } else {
+                continue;
+            }
+            factor = other;
+            return true;
+        }
+        return false;
+    }
+};
+
+// The uses of one derived induction variable
+struct Product {
+    const InductionVariable* base;
+    Expression* factor;
+    Expression* first; // Copied for the initial value
+    int uses = 0;
+};
+
+class ProductScan : public ASTWalker {
+private:
+    const LoopFacts& facts;
+    int nested = 0; // Loops entered inside the analyzed one
+
+public:
+    std::map<std::string, Product> products; // By temporary name
+
+    explicit ProductScan(const LoopFacts& facts) : facts(facts) {}
+
+    void visitBinaryExpr(BinaryExpr* expr) override {
+        const InductionVariable* base = nullptr;
+        Expression* factor = nullptr;
+        std::string temp;
+        if (!facts.matchProduct(expr, base, factor, temp)) {
+            ASTWalker::visitBinaryExpr(expr);
+            return;
+        }
+        auto inserted = products.emplace(temp, Product{base, factor, expr});
+        inserted.first->second.uses += nested > 0 ? InductionOptimizer::kMinUses : 1;
+    }
+    void visitWhileStmt(WhileStmt* stmt) override {
+        nested++;
+        ASTWalker::visitWhileStmt(stmt);
+        nested--;
+    }
+};
+
+class ProductReplacer : public ASTRewriter {
+private:
+    const LoopFacts& facts;
+    const std::map<std::string, Product>& reduced;
+
+public:
+    ProductReplacer(const LoopFacts& facts, const std::map<std::string, Product>& reduced) : facts(facts), reduced(reduced) {}
+
+    using ASTRewriter::rewrite;
+    void rewrite(std::unique_ptr<Expression>& slot) override {
+        const InductionVariable* base = nullptr;
+        Expression* factor = nullptr;
+        std::string temp;
+        if (slot && facts.matchProduct(slot.get(), base, factor, temp) && reduced.count(temp)) {
+            auto var = typed(std::make_unique<VariableExpr>(synth(TokenType::IDENTIFIER, temp, 0)), TokenType::TYPE_INT);
+            var->promoted = slot->promoted;
+            slot = std::move(var);
+            return;
+        }
+        ASTRewriter::rewrite(slot);
+    }
+};
+
+// A condition `i op B` with an invariant int B, op as if `i` were on the left
+struct Bound {
+    const InductionVariable* variable = nullptr;
+    TokenType op = TokenType::LESS;
+    std::unique_ptr<Expression>* slot = nullptr;
+};
+
+bool findBound(WhileStmt* loop, const LoopFacts& facts, Bound& bound) {
+    BinaryExpr* test = dynamic_cast<BinaryExpr*>(stripGrouping(loop->condition.get()));
+    if (!test || test->left->usedType() != TokenType::TYPE_INT || test->right->usedType() != TokenType::TYPE_INT) return false;
+    TokenType op = test->op.type;
+    TokenType flipped;
+    switch (op) {
+        case TokenType::LESS: flipped = TokenType::GREATER; break;
+        case TokenType::LESS_EQUAL: flipped = TokenType::GREATER_EQUAL; break;
+        case TokenType::GREATER: flipped = TokenType::LESS; break;
+        case TokenType::GREATER_EQUAL: flipped = TokenType::LESS_EQUAL; break;
+        case TokenType::BANG_EQUAL: flipped = op; break;
+        default: return false;
+    }
+    if ((bound.variable = facts.variable(test->left.get())) && facts.invariant(test->right.get())) {
+        bound.op = op;
+        bound.slot = &test->right;
+        return true;
+    }
+    if ((bound.variable = facts.variable(test->right.get())) && facts.invariant(test->left.get())) {
+        bound.op = flipped;
+        bound.slot = &test->left;
+        return true;
+    }
+    return false;
+}
+
+// The literal `i` holds when the loop starts, if `previous` sets it
+bool startValue(Statement* previous, const std::string& name, long long& value) {
+    if (VarStmt* var = dynamic_cast<VarStmt*>(previous)) {
+        return var->name.lexeme == name && var->initializer && isIntLiteral(var->initializer.get(), value);
+    }
+    ExpressionStmt* stmt = dynamic_cast<ExpressionStmt*>(previous);
+    AssignExpr* assign = stmt ? dynamic_cast<AssignExpr*>(stmt->expression.get()) : nullptr;
+    return assign && assign->name.lexeme == name && isIntLiteral(assign->value.get(), value);
+}
+
+// Iterations of `while (i op limit)` with i going from `start` by `step`.
+// False if the loop does not end, or only does so by wrapping around.
+bool tripCount(long long start, TokenType op, long long limit, long long step, long long& trips) {
+    if (step == 0) return false;
+    if (op == TokenType::LESS_EQUAL) {
+        op = TokenType::LESS;
+        limit++;
+    } else if (op == TokenType::GREATER_EQUAL) {
+        op = TokenType::GREATER;
+        limit--;
+    }
+    trips = 0;
+    if (op == TokenType::LESS) {
+        if (start >= limit) return true;
+        if (step < 0) return false;
+        trips = (limit - start + step - 1) / step;
+    } else if (op == TokenType::GREATER) {
+        if (start <= limit) return true;
+        if (step > 0) return false;
+        trips = (start - limit - step - 1) / -step;
+    } else {
+        long long distance = limit - start;
+        if (distance % step != 0 || distance / step < 0) return false;
+        trips = distance / step;
+    }
+    long long last = start + trips * step;
+    return last >= INT_MIN && last <= INT_MAX;
+}
+
+} // namespace
+
+InductionOptimizer::Result InductionOptimizer::run(std::vector<std::unique_ptr<Statement>>& program) {
+    result = Result();
+    purity.analyze(program);
+    optimizeList(program);
+    return result;
+}
+
+void InductionOptimizer::optimizeList(std::vector<std::unique_ptr<Statement>>& statements) {
+    std::vector<std::unique_ptr<Statement>> optimized;
+    for (auto& stmt : statements) {
+        ASTRewriter::rewrite(stmt); // Inner loops first
+        if (!dynamic_cast<WhileStmt*>(stmt.get())) {
+            optimized.push_back(std::move(stmt));
+            continue;
+        }
+        Statement* previous = optimized.empty() ? nullptr : optimized.back().get();
+        for (auto& replacement : optimize(std::move(stmt), previous)) optimized.push_back(std::move(replacement));
+    }
+    statements = std::move(optimized);
+}
+
+void InductionOptimizer::rewrite(std::unique_ptr<Statement>& slot) {
+    ASTRewriter::rewrite(slot);
+    if (!dynamic_cast<WhileStmt*>(slot.get())) return;
+    std::vector<std::unique_ptr<Statement>> replacement = optimize(std::move(slot), nullptr);
+    if (replacement.size() == 1) {
+        slot = std::move(replacement[0]);
+    } else {
+        slot = std::make_unique<BlockStmt>(std::move(replacement));
+    }
+}
+
+void InductionOptimizer::visitBlockStmt(BlockStmt* stmt) { optimizeList(stmt->statements); }
+
+void InductionOptimizer::visitFunctionStmt(FunctionStmt* stmt) { optimizeList(stmt->body); }
+
+std::vector<std::unique_ptr<Statement>> InductionOptimizer::optimize(std::unique_ptr<Statement> loopStmt, Statement* previous) {
+    std::vector<std::unique_ptr<Statement>> replacement;
+    WhileStmt* loop = static_cast<WhileStmt*>(loopStmt.get());
+    BlockStmt* body = dynamic_cast<BlockStmt*>(loop->body.get());
+
+    LoopFacts facts(purity);
+    if (body) {
+        loop->condition->accept(&facts.scan);
+        body->accept(&facts.scan);
+        if (!facts.scan.opaque) facts.findVariables(body);
+    }
+    if (facts.variables.empty()) {
+        replacement.push_back(std::move(loopStmt));
+        return replacement;
+    }
+    Bound bound;
+    bool bounded = findBound(loop, facts, bound);
+
+    // A known, small trip count: the body, that many times
+    long long start = 0, limit = 0, step = 0, trips = 0;
+    if (bounded && startValue(previous, bound.variable->name, start) && isIntLiteral(bound.slot->get(), limit) &&
+        isIntLiteral(bound.variable->step, step)) {
+        if (bound.variable->op == TokenType::MINUS) step = -step;
+        if (tripCount(start, bound.op, limit, step, trips) && trips <= kMaxTrips &&
+            trips * facts.scan.size <= kMaxUnrolledSize) {
+            for (long long k = 0; k < trips; k++) replacement.push_back(ASTCloner().clone(body));
+            result.unrolled++;
+            return replacement;
+        }
+    }
+
+    int line = loop->line;
+    Token intType = synth(TokenType::TYPE_INT, "int", line);
+    std::vector<std::unique_ptr<Statement>> setup;
+
+    if (bounded) {
+        Expression* limitExpr = stripGrouping(bound.slot->get());
+        if (!dynamic_cast<VariableExpr*>(limitExpr) && !dynamic_cast<LiteralExpr*>(limitExpr)) {
+            Token name = synth(TokenType::IDENTIFIER, bound.variable->name + "$bound", line);
+            setup.push_back(std::make_unique<VarStmt>(name, intType, std::move(*bound.slot)));
+            *bound.slot = typed(std::make_unique<VariableExpr>(name), TokenType::TYPE_INT);
+            result.hoisted++;
+        }
+    }
+
+    ProductScan scan(facts);
+    loop->condition->accept(&scan);
+    body->accept(&scan);
+    std::map<std::string, Product> reduced;
+    std::map<size_t, std::vector<std::unique_ptr<Statement>>> updates; // By index of the base variable's update
+    for (auto& entry : scan.products) {
+        const Product& product = entry.second;
+        if (product.uses < kMinUses) continue;
+        Token temp = synth(TokenType::IDENTIFIER, entry.first, line);
+        std::unique_ptr<Expression> initial = ASTCloner().clone(product.first);
+        initial->promoted = false;
+        setup.push_back(std::make_unique<VarStmt>(temp, intType, std::move(initial)));
+
+        // How much the temporary changes per iteration: step * factor
+        std::unique_ptr<Expression> increment;
+        long long stepValue = 0, factorValue = 0;
+        if (isIntLiteral(product.base->step, stepValue) && isIntLiteral(product.factor, factorValue)) {
+            increment = std::make_unique<LiteralExpr>(std::to_string(Value::wrap(stepValue * factorValue)), TokenType::TYPE_INT);
+        } else {
+            Token name = synth(TokenType::IDENTIFIER, entry.first + "$step", line);
+            Token star = synth(TokenType::STAR, "*", line);
+            auto multiply = typed(std::make_unique<BinaryExpr>(ASTCloner().clone(product.base->step), star,
+                                                               ASTCloner().clone(product.factor)),
+                                  TokenType::TYPE_INT);
+            setup.push_back(std::make_unique<VarStmt>(name, intType, std::move(multiply)));
+            increment = typed(std::make_unique<VariableExpr>(name), TokenType::TYPE_INT);
+        }
+
+        Token op = synth(product.base->op, product.base->op == TokenType::PLUS ? "+" : "-", line);
+        auto sum = typed(std::make_unique<BinaryExpr>(typed(std::make_unique<VariableExpr>(temp), TokenType::TYPE_INT), op,
+                                                      std::move(increment)),
+                         TokenType::TYPE_INT);
+        updates[product.base->update].push_back(
+            std::make_unique<ExpressionStmt>(typed(std::make_unique<AssignExpr>(temp, std::move(sum)), TokenType::TYPE_INT)));
+        reduced.emplace(entry.first, product);
+    }
+
+    if (!reduced.empty()) {
+        ProductReplacer replacer(facts, reduced);
+        replacer.rewrite(loop->condition);
+        replacer.rewrite(loop->body);
+        std::vector<std::unique_ptr<Statement>> statements;
+        for (size_t k = 0; k < body->statements.size(); k++) {
+            statements.push_back(std::move(body->statements[k]));
+            auto found = updates.find(k);
+            if (found == updates.end()) continue;
+            for (auto& update : found->second) statements.push_back(std::move(update));
+        }
+        body->statements = std::move(statements);
+        result.reduced += (int)reduced.size();
+    }
+
+    if (setup.empty()) {
+        replacement.push_back(std::move(loopStmt));
+        return replacement;
+    }
+    setup.push_back(std::move(loopStmt));
+    replacement.push_back(std::make_unique<BlockStmt>(std::move(setup)));
+    return replacement;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "../data/AST.h"
+#include "purity-analyzer.h"
+
+// Optimizes counted `while` loops through their induction variables.
+//
+// A basic induction variable is an int `i` whose only write in the loop is
+// a statement `i = i + c` (or `i - c`) directly in the body, with `c`
+// loop-invariant. It therefore changes by the same step once per
+// iteration, and for each such variable the pass:
+//
+// - strength-reduces the derived induction variables `i * k` (k an
+//   invariant int variable or literal): a temporary starts at `i * k`
+//   before the loop, is advanced by `c * k` right after each update of
+//   `i`, and replaces the products. An update costs about as much as the
+//   multiplication it saves in this interpreter, so only products
+//   evaluated at least kMinUses times per iteration are reduced; a use
+//   inside a nested loop always counts as enough.
+// - evaluates an invariant bound `i < B` (or <=, >, >=, !=) once before the
+//   loop, unless B is already a plain variable or literal.
+// - computes the trip count when `i` starts at a literal in the statement
+//   just before the loop and both B and c are literals, and replaces loops
+//   of at most kMaxTrips trips and kMaxUnrolledSize nodes in total by that
+//   many copies of the body, each in its own block.
+//
+// Invariant expressions are literals, variables the loop neither writes
+// nor declares, len() of those, and arithmetic on them. Loops containing a
+// function declaration, a parallel for or a call to an impure function are
+// left alone, since those may write variables behind the pass's back.
+// Must run after semantic analysis (it relies on expression types and
+// CallExpr::resolved).
+class InductionOptimizer : public ASTRewriter {
+public:
+    static const int kMinUses = 2;
+    static const int kMaxTrips = 8;
+    static const int kMaxUnrolledSize = 96;
+
+    struct Result {
+        int reduced = 0;  // Products replaced by a temporary
+        int hoisted = 0;  // Bounds evaluated before their loop
+        int unrolled = 0; // Loops replaced by copies of their body
+    };
+
+private:
+    PurityAnalyzer purity;
+    Result result;
+
+    void optimizeList(std::vector<std::unique_ptr<Statement>>& statements);
+    // The statements that replace `loop`; `previous` is the statement
+    // before it in the same block, if any
+    std::vector<std::unique_ptr<Statement>> optimize(std::unique_ptr<Statement> loop, Statement* previous);
+
+public:
+    Result run(std::vector<std::unique_ptr<Statement>>& program);
+
+    using ASTRewriter::rewrite;
+    void rewrite(std::unique_ptr<Statement>& slot) override;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+};
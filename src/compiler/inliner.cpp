@@ -0,0 +1,304 @@
+#include "inliner.h"
+#include "ast-cloner.h"
+
+namespace {
+
+// Counts nodes and records what an expression reads, writes and calls
+class ExprInfo : public ASTWalker {
+public:
+    int size = 0;
+    bool hasCall = false;
+    bool hasUserCall = false; // Builtins write nothing
+    bool hasAssign = false;
+    bool readsElement = false;
+    bool mayTrap = false; // Division, indexing, allocation or array arithmetic
+    std::map<std::string, int> reads;
+    std::set<FunctionStmt*> callees;
+
+    static bool isArray(TokenType type) { return type == TokenType::TYPE_INT_ARRAY || type == TokenType::TYPE_FLOAT_ARRAY; }
+
+    void visitBinaryExpr(BinaryExpr* expr) override {
+        size++;
+        if (expr->op.type == TokenType::SLASH || isArray(expr->left->type) || isArray(expr->right->type)) mayTrap = true;
+        ASTWalker::visitBinaryExpr(expr);
+    }
+    void visitGroupingExpr(GroupingExpr* expr) override { ASTWalker::visitGroupingExpr(expr); }
+    void visitLiteralExpr(LiteralExpr*) override { size++; }
+    void visitUnaryExpr(UnaryExpr* expr) override { size++; ASTWalker::visitUnaryExpr(expr); }
+    void visitVariableExpr(VariableExpr* expr) override {
+        size++;
+        reads[expr->name.lexeme]++;
+    }
+    void visitAssignExpr(AssignExpr* expr) override {
+        size++;
+        hasAssign = true;
+        ASTWalker::visitAssignExpr(expr);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        size++;
+        hasCall = true;
+        if (expr->resolved) {
+            hasUserCall = true;
+            callees.insert(expr->resolved);
+        }
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitArrayExpr(ArrayExpr* expr) override {
+        size++;
+        if (expr->length) mayTrap = true;
+        ASTWalker::visitArrayExpr(expr);
+    }
+    void visitIndexExpr(IndexExpr* expr) override {
+        size++;
+        readsElement = true;
+        mayTrap = true;
+        ASTWalker::visitIndexExpr(expr);
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        size++;
+        hasAssign = true;
+        ASTWalker::visitIndexAssignExpr(expr);
+    }
+};
+
+// Collects functions, call edges and call-site counts. With a profile,
+// sites that never ran are not counted and `profiledCalls` sums the rest.
+class CallGraph : public ASTWalker {
+public:
+    const ExecutionProfile* profile = nullptr;
+    std::vector<FunctionStmt*> functions;
+    std::map<FunctionStmt*, std::set<FunctionStmt*>> edges;
+    std::map<FunctionStmt*, int> callSites;
+    std::map<FunctionStmt*, long long> profiledCalls;
+    long long totalProfiledCalls = 0;
+    std::vector<FunctionStmt*> enclosing;
+
+    void visitFunctionStmt(FunctionStmt* stmt) override {
+        functions.push_back(stmt);
+        edges[stmt];
+        enclosing.push_back(stmt);
+        ASTWalker::visitFunctionStmt(stmt);
+        enclosing.pop_back();
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        if (expr->resolved) {
+            long long count = profile ? profile->callCount(expr) : 1;
+            if (count > 0) callSites[expr->resolved]++;
+            profiledCalls[expr->resolved] += count;
+            totalProfiledCalls += count;
+            if (!enclosing.empty()) edges[enclosing.back()].insert(expr->resolved);
+        }
+        ASTWalker::visitCallExpr(expr);
+    }
+
+    bool reaches(FunctionStmt* from, FunctionStmt* target) {
+        std::set<FunctionStmt*> seen;
+        std::vector<FunctionStmt*> worklist(edges[from].begin(), edges[from].end());
+        while (!worklist.empty()) {
+            FunctionStmt* f = worklist.back();
+            worklist.pop_back();
+            if (f == target) return true;
+            if (!seen.insert(f).second) continue;
+            for (FunctionStmt* next : edges[f]) worklist.push_back(next);
+        }
+        return false;
+    }
+};
+
+// Gives locals that shadow a global or function name a unique '$' name,
+// so an inlined body can never capture a caller's local by accident.
+class LocalRenamer : public ASTWalker {
+public:
+    const std::set<std::string>* globalNames;
+    std::vector<std::map<std::string, std::string>> scopes{1};
+    int counter = 0;
+
+    std::string fresh(const std::string& name) { return name + "$" + std::to_string(++counter); }
+
+    std::string resolve(const std::string& name) {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return found->second;
+        }
+        return name;
+    }
+
+    void visitBlockStmt(BlockStmt* stmt) override {
+        scopes.emplace_back();
+        ASTWalker::visitBlockStmt(stmt);
+        scopes.pop_back();
+    }
+    void visitFunctionStmt(FunctionStmt* stmt) override {
+        scopes.emplace_back();
+        for (auto& param : stmt->params) {
+            if (globalNames->count(param.lexeme)) {
+                std::string renamed = fresh(param.lexeme);
+                scopes.back()[param.lexeme] = renamed;
+                param.lexeme = renamed;
+            }
+        }
+        walk(stmt->body);
+        scopes.pop_back();
+    }
+    void visitVarStmt(VarStmt* stmt) override {
+        ASTWalker::visitVarStmt(stmt); // The initializer still sees the outer name
+        if (scopes.size() > 1 && globalNames->count(stmt->name.lexeme)) {
+            std::string renamed = fresh(stmt->name.lexeme);
+            scopes.back()[stmt->name.lexeme] = renamed;
+            stmt->name.lexeme = renamed;
+        }
+    }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        stmt->start->accept(this);
+        stmt->end->accept(this);
+        for (SharedWrite& write : stmt->writes) write.name.lexeme = resolve(write.name.lexeme);
+        scopes.emplace_back();
+        if (globalNames->count(stmt->name.lexeme)) {
+            std::string renamed = fresh(stmt->name.lexeme);
+            scopes.back()[stmt->name.lexeme] = renamed;
+            stmt->name.lexeme = renamed;
+        }
+        stmt->body->accept(this);
+        scopes.pop_back();
+    }
+    void visitVariableExpr(VariableExpr* expr) override { expr->name.lexeme = resolve(expr->name.lexeme); }
+    void visitAssignExpr(AssignExpr* expr) override {
+        ASTWalker::visitAssignExpr(expr);
+        expr->name.lexeme = resolve(expr->name.lexeme);
+    }
+};
+
+} // namespace
+
+int Inliner::run(std::vector<std::unique_ptr<Statement>>& program) {
+    inlined = 0;
+    collect(program);
+    decide();
+
+    bool any = false;
+    for (const auto& entry : candidates) any = any || entry.second.inlinable;
+    if (!any) return 0;
+
+    LocalRenamer renamer;
+    renamer.globalNames = &globalNames;
+    renamer.walk(program);
+
+    rewrite(program);
+    return inlined;
+}
+
+void Inliner::collect(std::vector<std::unique_ptr<Statement>>& program) {
+    candidates.clear();
+    globalNames.clear();
+
+    CallGraph graph;
+    graph.profile = profile;
+    graph.walk(program);
+    totalProfiledCalls = graph.totalProfiledCalls;
+
+    for (const auto& stmt : program) {
+        if (VarStmt* var = dynamic_cast<VarStmt*>(stmt.get())) globalNames.insert(var->name.lexeme);
+    }
+    for (FunctionStmt* fn : graph.functions) globalNames.insert(fn->name.lexeme);
+
+    for (FunctionStmt* fn : graph.functions) {
+        if (fn->body.size() != 1) continue;
+        ReturnStmt* ret = dynamic_cast<ReturnStmt*>(fn->body[0].get());
+        // An int result widened by the return would stay an int once inlined
+        if (!ret || !ret->value || ret->value->promoted) continue;
+
+        ExprInfo info;
+        ret->value->accept(&info);
+        if (info.hasAssign) continue;
+
+        // Every free name must be a global; locals of an enclosing function
+        // would not be visible at the call site.
+        bool closed = true;
+        for (const auto& read : info.reads) {
+            bool isParam = false;
+            for (const auto& param : fn->params) isParam = isParam || param.lexeme == read.first;
+            if (!isParam && !globalNames.count(read.first)) closed = false;
+        }
+        if (!closed || graph.reaches(fn, fn)) continue;
+
+        Candidate candidate;
+        candidate.ret = ret;
+        candidate.size = info.size;
+        candidate.callSites = graph.callSites[fn];
+        candidate.profiledCalls = graph.profiledCalls[fn];
+        candidates[fn] = candidate;
+    }
+}
+
+void Inliner::decide() {
+    for (auto& entry : candidates) {
+        Candidate& c = entry.second;
+        int callCost = 1 + (int)entry.first->params.size();
+        int growth = (c.size - callCost) * c.callSites;
+        c.hot = profile && c.profiledCalls > 0 && c.profiledCalls * kHotCallShare >= totalProfiledCalls;
+        c.inlinable = c.callSites > 0 && c.size <= (c.hot ? kMaxHotInlineSize : kMaxInlineSize) &&
+                      growth <= (c.hot ? kHotGrowthBudget : kGrowthBudget);
+    }
+}
+
+bool Inliner::bindArguments(CallExpr* call, FunctionStmt* callee, std::map<std::string, Expression*>& outBindings) {
+    if (call->arguments.size() != callee->params.size()) return false;
+
+    ExprInfo body;
+    candidates[callee].ret->value->accept(&body);
+    int traps = body.mayTrap ? 1 : 0;
+
+    for (size_t i = 0; i < callee->params.size(); i++) {
+        Expression* arg = call->arguments[i].get();
+        ExprInfo info;
+        arg->accept(&info);
+        if (info.hasCall || info.hasAssign) return false;
+        // A call in the body now runs before the substituted argument and
+        // could change a global or element it reads. Locals are safe: locals
+        // named like a global were renamed before rewriting.
+        if (body.hasUserCall) {
+            if (info.readsElement) return false;
+            for (const auto& read : info.reads) {
+                if (globalNames.count(read.first)) return false;
+            }
+        }
+
+        int uses = body.reads.count(callee->params[i].lexeme) ? body.reads[callee->params[i].lexeme] : 0;
+        bool trivial = dynamic_cast<LiteralExpr*>(arg) || dynamic_cast<VariableExpr*>(arg);
+        if (uses > 1 && !trivial) return false;
+
+        // The call evaluated every argument first, so one that can fail
+        // must still run exactly once and fail before anything else does
+        if (info.mayTrap && (uses != 1 || body.hasCall || ++traps > 1)) return false;
+
+        // An int argument for a float parameter relies on the implicit
+        // conversion at the call; substituting it would change the arithmetic.
+        if (callee->paramTypes[i].type == TokenType::TYPE_FLOAT && arg->type != TokenType::TYPE_FLOAT) return false;
+
+        outBindings[callee->params[i].lexeme] = arg;
+    }
+    return true;
+}
+
+void Inliner::rewrite(std::unique_ptr<Expression>& slot) {
+    ASTRewriter::rewrite(slot); // Inline inside the arguments first
+
+    CallExpr* call = dynamic_cast<CallExpr*>(slot.get());
+    if (!call || !call->resolved) return;
+    auto found = candidates.find(call->resolved);
+    if (found == candidates.end() || !found->second.inlinable) return;
+    if (profile && profile->callCount(call) == 0) return; // Cold site
+
+    std::map<std::string, Expression*> bindings;
+    if (!bindArguments(call, call->resolved, bindings)) return;
+
+    ASTCloner cloner;
+    cloner.substitutions = bindings;
+    std::unique_ptr<Expression> body = cloner.clone(found->second.ret->value.get());
+    body->promoted = call->promoted;
+    slot = std::move(body);
+    inlined++;
+
+    // The inlined body may itself call other inlinable functions
+    ASTRewriter::rewrite(slot);
+}
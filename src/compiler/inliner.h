@@ -0,0 +1,66 @@
+#pragma once
+#include <map>
+#include <set>
+#include "../data/AST.h"
+#include "../data/execution-profile.h"
+
+// Substitutes small, non-recursive functions at their call sites.
+//
+// Candidates are functions whose body is a single `return expr;` (the
+// accessor-style helpers that make up most calls). A candidate is inlined
+// when its expression is at most kMaxInlineSize nodes and the code growth
+// it causes over all static call sites stays within kGrowthBudget:
+//
+//     growth = (size - callCost) * callSites,  callCost = 1 + #params
+//
+// Arguments are bound by substitution, so a call site is only rewritten
+// when its arguments are side-effect free, every argument used more than
+// once is a plain variable or literal, and evaluating them later changes
+// nothing: if the body calls a function, arguments may only read locals,
+// and an argument that can fail at run time (division, indexing) must be
+// used exactly once, by a body without calls and with no other way to fail.
+//
+// With an execution profile, call sites that never ran are left alone and
+// their growth is not counted, and functions receiving at least
+// 1/kHotCallShare of all calls are hot: they may be up to kMaxHotInlineSize
+// nodes and grow the code by up to kHotGrowthBudget.
+//
+// Locals that shadow a global or function name are renamed first so that
+// names in an inlined body still refer to the same declarations.
+// Must run after semantic analysis (it relies on CallExpr::resolved).
+class Inliner : public ASTRewriter {
+public:
+    static const int kMaxInlineSize = 40;
+    static const int kGrowthBudget = 160;
+    static const int kMaxHotInlineSize = 120;
+    static const int kHotGrowthBudget = 640;
+    static const int kHotCallShare = 100;
+
+    const ExecutionProfile* profile = nullptr; // Optional, from --profile-use
+
+private:
+    struct Candidate {
+        ReturnStmt* ret;    // The function's only statement
+        int size = 0;
+        int callSites = 0;
+        long long profiledCalls = 0;
+        bool hot = false;
+        bool inlinable = false;
+    };
+
+    std::map<FunctionStmt*, Candidate> candidates;
+    std::set<std::string> globalNames;
+    int inlined = 0;
+    long long totalProfiledCalls = 0;
+
+    void collect(std::vector<std::unique_ptr<Statement>>& program);
+    void decide();
+    bool bindArguments(CallExpr* call, FunctionStmt* callee, std::map<std::string, Expression*>& outBindings);
+
+public:
+    // Returns the number of call sites that were inlined
+    int run(std::vector<std::unique_ptr<Statement>>& program);
+
+    void rewrite(std::unique_ptr<Expression>& slot) override;
+    using ASTRewriter::rewrite;
+};
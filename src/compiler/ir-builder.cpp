@@ -0,0 +1,673 @@
+#include "ir-builder.h"
+#include <stdexcept>
+
+static IRType irTypeOf(TokenType type) {
+    switch (type) {
+        case TokenType::TYPE_INT: return IRType::INT;
+        case TokenType::TYPE_FLOAT: return IRType::FLOAT;
+        case TokenType::TYPE_BOOL: return IRType::BOOL;
+        case TokenType::TYPE_STRING: return IRType::STRING;
+        case TokenType::TYPE_INT_ARRAY: return IRType::INT_ARRAY;
+        case TokenType::TYPE_FLOAT_ARRAY: return IRType::FLOAT_ARRAY;
+        default: return IRType::VOID;
+    }
+}
+
+std::unique_ptr<Module> IRBuilder::build(const std::vector<std::unique_ptr<Statement>>& statements) {
+    auto result = std::make_unique<Module>();
+    module = result.get();
+    scopes.clear();
+    scopes.emplace_back(); // Global scope
+    pendingFunctions.clear();
+
+    beginFunction(".toplevel", IRType::VOID);
+    for (const auto& stmt : statements) {
+        stmt->accept(this);
+    }
+    endFunction();
+
+    // Function bodies are lowered after the code that declares them.
+    // buildFunction may append nested declarations, so index instead of iterating.
+    for (size_t i = 0; i < pendingFunctions.size(); i++) {
+        buildFunction(pendingFunctions[i]);
+    }
+
+    module = nullptr;
+    return result;
+}
+
+// --- Functions ---
+
+void IRBuilder::beginFunction(const std::string& name, IRType returnType) {
+    module->functions.push_back(std::make_unique<Function>(name, returnType));
+    function = module->functions.back().get();
+    currentDef.clear();
+    varTypes.clear();
+    incompletePhis.clear();
+    sealed.clear();
+
+    block = createBlock("entry");
+    sealBlock(block);
+}
+
+void IRBuilder::endFunction() {
+    if (!block->terminator()) {
+        // Falling off the end of a typed function yields the zero value
+        Instruction* ret = emit(Opcode::RET, IRType::VOID);
+        if (function->returnType != IRType::VOID) ret->operands.push_back(defaultValue(function->returnType));
+    }
+    removeUnreachableBlocks();
+    removeTrivialPhis();
+    function = nullptr;
+    block = nullptr;
+}
+
+void IRBuilder::buildFunction(FunctionStmt* stmt) {
+    beginFunction(stmt->name.lexeme, irTypeOf(stmt->returnType.type));
+
+    // Functions only see globals, never the locals of whatever declared them
+    std::map<std::string, VarSlot> globals = scopes.front();
+    scopes.clear();
+    scopes.push_back(globals);
+    scopes.emplace_back();
+
+    for (size_t i = 0; i < stmt->params.size(); i++) {
+        IRType type = irTypeOf(stmt->paramTypes[i].type);
+        function->params.push_back(std::make_unique<Instruction>(function->nextValueId++, Opcode::PARAM, type));
+        Instruction* param = function->params.back().get();
+        param->symbol = stmt->params[i].lexeme;
+
+        int var = newVariable(type);
+        writeVariable(var, block, param);
+        scopes.back()[stmt->params[i].lexeme] = {false, var, type};
+    }
+
+    for (const auto& s : stmt->body) {
+        s->accept(this);
+    }
+
+    scopes.pop_back();
+    endFunction();
+}
+
+bool IRBuilder::atGlobalScope() {
+    return function->name == ".toplevel" && scopes.size() == 1;
+}
+
+bool IRBuilder::lookup(const std::string& name, VarSlot& outSlot) {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) {
+            outSlot = found->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Blocks and instructions ---
+
+BasicBlock* IRBuilder::createBlock(const std::string& label) {
+    int id = function->nextBlockId++;
+    function->blocks.push_back(std::make_unique<BasicBlock>(id, id == 0 ? label : label + std::to_string(id)));
+    return function->blocks.back().get();
+}
+
+Instruction* IRBuilder::emit(Opcode op, IRType type, std::vector<Instruction*> operands) {
+    block->instructions.push_back(std::make_unique<Instruction>(function->nextValueId++, op, type));
+    Instruction* inst = block->instructions.back().get();
+    inst->operands = std::move(operands);
+    inst->parent = block;
+    return inst;
+}
+
+void IRBuilder::branch(BasicBlock* target) {
+    Instruction* br = emit(Opcode::BR, IRType::VOID);
+    br->blocks.push_back(target);
+    block->succs.push_back(target);
+    target->preds.push_back(block);
+}
+
+void IRBuilder::condBranch(Instruction* cond, BasicBlock* ifTrue, BasicBlock* ifFalse) {
+    Instruction* br = emit(Opcode::CONDBR, IRType::VOID, {cond});
+    br->blocks = {ifTrue, ifFalse};
+    block->succs = {ifTrue, ifFalse};
+    ifTrue->preds.push_back(block);
+    ifFalse->preds.push_back(block);
+}
+
+// Code following a return still has to go somewhere; it is dropped later.
+void IRBuilder::startDeadBlock() {
+    block = createBlock("dead");
+    sealBlock(block);
+}
+
+Instruction* IRBuilder::convert(Instruction* value, IRType to) {
+    if (value->type == IRType::INT && to == IRType::FLOAT) {
+        if (value->op == Opcode::CONST) return function->constant(IRType::FLOAT, 0, (double)value->intValue);
+        return emit(Opcode::ITOF, IRType::FLOAT, {value});
+    }
+    return value;
+}
+
+// Builds `expr` and applies the widening the analyzer recorded on it
+Instruction* IRBuilder::lower(Expression* expr) {
+    expr->accept(this);
+    return expr->promoted ? convert(lastValue, IRType::FLOAT) : lastValue;
+}
+
+// Value of a declaration without initializer or of a missing return value;
+// arrays start out empty
+Instruction* IRBuilder::defaultValue(IRType type) {
+    if (!isArrayIRType(type)) return function->zero(type);
+    return emit(Opcode::NEWARRAY, type, {function->constant(IRType::INT, 0)});
+}
+
+// --- SSA construction ---
+
+int IRBuilder::newVariable(IRType type) {
+    varTypes.push_back(type);
+    currentDef.emplace_back();
+    return (int)varTypes.size() - 1;
+}
+
+void IRBuilder::writeVariable(int var, BasicBlock* b, Instruction* value) {
+    currentDef[var][b] = value;
+}
+
+Instruction* IRBuilder::readVariable(int var, BasicBlock* b) {
+    auto found = currentDef[var].find(b);
+    if (found != currentDef[var].end()) return found->second;
+    return readVariableRecursive(var, b);
+}
+
+Instruction* IRBuilder::readVariableRecursive(int var, BasicBlock* b) {
+    Instruction* value;
+    if (sealed.count(b) == 0) {
+        // Not all predecessors are known yet; complete the phi when sealing
+        value = newPhi(b, varTypes[var]);
+        incompletePhis[b].push_back({var, value});
+    } else if (b->preds.empty()) {
+        value = function->zero(varTypes[var]); // Unreachable code
+    } else if (b->preds.size() == 1) {
+        value = readVariable(var, b->preds[0]);
+    } else {
+        // Break potential cycles with an operandless phi first
+        value = newPhi(b, varTypes[var]);
+        writeVariable(var, b, value);
+        addPhiOperands(var, value);
+    }
+    writeVariable(var, b, value);
+    return value;
+}
+
+Instruction* IRBuilder::newPhi(BasicBlock* b, IRType type) {
+    auto phi = std::make_unique<Instruction>(function->nextValueId++, Opcode::PHI, type);
+    phi->parent = b;
+    Instruction* result = phi.get();
+
+    // Phis stay grouped at the top of the block
+    auto pos = b->instructions.begin();
+    while (pos != b->instructions.end() && (*pos)->op == Opcode::PHI) ++pos;
+    b->instructions.insert(pos, std::move(phi));
+    return result;
+}
+
+void IRBuilder::addPhiOperands(int var, Instruction* phi) {
+    for (BasicBlock* pred : phi->parent->preds) {
+        phi->operands.push_back(readVariable(var, pred));
+        phi->blocks.push_back(pred);
+    }
+}
+
+void IRBuilder::sealBlock(BasicBlock* b) {
+    // Completing a phi can create further incomplete phis in this block
+    while (!incompletePhis[b].empty()) {
+        std::vector<std::pair<int, Instruction*>> pending = std::move(incompletePhis[b]);
+        incompletePhis[b].clear();
+        for (auto& entry : pending) {
+            addPhiOperands(entry.first, entry.second);
+        }
+    }
+    incompletePhis.erase(b);
+    sealed.insert(b);
+}
+
+void IRBuilder::removeUnreachableBlocks() {
+    std::unordered_set<BasicBlock*> reachable;
+    std::vector<BasicBlock*> worklist = {function->entry()};
+    reachable.insert(function->entry());
+    while (!worklist.empty()) {
+        BasicBlock* b = worklist.back();
+        worklist.pop_back();
+        for (BasicBlock* succ : b->succs) {
+            if (reachable.insert(succ).second) worklist.push_back(succ);
+        }
+    }
+
+    for (auto& b : function->blocks) {
+        if (reachable.count(b.get()) == 0) continue;
+        auto& preds = b->preds;
+        preds.erase(std::remove_if(preds.begin(), preds.end(),
+                        [&](BasicBlock* p) { return reachable.count(p) == 0; }),
+                    preds.end());
+        for (auto& inst : b->instructions) {
+            if (inst->op != Opcode::PHI) break;
+            for (size_t i = inst->blocks.size(); i-- > 0;) {
+                if (reachable.count(inst->blocks[i]) == 0) {
+                    inst->blocks.erase(inst->blocks.begin() + i);
+                    inst->operands.erase(inst->operands.begin() + i);
+                }
+            }
+        }
+    }
+
+    auto& blocks = function->blocks;
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(),
+                     [&](const std::unique_ptr<BasicBlock>& b) { return reachable.count(b.get()) == 0; }),
+                 blocks.end());
+}
+
+// A phi is trivial if it only merges a single value (and possibly itself).
+void IRBuilder::removeTrivialPhis() {
+    std::unordered_map<Instruction*, Instruction*> replacements;
+    auto resolve = [&](Instruction* v) {
+        auto found = replacements.find(v);
+        while (found != replacements.end()) {
+            v = found->second;
+            found = replacements.find(v);
+        }
+        return v;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& b : function->blocks) {
+            for (auto& inst : b->instructions) {
+                if (inst->op != Opcode::PHI) break;
+                Instruction* phi = inst.get();
+                if (replacements.count(phi)) continue;
+
+                Instruction* same = nullptr;
+                bool trivial = true;
+                for (Instruction* operand : phi->operands) {
+                    operand = resolve(operand);
+                    if (operand == same || operand == phi) continue;
+                    if (same != nullptr) {
+                        trivial = false;
+                        break;
+                    }
+                    same = operand;
+                }
+                if (trivial) {
+                    replacements[phi] = same ? same : function->zero(phi->type);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    function->replaceAllUses(replacements);
+    std::unordered_set<Instruction*> dead;
+    for (auto& entry : replacements) dead.insert(entry.first);
+    function->erase(dead);
+}
+
+// --- Expressions ---
+
+void IRBuilder::visitLiteralExpr(LiteralExpr* expr) {
+    switch (expr->typeHint) {
+        case TokenType::TYPE_INT:
+            lastValue = function->constant(IRType::INT, expr->constant.i);
+            break;
+        case TokenType::TYPE_FLOAT:
+            lastValue = function->constant(IRType::FLOAT, 0, expr->constant.f);
+            break;
+        case TokenType::TYPE_STRING:
+            lastValue = function->constant(expr->constant.str->text);
+            break;
+        default:
+            lastValue = function->constant(IRType::BOOL, expr->constant.b ? 1 : 0);
+            break;
+    }
+}
+
+void IRBuilder::visitGroupingExpr(GroupingExpr* expr) {
+    expr->expression->accept(this);
+}
+
+void IRBuilder::visitVariableExpr(VariableExpr* expr) {
+    VarSlot slot;
+    if (!lookup(expr->name.lexeme, slot)) {
+        throw std::runtime_error("'" + expr->name.lexeme + "' is not visible from function '" + function->name + "'.");
+    }
+    if (slot.global) {
+        lastValue = emit(Opcode::GLOAD, slot.type);
+        lastValue->symbol = expr->name.lexeme;
+    } else {
+        lastValue = readVariable(slot.varId, block);
+    }
+}
+
+void IRBuilder::visitAssignExpr(AssignExpr* expr) {
+    Instruction* value = lower(expr->value.get());
+    VarSlot slot;
+    if (!lookup(expr->name.lexeme, slot)) {
+        throw std::runtime_error("'" + expr->name.lexeme + "' is not visible from function '" + function->name + "'.");
+    }
+    if (slot.global) {
+        Instruction* store = emit(Opcode::GSTORE, IRType::VOID, {value});
+        store->symbol = expr->name.lexeme;
+    } else {
+        writeVariable(slot.varId, block, value);
+    }
+    lastValue = value;
+}
+
+void IRBuilder::visitBinaryExpr(BinaryExpr* expr) {
+    TokenType op = expr->op.type;
+
+    if (op == TokenType::AND || op == TokenType::OR) {
+        // Short-circuit: the right operand only runs if it can change the result
+        expr->left->accept(this);
+        Instruction* left = lastValue;
+        BasicBlock* leftEnd = block;
+        BasicBlock* rhs = createBlock(op == TokenType::AND ? "and.rhs" : "or.rhs");
+        BasicBlock* merge = createBlock(op == TokenType::AND ? "and.end" : "or.end");
+        if (op == TokenType::AND) condBranch(left, rhs, merge);
+        else condBranch(left, merge, rhs);
+
+        sealBlock(rhs);
+        block = rhs;
+        expr->right->accept(this);
+        Instruction* right = lastValue;
+        BasicBlock* rightEnd = block;
+        branch(merge);
+
+        sealBlock(merge);
+        block = merge;
+        Instruction* phi = newPhi(merge, IRType::BOOL);
+        phi->operands = {function->constant(IRType::BOOL, op == TokenType::OR ? 1 : 0), right};
+        phi->blocks = {leftEnd, rightEnd};
+        lastValue = phi;
+        return;
+    }
+
+    Instruction* left = lower(expr->left.get());
+    Instruction* right = lower(expr->right.get());
+
+    if (isArrayIRType(left->type) || isArrayIRType(right->type)) {
+        // Elementwise; an int[] operand is widened by the intrinsic itself
+        bool anyFloat = left->type == IRType::FLOAT || left->type == IRType::FLOAT_ARRAY ||
+                        right->type == IRType::FLOAT || right->type == IRType::FLOAT_ARRAY;
+        lastValue = emit(Opcode::INTRINSIC, anyFloat ? IRType::FLOAT_ARRAY : IRType::INT_ARRAY, {left, right});
+        switch (op) {
+            case TokenType::PLUS: lastValue->symbol = "add"; break;
+            case TokenType::MINUS: lastValue->symbol = "sub"; break;
+            case TokenType::STAR: lastValue->symbol = "mul"; break;
+            default: lastValue->symbol = "div"; break;
+        }
+        return;
+    }
+
+    if (left->type == IRType::STRING) {
+        bool concat = op == TokenType::PLUS;
+        lastValue = emit(Opcode::INTRINSIC, concat ? IRType::STRING : IRType::BOOL, {left, right});
+        lastValue->symbol = concat ? "concat" : op == TokenType::EQUAL_EQUAL ? "streq" : "strne";
+        return;
+    }
+
+    bool isFloat = left->type == IRType::FLOAT;
+    IRType numeric = isFloat ? IRType::FLOAT : IRType::INT;
+
+    switch (op) {
+        case TokenType::PLUS:  lastValue = emit(isFloat ? Opcode::FADD : Opcode::IADD, numeric, {left, right}); break;
+        case TokenType::MINUS: lastValue = emit(isFloat ? Opcode::FSUB : Opcode::ISUB, numeric, {left, right}); break;
+        case TokenType::STAR:  lastValue = emit(isFloat ? Opcode::FMUL : Opcode::IMUL, numeric, {left, right}); break;
+        case TokenType::SLASH: lastValue = emit(isFloat ? Opcode::FDIV : Opcode::IDIV, numeric, {left, right}); break;
+        case TokenType::EQUAL_EQUAL:   lastValue = emit(isFloat ? Opcode::FCMP_EQ : Opcode::ICMP_EQ, IRType::BOOL, {left, right}); break;
+        case TokenType::BANG_EQUAL:    lastValue = emit(isFloat ? Opcode::FCMP_NE : Opcode::ICMP_NE, IRType::BOOL, {left, right}); break;
+        case TokenType::LESS:          lastValue = emit(isFloat ? Opcode::FCMP_LT : Opcode::ICMP_LT, IRType::BOOL, {left, right}); break;
+        case TokenType::LESS_EQUAL:    lastValue = emit(isFloat ? Opcode::FCMP_LE : Opcode::ICMP_LE, IRType::BOOL, {left, right}); break;
+        case TokenType::GREATER:       lastValue = emit(isFloat ? Opcode::FCMP_GT : Opcode::ICMP_GT, IRType::BOOL, {left, right}); break;
+        case TokenType::GREATER_EQUAL: lastValue = emit(isFloat ? Opcode::FCMP_GE : Opcode::ICMP_GE, IRType::BOOL, {left, right}); break;
+        default:
+            throw std::runtime_error("Unsupported binary operator '" + expr->op.lexeme + "'.");
+    }
+}
+
+void IRBuilder::visitUnaryExpr(UnaryExpr* expr) {
+    expr->right->accept(this);
+    Instruction* operand = lastValue;
+    if (expr->op.type == TokenType::BANG) {
+        lastValue = emit(Opcode::NOT, IRType::BOOL, {operand});
+    } else if (operand->type == IRType::FLOAT) {
+        lastValue = emit(Opcode::FNEG, IRType::FLOAT, {operand});
+    } else {
+        lastValue = emit(Opcode::INEG, IRType::INT, {operand});
+    }
+}
+
+void IRBuilder::visitCallExpr(CallExpr* expr) {
+    VariableExpr* callee = dynamic_cast<VariableExpr*>(expr->callee.get());
+    if (expr->builtin != Builtin::NONE) {
+        std::vector<Instruction*> args;
+        for (const auto& arg : expr->arguments) args.push_back(lower(arg.get()));
+        IRType element = args[0]->type == IRType::FLOAT_ARRAY || args[0]->type == IRType::FLOAT ? IRType::FLOAT : IRType::INT;
+        switch (expr->builtin) {
+            case Builtin::LEN:
+                if (args[0]->type == IRType::STRING) {
+                    lastValue = emit(Opcode::INTRINSIC, IRType::INT, args);
+                    lastValue->symbol = "strlen";
+                    return;
+                }
+                lastValue = emit(Opcode::ALEN, IRType::INT, args);
+                return;
+            case Builtin::STR:
+                element = IRType::STRING;
+                break;
+            case Builtin::DOT:
+                if (args[1]->type == IRType::FLOAT_ARRAY) element = IRType::FLOAT;
+                break;
+            default:
+                break;
+        }
+        lastValue = emit(Opcode::INTRINSIC, element, args);
+        lastValue->symbol = callee->name.lexeme;
+        return;
+    }
+    auto found = callee ? signatures.find(callee->name.lexeme) : signatures.end();
+    if (found == signatures.end()) {
+        throw std::runtime_error("Call target at line " + std::to_string(expr->paren.line) + " is not a known function.");
+    }
+    const Signature& sig = found->second;
+
+    std::vector<Instruction*> args;
+    for (const auto& arg : expr->arguments) args.push_back(lower(arg.get()));
+    lastValue = emit(Opcode::CALL, sig.returnType, args);
+    lastValue->symbol = callee->name.lexeme;
+}
+
+void IRBuilder::visitArrayExpr(ArrayExpr* expr) {
+    IRType type = irTypeOf(arrayTypeOf(expr->elementType));
+    if (expr->length) {
+        expr->length->accept(this);
+        lastValue = emit(Opcode::NEWARRAY, type, {lastValue});
+        return;
+    }
+    Instruction* array = emit(Opcode::NEWARRAY, type, {function->constant(IRType::INT, (int)expr->elements.size())});
+    for (size_t i = 0; i < expr->elements.size(); i++) {
+        Instruction* value = lower(expr->elements[i].get());
+        emit(Opcode::ASTORE, IRType::VOID, {array, function->constant(IRType::INT, (int)i), value});
+    }
+    lastValue = array;
+}
+
+void IRBuilder::visitIndexExpr(IndexExpr* expr) {
+    expr->array->accept(this);
+    Instruction* array = lastValue;
+    expr->index->accept(this);
+    IRType element = array->type == IRType::FLOAT_ARRAY ? IRType::FLOAT : IRType::INT;
+    lastValue = emit(Opcode::ALOAD, element, {array, lastValue});
+}
+
+void IRBuilder::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    expr->array->accept(this);
+    Instruction* array = lastValue;
+    expr->index->accept(this);
+    Instruction* index = lastValue;
+    Instruction* value = lower(expr->value.get());
+    emit(Opcode::ASTORE, IRType::VOID, {array, index, value});
+    lastValue = value;
+}
+
+// --- Statements ---
+
+void IRBuilder::visitExpressionStmt(ExpressionStmt* stmt) {
+    stmt->expression->accept(this);
+}
+
+void IRBuilder::visitPrintStmt(PrintStmt* stmt) {
+    stmt->expression->accept(this);
+    emit(Opcode::PRINT, IRType::VOID, {lastValue});
+}
+
+void IRBuilder::visitVarStmt(VarStmt* stmt) {
+    IRType type = irTypeOf(stmt->type.type);
+    Instruction* value;
+    if (stmt->initializer) {
+        value = lower(stmt->initializer.get());
+    } else {
+        value = defaultValue(type);
+    }
+
+    if (atGlobalScope()) {
+        module->globals.push_back({stmt->name.lexeme, type});
+        scopes.back()[stmt->name.lexeme] = {true, -1, type};
+        Instruction* store = emit(Opcode::GSTORE, IRType::VOID, {value});
+        store->symbol = stmt->name.lexeme;
+    } else {
+        int var = newVariable(type);
+        writeVariable(var, block, value);
+        scopes.back()[stmt->name.lexeme] = {false, var, type};
+    }
+}
+
+void IRBuilder::visitBlockStmt(BlockStmt* stmt) {
+    scopes.emplace_back();
+    for (const auto& s : stmt->statements) {
+        s->accept(this);
+    }
+    scopes.pop_back();
+}
+
+void IRBuilder::visitIfStmt(IfStmt* stmt) {
+    stmt->condition->accept(this);
+    Instruction* cond = lastValue;
+
+    BasicBlock* thenBlock = createBlock("if.then");
+    BasicBlock* elseBlock = stmt->elseBranch ? createBlock("if.else") : nullptr;
+    BasicBlock* merge = createBlock("if.end");
+    condBranch(cond, thenBlock, elseBlock ? elseBlock : merge);
+    if (const ExecutionProfile::BranchCounts* counts = profile ? profile->find(stmt) : nullptr) {
+        block->terminator()->weights = {counts->taken, counts->notTaken};
+    }
+
+    sealBlock(thenBlock);
+    block = thenBlock;
+    stmt->thenBranch->accept(this);
+    branch(merge);
+
+    if (elseBlock) {
+        sealBlock(elseBlock);
+        block = elseBlock;
+        stmt->elseBranch->accept(this);
+        branch(merge);
+    }
+
+    sealBlock(merge);
+    block = merge;
+}
+
+void IRBuilder::visitWhileStmt(WhileStmt* stmt) {
+    // The current block ends in an unconditional branch to the header,
+    // which makes it the loop preheader LICM hoists into.
+    BasicBlock* header = createBlock("while.cond");
+    BasicBlock* body = createBlock("while.body");
+    BasicBlock* exit = createBlock("while.end");
+    branch(header);
+
+    block = header; // Sealed once the back edge exists
+    stmt->condition->accept(this);
+    condBranch(lastValue, body, exit);
+    if (const ExecutionProfile::BranchCounts* counts = profile ? profile->find(stmt) : nullptr) {
+        block->terminator()->weights = {counts->taken, counts->notTaken};
+    }
+
+    sealBlock(body);
+    block = body;
+    stmt->body->accept(this);
+    branch(header);
+
+    sealBlock(header);
+    sealBlock(exit);
+    block = exit;
+}
+
+// Lowered as the equivalent sequential loop; the IR has no notion of
+// concurrency, and running the iterations in order is one valid schedule.
+void IRBuilder::visitParallelForStmt(ParallelForStmt* stmt) {
+    stmt->start->accept(this);
+    Instruction* start = lastValue;
+    stmt->end->accept(this);
+    Instruction* end = lastValue; // Evaluated once, before the first iteration
+
+    scopes.emplace_back();
+    int var = newVariable(IRType::INT);
+    writeVariable(var, block, start);
+    scopes.back()[stmt->name.lexeme] = {false, var, IRType::INT};
+
+    BasicBlock* header = createBlock("pfor.cond");
+    BasicBlock* body = createBlock("pfor.body");
+    BasicBlock* exit = createBlock("pfor.end");
+    branch(header);
+
+    block = header;
+    Instruction* cond = emit(Opcode::ICMP_LT, IRType::BOOL, {readVariable(var, block), end});
+    condBranch(cond, body, exit);
+
+    sealBlock(body);
+    block = body;
+    stmt->body->accept(this);
+    Instruction* next = emit(Opcode::IADD, IRType::INT, {readVariable(var, block), function->constant(IRType::INT, 1)});
+    writeVariable(var, block, next);
+    branch(header);
+
+    sealBlock(header);
+    sealBlock(exit);
+    block = exit;
+    scopes.pop_back();
+}
+
+void IRBuilder::visitReturnStmt(ReturnStmt* stmt) {
+    Instruction* ret;
+    if (stmt->value) {
+        Instruction* value = lower(stmt->value.get());
+        ret = emit(Opcode::RET, IRType::VOID, {value});
+    } else {
+        ret = emit(Opcode::RET, IRType::VOID);
+        if (function->returnType != IRType::VOID) ret->operands.push_back(defaultValue(function->returnType));
+    }
+    startDeadBlock();
+}
+
+void IRBuilder::visitFunctionStmt(FunctionStmt* stmt) {
+    Signature sig;
+    sig.returnType = irTypeOf(stmt->returnType.type);
+    for (const auto& type : stmt->paramTypes) {
+        sig.paramTypes.push_back(irTypeOf(type.type));
+    }
+    signatures[stmt->name.lexeme] = sig;
+    pendingFunctions.push_back(stmt);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include "../data/AST.h"
+#include "../data/execution-profile.h"
+#include "../data/IR.h"
+
+// Lowers a semantically valid AST into SSA form.
+// SSA values are constructed on the fly while walking the AST, following
+// Braun et al., "Simple and Efficient Construction of Static Single
+// Assignment Form" (blocks are sealed once all predecessors are known).
+class IRBuilder : public ASTVisitor {
+public:
+    const ExecutionProfile* profile = nullptr; // Optional: adds branch weights to CONDBR
+
+private:
+    struct VarSlot {
+        bool global;
+        int varId;    // index into currentDef for locals
+        IRType type;
+    };
+
+    struct Signature {
+        IRType returnType;
+        std::vector<IRType> paramTypes;
+    };
+
+    Module* module = nullptr;
+    Function* function = nullptr;
+    BasicBlock* block = nullptr; // insertion point
+    std::vector<std::map<std::string, VarSlot>> scopes;
+    std::map<std::string, Signature> signatures;
+    std::vector<FunctionStmt*> pendingFunctions;
+
+    // SSA construction state, reset for each function
+    std::vector<std::unordered_map<BasicBlock*, Instruction*>> currentDef;
+    std::vector<IRType> varTypes;
+    std::unordered_map<BasicBlock*, std::vector<std::pair<int, Instruction*>>> incompletePhis;
+    std::unordered_set<BasicBlock*> sealed;
+
+    // Value of the last visited expression
+    Instruction* lastValue = nullptr;
+
+    void beginFunction(const std::string& name, IRType returnType);
+    void endFunction();
+    void buildFunction(FunctionStmt* stmt);
+    bool atGlobalScope();
+    bool lookup(const std::string& name, VarSlot& outSlot);
+
+    BasicBlock* createBlock(const std::string& label);
+    Instruction* emit(Opcode op, IRType type, std::vector<Instruction*> operands = {});
+    void branch(BasicBlock* target);
+    void condBranch(Instruction* cond, BasicBlock* ifTrue, BasicBlock* ifFalse);
+    void startDeadBlock();
+    Instruction* convert(Instruction* value, IRType to);
+    Instruction* lower(Expression* expr);
+    Instruction* defaultValue(IRType type);
+
+    int newVariable(IRType type);
+    void writeVariable(int var, BasicBlock* b, Instruction* value);
+    Instruction* readVariable(int var, BasicBlock* b);
+    Instruction* readVariableRecursive(int var, BasicBlock* b);
+    Instruction* newPhi(BasicBlock* b, IRType type);
+    void addPhiOperands(int var, Instruction* phi);
+    void sealBlock(BasicBlock* b);
+
+    void removeUnreachableBlocks();
+    void removeTrivialPhis();
+
+public:
+    std::unique_ptr<Module> build(const std::vector<std::unique_ptr<Statement>>& statements);
+
+    void visitBinaryExpr(BinaryExpr* expr) override;
+    void visitGroupingExpr(GroupingExpr* expr) override;
+    void visitLiteralExpr(LiteralExpr* expr) override;
+    void visitUnaryExpr(UnaryExpr* expr) override;
+    void visitVariableExpr(VariableExpr* expr) override;
+    void visitAssignExpr(AssignExpr* expr) override;
+    void visitCallExpr(CallExpr* expr) override;
+    void visitArrayExpr(ArrayExpr* expr) override;
+    void visitIndexExpr(IndexExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitExpressionStmt(ExpressionStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitIfStmt(IfStmt* stmt) override;
+    void visitPrintStmt(PrintStmt* stmt) override;
+    void visitReturnStmt(ReturnStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+    void visitWhileStmt(WhileStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+};
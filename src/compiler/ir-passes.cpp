@@ -0,0 +1,507 @@
+#include "ir-passes.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <set>
+
+// --- Dominator tree ---
+
+DominatorTree::DominatorTree(Function& fn) {
+    // Iterative DFS for the postorder
+    std::vector<BasicBlock*> postorder;
+    std::unordered_map<BasicBlock*, bool> visited;
+    std::vector<std::pair<BasicBlock*, size_t>> stack;
+    stack.push_back({fn.entry(), 0});
+    visited[fn.entry()] = true;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        if (top.second < top.first->succs.size()) {
+            BasicBlock* succ = top.first->succs[top.second++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+            }
+        } else {
+            postorder.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < rpo.size(); i++) order[rpo[i]] = (int)i;
+
+    idom.assign(rpo.size(), -1);
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); i++) {
+            int newIdom = -1;
+            for (BasicBlock* pred : rpo[i]->preds) {
+                auto found = order.find(pred);
+                if (found == order.end() || idom[found->second] == -1) continue;
+                newIdom = newIdom == -1 ? found->second : intersect(found->second, newIdom);
+            }
+            if (newIdom != idom[i]) {
+                idom[i] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    children.assign(rpo.size(), {});
+    for (size_t i = 1; i < rpo.size(); i++) {
+        children[idom[i]].push_back(rpo[i]);
+    }
+}
+
+int DominatorTree::intersect(int a, int b) const {
+    while (a != b) {
+        while (a > b) a = idom[a];
+        while (b > a) b = idom[b];
+    }
+    return a;
+}
+
+bool DominatorTree::dominates(BasicBlock* a, BasicBlock* b) const {
+    int target = order.at(a);
+    int current = order.at(b);
+    while (current != target) {
+        if (current == 0) return false;
+        current = idom[current];
+    }
+    return true;
+}
+
+// --- GVN ---
+
+namespace {
+
+struct ValueKey {
+    Opcode op;
+    IRType type;
+    Instruction* left;
+    Instruction* right;
+
+    bool operator==(const ValueKey& other) const {
+        return op == other.op && type == other.type && left == other.left && right == other.right;
+    }
+};
+
+struct ValueKeyHash {
+    size_t operator()(const ValueKey& key) const {
+        size_t h = std::hash<int>()((int)key.op) * 31 + std::hash<int>()((int)key.type);
+        h = h * 31 + std::hash<Instruction*>()(key.left);
+        return h * 31 + std::hash<Instruction*>()(key.right);
+    }
+};
+
+bool isCommutative(Opcode op) {
+    switch (op) {
+        case Opcode::IADD: case Opcode::IMUL: case Opcode::FADD: case Opcode::FMUL:
+        case Opcode::ICMP_EQ: case Opcode::ICMP_NE: case Opcode::FCMP_EQ: case Opcode::FCMP_NE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Integer arithmetic wraps at 32 bits
+int wrap(long long value) { return (int)(uint32_t)(uint64_t)value; }
+
+bool isIntConstant(Instruction* value, int expected) {
+    return value->op == Opcode::CONST && value->type == IRType::INT && value->intValue == expected;
+}
+
+// x + 0, x - 0, x * 1, x / 1 and x * 0 for ints
+Instruction* simplifyIdentity(Function& fn, Instruction* inst) {
+    if (inst->operands.size() != 2) return nullptr;
+    Instruction* a = inst->operands[0];
+    Instruction* b = inst->operands[1];
+    switch (inst->op) {
+        case Opcode::IADD:
+            if (isIntConstant(a, 0)) return b;
+            if (isIntConstant(b, 0)) return a;
+            return nullptr;
+        case Opcode::ISUB:
+            return isIntConstant(b, 0) ? a : nullptr;
+        case Opcode::IMUL:
+            if (isIntConstant(a, 1)) return b;
+            if (isIntConstant(b, 1)) return a;
+            if (isIntConstant(a, 0) || isIntConstant(b, 0)) return fn.zero(IRType::INT);
+            return nullptr;
+        case Opcode::IDIV:
+            return isIntConstant(b, 1) ? a : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+// Returns the folded value, or nullptr if the instruction has to stay.
+Instruction* fold(Function& fn, Instruction* inst) {
+    for (Instruction* operand : inst->operands) {
+        if (operand->op != Opcode::CONST) return simplifyIdentity(fn, inst);
+    }
+    if (inst->mayTrap()) return nullptr;
+
+    long long a = inst->operands.size() > 0 ? inst->operands[0]->intValue : 0;
+    long long b = inst->operands.size() > 1 ? inst->operands[1]->intValue : 0;
+    double x = inst->operands.size() > 0 ? inst->operands[0]->floatValue : 0.0;
+    double y = inst->operands.size() > 1 ? inst->operands[1]->floatValue : 0.0;
+
+    switch (inst->op) {
+        case Opcode::IADD: return fn.constant(IRType::INT, wrap(a + b));
+        case Opcode::ISUB: return fn.constant(IRType::INT, wrap(a - b));
+        case Opcode::IMUL: return fn.constant(IRType::INT, wrap(a * b));
+        case Opcode::IDIV: return fn.constant(IRType::INT, wrap(a / b));
+        case Opcode::INEG: return fn.constant(IRType::INT, wrap(-a));
+        case Opcode::FADD: return fn.constant(IRType::FLOAT, 0, x + y);
+        case Opcode::FSUB: return fn.constant(IRType::FLOAT, 0, x - y);
+        case Opcode::FMUL: return fn.constant(IRType::FLOAT, 0, x * y);
+        case Opcode::FDIV: return fn.constant(IRType::FLOAT, 0, x / y);
+        case Opcode::FNEG: return fn.constant(IRType::FLOAT, 0, -x);
+        case Opcode::ICMP_EQ: return fn.constant(IRType::BOOL, a == b);
+        case Opcode::ICMP_NE: return fn.constant(IRType::BOOL, a != b);
+        case Opcode::ICMP_LT: return fn.constant(IRType::BOOL, a < b);
+        case Opcode::ICMP_LE: return fn.constant(IRType::BOOL, a <= b);
+        case Opcode::ICMP_GT: return fn.constant(IRType::BOOL, a > b);
+        case Opcode::ICMP_GE: return fn.constant(IRType::BOOL, a >= b);
+        case Opcode::FCMP_EQ: return fn.constant(IRType::BOOL, x == y);
+        case Opcode::FCMP_NE: return fn.constant(IRType::BOOL, x != y);
+        case Opcode::FCMP_LT: return fn.constant(IRType::BOOL, x < y);
+        case Opcode::FCMP_LE: return fn.constant(IRType::BOOL, x <= y);
+        case Opcode::FCMP_GT: return fn.constant(IRType::BOOL, x > y);
+        case Opcode::FCMP_GE: return fn.constant(IRType::BOOL, x >= y);
+        case Opcode::NOT: return fn.constant(IRType::BOOL, !a);
+        case Opcode::ITOF: return fn.constant(IRType::FLOAT, 0, (double)a);
+        default: return nullptr;
+    }
+}
+
+} // namespace
+
+bool GVNPass::run(Function& fn) {
+    DominatorTree domTree(fn);
+    std::unordered_map<ValueKey, Instruction*, ValueKeyHash> table;
+    std::unordered_map<Instruction*, Instruction*> replacements;
+
+    auto resolve = [&](Instruction* v) {
+        auto found = replacements.find(v);
+        while (found != replacements.end()) {
+            v = found->second;
+            found = replacements.find(v);
+        }
+        return v;
+    };
+
+    // Walk the dominator tree; entries added in a block are only visible
+    // to the blocks it dominates, so they are removed on the way back up.
+    std::function<void(BasicBlock*)> visit = [&](BasicBlock* b) {
+        std::vector<ValueKey> added;
+        std::map<std::string, Instruction*> knownGlobals; // Block-local memory state
+
+        for (auto& ptr : b->instructions) {
+            Instruction* inst = ptr.get();
+            for (auto& operand : inst->operands) operand = resolve(operand);
+
+            if (inst->op == Opcode::GLOAD) {
+                auto found = knownGlobals.find(inst->symbol);
+                if (found != knownGlobals.end()) replacements[inst] = found->second;
+                else knownGlobals[inst->symbol] = inst;
+                continue;
+            }
+            if (inst->op == Opcode::GSTORE) {
+                knownGlobals[inst->symbol] = inst->operands[0];
+                continue;
+            }
+            if (inst->op == Opcode::CALL) {
+                knownGlobals.clear();
+                continue;
+            }
+            if (!inst->isPure()) continue;
+
+            if (Instruction* folded = fold(fn, inst)) {
+                replacements[inst] = folded;
+                continue;
+            }
+
+            ValueKey key = {inst->op, inst->type, inst->operands[0],
+                            inst->operands.size() > 1 ? inst->operands[1] : nullptr};
+            if (isCommutative(key.op) && key.right && key.right->id < key.left->id) std::swap(key.left, key.right);
+
+            auto found = table.find(key);
+            if (found != table.end()) {
+                replacements[inst] = found->second;
+            } else {
+                table[key] = inst;
+                added.push_back(key);
+            }
+        }
+
+        for (BasicBlock* child : domTree.childrenOf(b)) visit(child);
+        for (const auto& key : added) table.erase(key);
+    };
+    visit(fn.entry());
+
+    // Phi operands on back edges can still name replaced values
+    fn.replaceAllUses(replacements);
+    std::unordered_set<Instruction*> dead;
+    for (auto& entry : replacements) dead.insert(entry.first);
+    fn.erase(dead);
+    return !replacements.empty();
+}
+
+// --- LICM ---
+
+bool LICMPass::run(Function& fn) {
+    DominatorTree domTree(fn);
+
+    // Natural loops, merged per header: a back edge is an edge to a dominator
+    std::map<BasicBlock*, std::set<BasicBlock*>> loops;
+    for (BasicBlock* b : domTree.reversePostorder()) {
+        for (BasicBlock* succ : b->succs) {
+            if (!domTree.dominates(succ, b)) continue;
+            std::set<BasicBlock*>& body = loops[succ];
+            body.insert(succ);
+            std::vector<BasicBlock*> worklist = {b};
+            while (!worklist.empty()) {
+                BasicBlock* current = worklist.back();
+                worklist.pop_back();
+                if (!body.insert(current).second) continue;
+                for (BasicBlock* pred : current->preds) worklist.push_back(pred);
+            }
+        }
+    }
+
+    // Inner loops first, so their hoisted code can move further out
+    std::vector<std::pair<BasicBlock*, std::set<BasicBlock*>*>> ordered;
+    for (auto& entry : loops) ordered.push_back({entry.first, &entry.second});
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const auto& a, const auto& b) { return a.second->size() < b.second->size(); });
+
+    bool changed = false;
+    for (auto& entry : ordered) {
+        BasicBlock* header = entry.first;
+        const std::set<BasicBlock*>& body = *entry.second;
+
+        BasicBlock* preheader = nullptr;
+        int outsidePreds = 0;
+        for (BasicBlock* pred : header->preds) {
+            if (body.count(pred) == 0) {
+                preheader = pred;
+                outsidePreds++;
+            }
+        }
+        if (outsidePreds != 1 || preheader->succs.size() != 1) continue;
+
+        bool hasCall = false;
+        std::set<std::string> storedGlobals;
+        for (BasicBlock* b : body) {
+            for (auto& inst : b->instructions) {
+                if (inst->op == Opcode::CALL) hasCall = true;
+                if (inst->op == Opcode::GSTORE) storedGlobals.insert(inst->symbol);
+            }
+        }
+
+        auto isInvariant = [&](Instruction* inst) {
+            bool movable = (inst->isPure() && !inst->mayTrap()) ||
+                           (inst->op == Opcode::GLOAD && !hasCall && storedGlobals.count(inst->symbol) == 0);
+            if (!movable) return false;
+            for (Instruction* operand : inst->operands) {
+                if (operand->parent && body.count(operand->parent)) return false;
+            }
+            return true;
+        };
+
+        bool hoisted = true;
+        while (hoisted) {
+            hoisted = false;
+            for (BasicBlock* b : domTree.reversePostorder()) {
+                if (body.count(b) == 0) continue;
+                auto& list = b->instructions;
+                for (size_t i = 0; i < list.size();) {
+                    if (!isInvariant(list[i].get())) {
+                        i++;
+                        continue;
+                    }
+                    std::unique_ptr<Instruction> inst = std::move(list[i]);
+                    list.erase(list.begin() + i);
+                    inst->parent = preheader;
+                    auto& target = preheader->instructions;
+                    target.insert(target.end() - 1, std::move(inst)); // Before the branch
+                    hoisted = changed = true;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+// --- DCE ---
+
+bool DCEPass::run(Function& fn) {
+    std::unordered_set<Instruction*> live;
+    std::vector<Instruction*> worklist;
+    for (auto& b : fn.blocks) {
+        for (auto& inst : b->instructions) {
+            switch (inst->op) {
+                case Opcode::GSTORE: case Opcode::CALL: case Opcode::PRINT: case Opcode::ASTORE:
+                case Opcode::BR: case Opcode::CONDBR: case Opcode::RET:
+                    live.insert(inst.get());
+                    worklist.push_back(inst.get());
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        Instruction* inst = worklist.back();
+        worklist.pop_back();
+        for (Instruction* operand : inst->operands) {
+            if (live.insert(operand).second) worklist.push_back(operand);
+        }
+    }
+
+    std::unordered_set<Instruction*> dead;
+    for (auto& b : fn.blocks) {
+        for (auto& inst : b->instructions) {
+            if (live.count(inst.get()) == 0) dead.insert(inst.get());
+        }
+    }
+    fn.erase(dead);
+    fn.dropUnusedConstants(live);
+    return !dead.empty();
+}
+
+// --- Block layout ---
+
+namespace {
+
+// Profiled count of the edge from -> to, or -1 when it was not profiled
+long long edgeWeight(BasicBlock* from, BasicBlock* to) {
+    Instruction* term = from->terminator();
+    if (!term || term->weights.empty()) return -1;
+    long long weight = 0;
+    for (size_t i = 0; i < term->blocks.size(); i++) {
+        if (term->blocks[i] == to) weight += term->weights[i];
+    }
+    return weight;
+}
+
+} // namespace
+
+bool BlockLayoutPass::run(Function& fn) {
+    bool profiled = false;
+    for (auto& b : fn.blocks) {
+        Instruction* term = b->terminator();
+        profiled = profiled || (term && !term->weights.empty());
+    }
+    if (!profiled) return false;
+
+    // A block is cold when no edge that ran reaches it from a warm block.
+    // In reverse postorder every predecessor except a loop's back edge has
+    // been decided already, and a back edge alone cannot warm a loop.
+    DominatorTree dom(fn);
+    std::unordered_set<BasicBlock*> decided, cold;
+    for (BasicBlock* b : dom.reversePostorder()) {
+        bool warm = b == fn.entry();
+        for (BasicBlock* pred : b->preds) {
+            if (decided.count(pred) && !cold.count(pred) && edgeWeight(pred, b) != 0) warm = true;
+        }
+        if (!warm) cold.insert(b);
+        decided.insert(b);
+    }
+
+    // Chain warm blocks along their heaviest successor; unprofiled edges
+    // prefer the first target, as the builder laid them out.
+    std::vector<BasicBlock*> order;
+    std::unordered_set<BasicBlock*> placed;
+    size_t warmCount = fn.blocks.size() - cold.size();
+    BasicBlock* next = fn.entry();
+    while (order.size() < warmCount) {
+        if (!next) {
+            for (auto& b : fn.blocks) {
+                if (!placed.count(b.get()) && !cold.count(b.get())) {
+                    next = b.get();
+                    break;
+                }
+            }
+        }
+        order.push_back(next);
+        placed.insert(next);
+
+        BasicBlock* best = nullptr;
+        long long bestWeight = -2;
+        for (BasicBlock* succ : next->succs) {
+            if (placed.count(succ) || cold.count(succ)) continue;
+            long long weight = edgeWeight(next, succ);
+            if (weight > bestWeight) {
+                best = succ;
+                bestWeight = weight;
+            }
+        }
+        next = best;
+    }
+    for (auto& b : fn.blocks) {
+        if (cold.count(b.get())) order.push_back(b.get());
+    }
+
+    bool changed = false;
+    std::unordered_map<BasicBlock*, std::unique_ptr<BasicBlock>> owned;
+    for (size_t i = 0; i < fn.blocks.size(); i++) {
+        changed = changed || fn.blocks[i].get() != order[i];
+        owned[fn.blocks[i].get()] = std::move(fn.blocks[i]);
+    }
+    for (size_t i = 0; i < order.size(); i++) fn.blocks[i] = std::move(owned[order[i]]);
+    return changed;
+}
+
+// --- Pass manager ---
+
+void PassManager::addPass(std::unique_ptr<FunctionPass> pass) {
+    timings.push_back({pass->name()});
+    passes.push_back(std::move(pass));
+}
+
+void PassManager::run(Module& module) {
+    for (size_t i = 0; i < passes.size(); i++) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto& fn : module.functions) {
+            if (passes[i]->run(*fn)) timings[i].changedFunctions++;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        timings[i].seconds += elapsed.count();
+    }
+}
+
+void PassManager::printTimings(std::ostream& out) const {
+    double total = 0.0;
+    for (const auto& t : timings) total += t.seconds;
+
+    out << "=== Pass execution timing ===" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& t : timings) {
+        double percent = total > 0 ? 100.0 * t.seconds / total : 0.0;
+        out << "  " << std::left << std::setw(8) << t.pass << std::right
+            << std::setw(10) << t.seconds * 1000.0 << " ms  "
+            << std::setw(6) << std::setprecision(1) << percent << "%  "
+            << t.changedFunctions << " function(s) changed" << std::setprecision(3) << std::endl;
+    }
+    out << "  " << std::left << std::setw(8) << "total" << std::right
+        << std::setw(10) << total * 1000.0 << " ms" << std::endl;
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+PassManager PassManager::standard() {
+    PassManager pm;
+    pm.addPass(std::make_unique<GVNPass>());
+    pm.addPass(std::make_unique<LICMPass>());
+    // Hoisting can expose new redundancies in the preheader
+    pm.addPass(std::make_unique<GVNPass>());
+    pm.addPass(std::make_unique<DCEPass>());
+    pm.addPass(std::make_unique<BlockLayoutPass>());
+    return pm;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../data/IR.h"
+
+// Immediate dominators computed with the iterative algorithm from
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm".
+class DominatorTree {
+private:
+    std::unordered_map<BasicBlock*, int> order; // Reverse postorder index
+    std::vector<BasicBlock*> rpo;
+    std::vector<int> idom;
+    std::vector<std::vector<BasicBlock*>> children;
+
+    int intersect(int a, int b) const;
+
+public:
+    DominatorTree(Function& fn);
+
+    const std::vector<BasicBlock*>& reversePostorder() const { return rpo; }
+    const std::vector<BasicBlock*>& childrenOf(BasicBlock* b) const { return children[order.at(b)]; }
+    bool dominates(BasicBlock* a, BasicBlock* b) const;
+};
+
+class FunctionPass {
+public:
+    virtual ~FunctionPass() = default;
+    virtual const char* name() const = 0;
+    // Returns true if the function was changed
+    virtual bool run(Function& fn) = 0;
+};
+
+// Global value numbering over the dominator tree. Also folds constant
+// arithmetic and integer identities, and forwards stored globals to later
+// loads in the same block.
+class GVNPass : public FunctionPass {
+public:
+    const char* name() const override { return "gvn"; }
+    bool run(Function& fn) override;
+};
+
+// Hoists loop-invariant, non-trapping computations into the loop preheader.
+// Global loads are invariant when the loop contains no call and no store to them.
+class LICMPass : public FunctionPass {
+public:
+    const char* name() const override { return "licm"; }
+    bool run(Function& fn) override;
+};
+
+// Removes instructions (including phis) whose values are never used.
+class DCEPass : public FunctionPass {
+public:
+    const char* name() const override { return "dce"; }
+    bool run(Function& fn) override;
+};
+
+// Orders blocks so that each one is followed by its most frequent successor
+// and moves blocks that never ran to the end of the function. Only acts on
+// functions with profiled branch weights (see --profile-use).
+class BlockLayoutPass : public FunctionPass {
+public:
+    const char* name() const override { return "layout"; }
+    bool run(Function& fn) override;
+};
+
+class PassManager {
+private:
+    struct Timing {
+        std::string pass;
+        double seconds = 0.0;
+        int changedFunctions = 0;
+    };
+
+    std::vector<std::unique_ptr<FunctionPass>> passes;
+    std::vector<Timing> timings;
+
+public:
+    void addPass(std::unique_ptr<FunctionPass> pass);
+    void run(Module& module);
+    void printTimings(std::ostream& out) const;
+
+    // The default optimization pipeline
+    static PassManager standard();
+};
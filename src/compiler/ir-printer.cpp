@@ -0,0 +1,184 @@
+#include "ir-printer.h"
+#include <sstream>
+
+static const char* opcodeName(Opcode op) {
+    switch (op) {
+        case Opcode::CONST: return "const";
+        case Opcode::PARAM: return "param";
+        case Opcode::PHI: return "phi";
+        case Opcode::IADD: return "iadd";
+        case Opcode::ISUB: return "isub";
+        case Opcode::IMUL: return "imul";
+        case Opcode::IDIV: return "idiv";
+        case Opcode::INEG: return "ineg";
+        case Opcode::FADD: return "fadd";
+        case Opcode::FSUB: return "fsub";
+        case Opcode::FMUL: return "fmul";
+        case Opcode::FDIV: return "fdiv";
+        case Opcode::FNEG: return "fneg";
+        case Opcode::ICMP_EQ: return "icmp.eq";
+        case Opcode::ICMP_NE: return "icmp.ne";
+        case Opcode::ICMP_LT: return "icmp.lt";
+        case Opcode::ICMP_LE: return "icmp.le";
+        case Opcode::ICMP_GT: return "icmp.gt";
+        case Opcode::ICMP_GE: return "icmp.ge";
+        case Opcode::FCMP_EQ: return "fcmp.eq";
+        case Opcode::FCMP_NE: return "fcmp.ne";
+        case Opcode::FCMP_LT: return "fcmp.lt";
+        case Opcode::FCMP_LE: return "fcmp.le";
+        case Opcode::FCMP_GT: return "fcmp.gt";
+        case Opcode::FCMP_GE: return "fcmp.ge";
+        case Opcode::NOT: return "not";
+        case Opcode::ITOF: return "itof";
+        case Opcode::GLOAD: return "gload";
+        case Opcode::GSTORE: return "gstore";
+        case Opcode::CALL: return "call";
+        case Opcode::PRINT: return "print";
+        case Opcode::NEWARRAY: return "newarray";
+        case Opcode::ALOAD: return "aload";
+        case Opcode::ASTORE: return "astore";
+        case Opcode::ALEN: return "alen";
+        case Opcode::INTRINSIC: return "intrinsic";
+        case Opcode::BR: return "br";
+        case Opcode::CONDBR: return "condbr";
+        case Opcode::RET: return "ret";
+    }
+    return "?";
+}
+
+void IRPrinter::print(const Module& module) {
+    for (const auto& global : module.globals) {
+        out << "global " << irTypeName(global.type) << " @" << global.name << std::endl;
+    }
+    if (!module.globals.empty()) out << std::endl;
+
+    for (const auto& fn : module.functions) {
+        print(*fn);
+        out << std::endl;
+    }
+}
+
+void IRPrinter::print(const Function& fn) {
+    out << "func " << irTypeName(fn.returnType) << " @" << fn.name << "(";
+    for (size_t i = 0; i < fn.params.size(); i++) {
+        if (i > 0) out << ", ";
+        out << irTypeName(fn.params[i]->type) << " %" << fn.params[i]->id << " " << fn.params[i]->symbol;
+    }
+    out << ") {" << std::endl;
+
+    for (const auto& b : fn.blocks) {
+        out << b->label << ":";
+        if (!b->preds.empty()) {
+            out << "    ; preds = ";
+            for (size_t i = 0; i < b->preds.size(); i++) {
+                if (i > 0) out << ", ";
+                out << b->preds[i]->label;
+            }
+        }
+        out << std::endl;
+        for (const auto& inst : b->instructions) {
+            out << "  ";
+            printInstruction(inst.get());
+            out << std::endl;
+        }
+    }
+    out << "}" << std::endl;
+}
+
+// Constants are printed inline at their uses
+void IRPrinter::printValue(const Instruction* value) {
+    if (value->op != Opcode::CONST) {
+        out << "%" << value->id;
+        return;
+    }
+    switch (value->type) {
+        case IRType::BOOL:
+            out << (value->intValue ? "true" : "false");
+            break;
+        case IRType::STRING:
+            out << '"';
+            for (char c : value->symbol) {
+                if (c == '\n') out << "\\n";
+                else if (c == '\t') out << "\\t";
+                else if (c == '"' || c == '\\') out << '\\' << c;
+                else out << c;
+            }
+            out << '"';
+            break;
+        case IRType::FLOAT: {
+            std::ostringstream text;
+            text << value->floatValue;
+            std::string s = text.str();
+            if (s.find_first_of(".eni") == std::string::npos) s += ".0";
+            out << s;
+            break;
+        }
+        default:
+            out << value->intValue;
+            break;
+    }
+}
+
+void IRPrinter::printInstruction(const Instruction* inst) {
+    switch (inst->op) {
+        case Opcode::PHI:
+            out << "%" << inst->id << " = phi " << irTypeName(inst->type) << " ";
+            for (size_t i = 0; i < inst->operands.size(); i++) {
+                if (i > 0) out << ", ";
+                out << "[ ";
+                printValue(inst->operands[i]);
+                out << ", " << inst->blocks[i]->label << " ]";
+            }
+            return;
+        case Opcode::GLOAD:
+            out << "%" << inst->id << " = gload " << irTypeName(inst->type) << " @" << inst->symbol;
+            return;
+        case Opcode::GSTORE:
+            out << "gstore @" << inst->symbol << ", ";
+            printValue(inst->operands[0]);
+            return;
+        case Opcode::CALL:
+        case Opcode::INTRINSIC:
+            out << "%" << inst->id << " = " << opcodeName(inst->op) << " " << irTypeName(inst->type) << " @" << inst->symbol << "(";
+            for (size_t i = 0; i < inst->operands.size(); i++) {
+                if (i > 0) out << ", ";
+                printValue(inst->operands[i]);
+            }
+            out << ")";
+            return;
+        case Opcode::ASTORE:
+            out << "astore ";
+            for (size_t i = 0; i < inst->operands.size(); i++) {
+                if (i > 0) out << ", ";
+                printValue(inst->operands[i]);
+            }
+            return;
+        case Opcode::PRINT:
+            out << "print ";
+            printValue(inst->operands[0]);
+            return;
+        case Opcode::BR:
+            out << "br " << inst->blocks[0]->label;
+            return;
+        case Opcode::CONDBR:
+            out << "condbr ";
+            printValue(inst->operands[0]);
+            out << ", " << inst->blocks[0]->label << ", " << inst->blocks[1]->label;
+            if (!inst->weights.empty()) out << "    ; weights = " << inst->weights[0] << ", " << inst->weights[1];
+            return;
+        case Opcode::RET:
+            out << "ret";
+            if (!inst->operands.empty()) {
+                out << " ";
+                printValue(inst->operands[0]);
+            }
+            return;
+        default:
+            out << "%" << inst->id << " = " << opcodeName(inst->op) << " " << irTypeName(inst->type) << " ";
+            for (size_t i = 0; i < inst->operands.size(); i++) {
+                if (i > 0) out << ", ";
+                printValue(inst->operands[i]);
+            }
+            return;
+    }
+}
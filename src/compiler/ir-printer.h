@@ -0,0 +1,18 @@
+#pragma once
+#include <ostream>
+#include "../data/IR.h"
+
+// Textual dump of the IR, used by --dump-ir.
+class IRPrinter {
+private:
+    std::ostream& out;
+
+    void printValue(const Instruction* value);
+    void printInstruction(const Instruction* inst);
+
+public:
+    IRPrinter(std::ostream& out) : out(out) {}
+
+    void print(const Module& module);
+    void print(const Function& fn);
+};
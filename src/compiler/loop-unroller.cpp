@@ -0,0 +1,101 @@
+#include "loop-unroller.h"
+#include "ast-cloner.h"
+
+namespace {
+
+// Counts nodes and notes anything that makes a loop unsafe to duplicate
+class LoopShape : public ASTWalker {
+public:
+    int size = 0;
+    bool hasCall = false;
+    bool hasAssign = false;
+    bool hasFunction = false;
+
+    void visitBinaryExpr(BinaryExpr* expr) override { size++; ASTWalker::visitBinaryExpr(expr); }
+    void visitLiteralExpr(LiteralExpr*) override { size++; }
+    void visitUnaryExpr(UnaryExpr* expr) override { size++; ASTWalker::visitUnaryExpr(expr); }
+    void visitVariableExpr(VariableExpr*) override { size++; }
+    void visitAssignExpr(AssignExpr* expr) override {
+        size++;
+        hasAssign = true;
+        ASTWalker::visitAssignExpr(expr);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        size++;
+        hasCall = true;
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitArrayExpr(ArrayExpr* expr) override { size++; ASTWalker::visitArrayExpr(expr); }
+    void visitIndexExpr(IndexExpr* expr) override { size++; ASTWalker::visitIndexExpr(expr); }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        size++;
+        hasAssign = true;
+        ASTWalker::visitIndexAssignExpr(expr);
+    }
+
+    void visitExpressionStmt(ExpressionStmt* stmt) override { size++; ASTWalker::visitExpressionStmt(stmt); }
+    void visitFunctionStmt(FunctionStmt*) override { hasFunction = true; }
+    void visitIfStmt(IfStmt* stmt) override { size++; ASTWalker::visitIfStmt(stmt); }
+    void visitPrintStmt(PrintStmt* stmt) override { size++; ASTWalker::visitPrintStmt(stmt); }
+    void visitReturnStmt(ReturnStmt* stmt) override { size++; ASTWalker::visitReturnStmt(stmt); }
+    void visitVarStmt(VarStmt* stmt) override { size++; ASTWalker::visitVarStmt(stmt); }
+    void visitWhileStmt(WhileStmt* stmt) override { size++; ASTWalker::visitWhileStmt(stmt); }
+    void visitParallelForStmt(ParallelForStmt* stmt) override { size++; ASTWalker::visitParallelForStmt(stmt); }
+};
+
+} // namespace
+
+int LoopUnroller::run(std::vector<std::unique_ptr<Statement>>& program) {
+    unrolled = 0;
+    rewrite(program);
+    return unrolled;
+}
+
+int LoopUnroller::unrollFactor(WhileStmt* loop) {
+    const ExecutionProfile::BranchCounts* counts = profile.find(loop);
+    if (!counts || counts->taken < kMinIterations) return 1;
+    long long entries = counts->notTaken > 0 ? counts->notTaken : 1;
+    long long averageTrips = counts->taken / entries;
+    if (averageTrips < kMinAverageTrips) return 1;
+
+    LoopShape condition;
+    loop->condition->accept(&condition);
+    if (condition.hasCall || condition.hasAssign) return 1;
+
+    LoopShape body;
+    loop->body->accept(&body);
+    if (body.hasFunction || body.size > kMaxBodySize) return 1;
+
+    return body.size <= kMaxSizeForFour && averageTrips >= kMinTripsForFour ? 4 : 2;
+}
+
+void LoopUnroller::visitWhileStmt(WhileStmt* stmt) {
+    ASTRewriter::visitWhileStmt(stmt); // Inner loops first; the copies below are not revisited
+    int factor = unrollFactor(stmt);
+    if (factor == 1) return;
+
+    auto copyOfBody = [&]() {
+        std::unique_ptr<Statement> copy = ASTCloner().clone(stmt->body.get());
+        if (dynamic_cast<BlockStmt*>(copy.get())) return copy;
+        std::vector<std::unique_ptr<Statement>> wrapped;
+        wrapped.push_back(std::move(copy));
+        return std::unique_ptr<Statement>(std::make_unique<BlockStmt>(std::move(wrapped)));
+    };
+
+    // Built from the innermost copy outwards
+    std::unique_ptr<Statement> tail;
+    for (int i = factor - 1; i >= 1; i--) {
+        std::vector<std::unique_ptr<Statement>> statements;
+        statements.push_back(copyOfBody());
+        if (tail) statements.push_back(std::move(tail));
+        tail = std::make_unique<IfStmt>(ASTCloner().clone(stmt->condition.get()),
+                                        std::make_unique<BlockStmt>(std::move(statements)), nullptr,
+                                        stmt->line, stmt->column);
+    }
+
+    std::vector<std::unique_ptr<Statement>> statements;
+    statements.push_back(copyOfBody());
+    statements.push_back(std::move(tail));
+    stmt->body = std::make_unique<BlockStmt>(std::move(statements));
+    unrolled++;
+}
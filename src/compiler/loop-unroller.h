@@ -0,0 +1,40 @@
+#pragma once
+#include "../data/AST.h"
+#include "../data/execution-profile.h"
+
+// Unrolls hot `while` loops by repeating the body behind a re-check of the
+// condition:
+//
+//     while (c) B   ->   while (c) { {B} if (c) { {B} } }
+//
+// Each copy of B gets its own block, so its declarations stay separate.
+// This is only equivalent when evaluating `c` one extra time is harmless,
+// so conditions containing calls or assignments are never unrolled.
+//
+// Which loops are hot comes from an execution profile: at least
+// kMinIterations iterations in total and kMinAverageTrips per entry, with
+// a body of at most kMaxBodySize nodes. Small bodies of long-running loops
+// are unrolled four times, others twice.
+// Must run after semantic analysis (the copies keep CallExpr::resolved).
+class LoopUnroller : public ASTRewriter {
+public:
+    static const long long kMinIterations = 1000;
+    static const int kMinAverageTrips = 4;
+    static const int kMaxBodySize = 40;
+    static const int kMaxSizeForFour = 12;
+    static const int kMinTripsForFour = 16;
+
+private:
+    const ExecutionProfile& profile;
+    int unrolled = 0;
+
+    int unrollFactor(WhileStmt* loop);
+
+public:
+    explicit LoopUnroller(const ExecutionProfile& profile) : profile(profile) {}
+
+    // Returns the number of loops that were unrolled
+    int run(std::vector<std::unique_ptr<Statement>>& program);
+
+    void visitWhileStmt(WhileStmt* stmt) override;
+};
@@ -0,0 +1,326 @@
+#include "module-graph.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "parser.h"
+#include "scanner.h"
+#include "semantic-analyzer.h"
+#include "../runtime/work-stealing-pool.h"
+#include "../util/error-handler.h"
+#include "../util/trace.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string canonicalPath(const fs::path& path) {
+    std::error_code error;
+    fs::path result = fs::weakly_canonical(path, error);
+    return (error ? fs::absolute(path).lexically_normal() : result).string();
+}
+
+// How a module is named in messages: relative to the working directory
+std::string displayName(const std::string& path) {
+    std::error_code error;
+    fs::path relative = fs::path(path).lexically_relative(fs::current_path(error));
+    return error || relative.empty() ? path : relative.string();
+}
+
+} // namespace
+
+void ModuleGraph::addMain(const std::string& path, const std::string& source, const std::vector<Token>& imports,
+                          std::vector<std::unique_ptr<Statement>> program) {
+    auto module = std::make_unique<Module>();
+    module->path = canonicalPath(path);
+    module->name = displayName(module->path);
+    module->source = source;
+    module->sourceHash = ExecutionProfile::hashSource(source);
+    module->readable = true;
+    module->imports = imports;
+    module->program = std::move(program);
+    module->parsed = true;
+    loadCached(*module);
+
+    byPath[module->path] = module.get();
+    modules.push_back(std::move(module));
+}
+
+void ModuleGraph::read(Module& module) {
+    TraceSpan span("read module");
+    if (span.active()) span.arg("module", module.name);
+
+    std::ifstream file(module.path);
+    if (!file.is_open()) return;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    module.source = buffer.str();
+    module.sourceHash = ExecutionProfile::hashSource(module.source);
+    module.readable = true;
+    if (!loadCached(module)) parse(module);
+}
+
+// Only a check-only build uses the cache, and only an entry for this exact source
+bool ModuleGraph::loadCached(Module& module) {
+    if (!reuse || cacheDirectory.empty()) return false;
+    ModuleCacheEntry entry;
+    if (!entry.load(ModuleCacheEntry::fileFor(cacheDirectory, module.path)) || entry.path != module.path ||
+        entry.sourceHash != module.sourceHash) {
+        return false;
+    }
+    if (!module.parsed) {
+        // Unchanged since it was cached, so its imports are too
+        for (const auto& import : entry.imports) {
+            module.imports.emplace_back(TokenType::STRING, "\"" + import.path + "\"", import.path, import.line, import.column);
+        }
+    }
+    module.cached = std::move(entry);
+    return true;
+}
+
+void ModuleGraph::parse(Module& module) {
+    TraceSpan span("parse module");
+    if (span.active()) span.arg("module", module.name);
+    ErrorHandler::FileScope scope(module.file);
+
+    Scanner scanner(module.source);
+    std::vector<Token> tokens = scanner.scanTokens();
+    module.tokens = (long long)tokens.size();
+    module.parsed = true;
+    if (ErrorHandler::hadErrorIn(module.file)) return;
+
+    Parser parser(std::move(tokens));
+    module.program = parser.parse();
+    module.imports = parser.importedPaths();
+}
+
+void ModuleGraph::resolveImports(Module& module, std::vector<Module*>& found) {
+    fs::path directory = fs::path(module.path).parent_path();
+    for (const Token& import : module.imports) {
+        std::string path = canonicalPath(directory / import.literal);
+        auto known = byPath.find(path);
+        if (known != byPath.end()) {
+            module.deps.push_back(known->second);
+            continue;
+        }
+        auto dep = std::make_unique<Module>();
+        dep->path = path;
+        dep->name = displayName(path);
+        dep->file = dep->name;
+        dep->importer = &module;
+        dep->importedAt = import;
+        module.deps.push_back(dep.get());
+        found.push_back(dep.get());
+        byPath[path] = dep.get();
+        modules.push_back(std::move(dep));
+    }
+}
+
+bool ModuleGraph::load() {
+    TraceSpan span("load modules");
+    if (!cacheDirectory.empty()) {
+        std::error_code error;
+        fs::create_directories(cacheDirectory, error); // A cache that cannot be written is just not used
+    }
+
+    bool ok = true;
+    std::vector<Module*> frontier{modules[0].get()};
+    while (!frontier.empty()) {
+        std::vector<Module*> found;
+        for (Module* module : frontier) resolveImports(*module, found);
+        WorkStealingPool::shared().run(found.size(), [&](unsigned, size_t i) { read(*found[i]); });
+
+        frontier.clear();
+        for (Module* module : found) {
+            if (module->readable) {
+                frontier.push_back(module);
+                continue;
+            }
+            ErrorHandler::FileScope scope(module->importer->file);
+            ErrorHandler::error(module->importedAt, "Cannot open module '" + module->importedAt.literal + "'.");
+            ok = false;
+        }
+    }
+    return findCycles() && ok;
+}
+
+bool ModuleGraph::findCycles() {
+    std::map<Module*, int> state; // 1 while on the stack, 2 when done
+    std::vector<Module*> stack;
+    bool ok = true;
+    for (const auto& module : modules) {
+        if (!state[module.get()]) ok = visit(module.get(), state, stack) && ok;
+    }
+    return ok;
+}
+
+// Depth-first; reports every import that closes a cycle and sets levels
+bool ModuleGraph::visit(Module* module, std::map<Module*, int>& state, std::vector<Module*>& stack) {
+    bool ok = true;
+    state[module] = 1;
+    stack.push_back(module);
+    for (size_t i = 0; i < module->deps.size(); i++) {
+        Module* dep = module->deps[i];
+        if (!dep->readable) continue;
+        if (state[dep] == 1) {
+            std::string cycle;
+            for (auto it = std::find(stack.begin(), stack.end(), dep); it != stack.end(); ++it) cycle += (*it)->name + " -> ";
+            ErrorHandler::FileScope scope(module->file);
+            ErrorHandler::error(module->imports[i], "Import cycle: " + cycle + dep->name + ".");
+            ok = false;
+            continue;
+        }
+        if (!state[dep]) ok = visit(dep, state, stack) && ok;
+        module->level = std::max(module->level, dep->level + 1);
+    }
+    stack.pop_back();
+    state[module] = 2;
+    return ok;
+}
+
+bool ModuleGraph::needsAnalysis(const Module& module) const {
+    if (!reuse || !module.cached || module.cached->imports.size() != module.deps.size()) return true;
+    for (size_t i = 0; i < module.deps.size(); i++) {
+        if (module.deps[i]->interfaceHash != module.cached->imports[i].interfaceHash) return true;
+    }
+    return false;
+}
+
+void ModuleGraph::analyzeModule(Module& module) {
+    TraceSpan span("analyze module");
+    if (span.active()) span.arg("module", module.name);
+
+    if (!needsAnalysis(module)) {
+        module.interface = module.cached->interface;
+        module.interfaceHash = module.interface.hash();
+        return;
+    }
+    if (!module.parsed) parse(module);
+    ErrorHandler::FileScope scope(module.file);
+
+    SemanticAnalyzer analyzer;
+    for (Module* dep : module.deps) {
+        std::map<std::string, FunctionStmt*> declarations;
+        if (dep->analyzed) {
+            for (const auto& stmt : dep->program) {
+                if (FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get())) declarations[fn->name.lexeme] = fn;
+            }
+        }
+        // Skipped modules have no statements; calls resolve to a stand-in
+        for (const auto& fn : dep->interface.functions) {
+            if (declarations.count(fn.name)) continue;
+            std::vector<Token> params, paramTypes;
+            for (size_t i = 0; i < fn.paramTypes.size(); i++) {
+                params.emplace_back(TokenType::IDENTIFIER, "p" + std::to_string(i), "", fn.line);
+                paramTypes.emplace_back(fn.paramTypes[i], ModuleInterface::typeName(fn.paramTypes[i]), "", fn.line);
+            }
+            module.stubs.push_back(std::make_unique<FunctionStmt>(
+                Token(TokenType::IDENTIFIER, fn.name, "", fn.line, fn.column),
+                Token(fn.returnType, ModuleInterface::typeName(fn.returnType), "", fn.line), params, paramTypes,
+                std::vector<std::unique_ptr<Statement>>()));
+            declarations[fn.name] = module.stubs.back().get();
+        }
+        analyzer.importModule(dep->interface, declarations);
+    }
+    analyzer.analyze(module.program);
+    module.analyzed = true;
+    module.maxScopeDepth = analyzer.maxScopeDepth();
+    module.interface = analyzer.exports(module.program);
+    module.interfaceHash = module.interface.hash();
+
+    if (cacheDirectory.empty() || ErrorHandler::hadErrorIn(module.file)) return;
+    ModuleCacheEntry entry;
+    entry.path = module.path;
+    entry.sourceHash = module.sourceHash;
+    for (size_t i = 0; i < module.deps.size(); i++) {
+        const Token& import = module.imports[i];
+        entry.imports.push_back({module.deps[i]->interfaceHash, import.line, import.column, import.literal});
+    }
+    entry.interface = module.interface;
+    entry.save(ModuleCacheEntry::fileFor(cacheDirectory, module.path));
+}
+
+bool ModuleGraph::analyze() {
+    // Modules on one level only import modules on lower levels
+    int top = 0;
+    for (const auto& module : modules) top = std::max(top, module->level);
+    for (int level = 0; level <= top; level++) {
+        std::vector<Module*> ready;
+        for (const auto& module : modules) {
+            if (module->level == level) ready.push_back(module.get());
+        }
+        WorkStealingPool::shared().run(ready.size(), [&](unsigned, size_t i) { analyzeModule(*ready[i]); });
+    }
+    if (!ErrorHandler::hadError) checkUniqueNames();
+    return !ErrorHandler::hadError;
+}
+
+// The analyzer already rejects a module redeclaring what it imports; this
+// catches the same name in modules that do not import each other
+void ModuleGraph::checkUniqueNames() {
+    std::map<Module*, bool> placed;
+    std::vector<Module*> sorted;
+    order(modules[0].get(), placed, sorted);
+
+    std::map<std::string, Module*> owners;
+    for (Module* module : sorted) {
+        auto claim = [&](const std::string& name, int line, int column) {
+            auto owner = owners.emplace(name, module);
+            Module* other = owner.first->second;
+            if (owner.second || other == module) return;
+            if (std::count(module->deps.begin(), module->deps.end(), other)) return;
+            ErrorHandler::FileScope scope(module->file);
+            ErrorHandler::error(line, column, (int)name.size(),
+                                "'" + name + "' is also declared in " + other->name +
+                                    "; top-level names must be unique across modules.");
+        };
+        for (const auto& global : module->interface.globals) claim(global.name, global.line, global.column);
+        for (const auto& fn : module->interface.functions) claim(fn.name, fn.line, fn.column);
+    }
+}
+
+void ModuleGraph::order(Module* module, std::map<Module*, bool>& placed, std::vector<Module*>& sorted) {
+    if (placed[module]) return;
+    placed[module] = true;
+    for (Module* dep : module->deps) order(dep, placed, sorted);
+    sorted.push_back(module);
+}
+
+std::vector<std::unique_ptr<Statement>> ModuleGraph::link() {
+    std::map<Module*, bool> placed;
+    std::vector<Module*> sorted;
+    order(modules[0].get(), placed, sorted);
+
+    std::vector<std::unique_ptr<Statement>> program;
+    for (Module* module : sorted) {
+        for (auto& stmt : module->program) program.push_back(std::move(stmt));
+        module->program.clear();
+    }
+    return program;
+}
+
+size_t ModuleGraph::analyzedCount() const {
+    size_t count = 0;
+    for (const auto& module : modules) count += module->analyzed ? 1 : 0;
+    return count;
+}
+
+size_t ModuleGraph::maxScopeDepth() const {
+    size_t depth = 0;
+    for (const auto& module : modules) depth = std::max(depth, module->maxScopeDepth);
+    return depth;
+}
+
+long long ModuleGraph::tokenCount() const {
+    long long count = 0;
+    for (const auto& module : modules) count += module->tokens;
+    return count;
+}
+
+std::vector<const std::vector<std::unique_ptr<Statement>>*> ModuleGraph::parsedPrograms() const {
+    std::vector<const std::vector<std::unique_ptr<Statement>>*> programs;
+    for (size_t i = 1; i < modules.size(); i++) {
+        if (modules[i]->parsed) programs.push_back(&modules[i]->program);
+    }
+    return programs;
+}
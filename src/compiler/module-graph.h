@@ -0,0 +1,100 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../data/AST.h"
+#include "../data/module-interface.h"
+#include "../data/token.h"
+
+// The script named on the command line and every module it imports,
+// directly or not.
+//
+// `import "path.ns";` names a file relative to the importing one and makes
+// that module's top-level globals and functions visible. Imports are not
+// transitive, but all top-level names share one namespace: two modules
+// linked into the same program cannot declare the same name.
+//
+// load() follows the imports breadth first, reading and parsing each
+// round of newly found modules in parallel, and rejects missing files and
+// import cycles. analyze() then checks the modules in dependency order:
+// every module whose imports are all done is analyzed at once, on the
+// shared work-stealing pool, against the interfaces of its imports.
+//
+// With a cache directory, each module's interface is saved after it
+// analyzes cleanly (see ModuleCacheEntry). A check-only build (`reuse`)
+// skips every module whose source and imported interfaces are unchanged,
+// without parsing it.
+class ModuleGraph {
+public:
+    ModuleGraph(std::string cacheDirectory, bool reuse) : cacheDirectory(std::move(cacheDirectory)), reuse(reuse) {}
+
+    // The main script, already parsed; `imports` as returned by the parser
+    void addMain(const std::string& path, const std::string& source, const std::vector<Token>& imports,
+                 std::vector<std::unique_ptr<Statement>> program);
+
+    // Finds, reads and parses every imported module. Returns false (after
+    // reporting) if a module is missing or the imports form a cycle; scan
+    // and parse errors are reported but do not stop it.
+    bool load();
+
+    // Returns false if any module had a semantic error
+    bool analyze();
+
+    // Every module's statements in one program, each module after the ones
+    // it imports, so top-level code runs in dependency order. Only valid
+    // after an analyze() without reuse.
+    std::vector<std::unique_ptr<Statement>> link();
+
+    size_t moduleCount() const { return modules.size(); }
+    // Modules analyzed in this build; the rest were unchanged
+    size_t analyzedCount() const;
+    size_t maxScopeDepth() const;
+    long long tokenCount() const;
+    // Tokens and programs of the imported modules parsed in this build, for --stats
+    std::vector<const std::vector<std::unique_ptr<Statement>>*> parsedPrograms() const;
+
+private:
+    struct Module {
+        std::string path;    // Canonical; identifies the module
+        std::string name;    // Relative to the working directory, for messages
+        std::string file;    // For diagnostics: empty for the main script
+        std::string source;
+        uint64_t sourceHash = 0;
+        bool readable = false;
+        std::optional<ModuleCacheEntry> cached; // Only if it matches the source
+
+        std::vector<Token> imports; // The path strings, as parsed or cached
+        std::vector<Module*> deps;  // Parallel to imports
+        Module* importer = nullptr; // Where it was first imported, for errors
+        Token importedAt{TokenType::STRING, "", "", 0};
+
+        bool parsed = false;
+        long long tokens = 0;
+        std::vector<std::unique_ptr<Statement>> program;
+        std::vector<std::unique_ptr<FunctionStmt>> stubs; // Stand-ins for unparsed imports
+
+        int level = 0; // Longest chain of imports below it
+        bool analyzed = false;
+        size_t maxScopeDepth = 0;
+        ModuleInterface interface;
+        uint64_t interfaceHash = 0;
+    };
+
+    std::string cacheDirectory;
+    bool reuse;
+    std::vector<std::unique_ptr<Module>> modules; // The main script first
+    std::map<std::string, Module*> byPath;
+
+    void read(Module& module);
+    void parse(Module& module);
+    bool loadCached(Module& module);
+    void resolveImports(Module& module, std::vector<Module*>& found);
+    bool findCycles();
+    bool visit(Module* module, std::map<Module*, int>& state, std::vector<Module*>& stack);
+    bool needsAnalysis(const Module& module) const;
+    void analyzeModule(Module& module);
+    void checkUniqueNames();
+    void order(Module* module, std::map<Module*, bool>& placed, std::vector<Module*>& sorted);
+};
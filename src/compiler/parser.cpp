@@ -1,20 +1,60 @@
 #include "parser.h"
 #include "../util/error-handler.h"
+#include "../util/trace.h"
 
-Parser::Parser(std::vector<Token> tokens) : tokens(tokens) {}
+Parser::Parser(std::vector<Token> tokens, bool lazy)
+    : tokens(std::make_shared<const std::vector<Token>>(std::move(tokens))), lazy(lazy) {
+    end = (int)this->tokens->size() - 1;
+}
+
+// Parses tokens[begin, end) only, so that error recovery cannot run past
+// the end of a function body into the declarations after it
+Parser::Parser(std::shared_ptr<const std::vector<Token>> tokens, int begin, int end)
+    : tokens(std::move(tokens)), current(begin), end(end), importsAllowed(false) {}
 
 std::vector<std::unique_ptr<Statement>> Parser::parse() {
     std::vector<std::unique_ptr<Statement>> statements;
-    while (!isAtEnd()) {
+    while (!isAtEnd() && !ErrorHandler::limitReached()) {
+        // One trace span per top-level declaration
+        TraceSpan span("declaration");
+        if (span.active()) {
+            // `func int name(` / `var int name`: the name is two tokens on
+            std::string what = peek().lexeme;
+            if ((check(TokenType::FUNC) || check(TokenType::VAR)) && current + 2 < end) {
+                what += " " + (*tokens)[current + 2].lexeme;
+            }
+            span.arg("what", what);
+            span.arg("line", (long long)peek().line);
+        }
+        if (!check(TokenType::IMPORT)) importsAllowed = false;
+        topLevel = true;
         Statement* stmt = declaration();
         if (stmt) statements.emplace_back(stmt);
     }
     return statements;
 }
 
+void Parser::parseBody(FunctionStmt* fn) {
+    TraceSpan span("parse body");
+    if (span.active()) span.arg("function", fn->name.lexeme);
+
+    Parser parser(fn->lazy->tokens, fn->lazy->begin, fn->lazy->end);
+    while (!parser.isAtEnd() && !ErrorHandler::limitReached()) {
+        Statement* stmt = parser.declaration();
+        if (stmt) fn->body.emplace_back(stmt);
+    }
+    fn->lazy.reset();
+}
+
 Statement* Parser::declaration() {
+    bool skipBody = lazy && topLevel;
+    topLevel = false;
     try {
-        if (match({TokenType::FUNC})) return funcDeclaration("function");
+        if (match({TokenType::IMPORT})) {
+            importDeclaration();
+            return nullptr;
+        }
+        if (match({TokenType::FUNC})) return funcDeclaration("function", skipBody);
         if (match({TokenType::VAR})) return varDeclaration();
         return statement();
     } catch (std::runtime_error& error) {
@@ -23,13 +63,27 @@ Statement* Parser::declaration() {
     }
 }
 
-Statement* Parser::funcDeclaration(std::string kind) {
-    // Parse return type: func int/float/bool name(...)
+// import "path.ns";
+void Parser::importDeclaration() {
+    Token keyword = previous();
+    Token path = consume(TokenType::STRING, "Expect a module path in quotes after 'import'.");
+    consume(TokenType::SEMICOLON, "Expect ';' after import.");
+    if (!importsAllowed) {
+        ErrorHandler::error(keyword, "Imports must come before all other declarations.");
+        return;
+    }
+    if (path.literal.empty()) {
+        ErrorHandler::error(path, "Module path is empty.");
+        return;
+    }
+    imports.push_back(path);
+}
+
+Statement* Parser::funcDeclaration(std::string kind, bool skipBody) {
+    // Parse return type: func int/float/bool/string name(...)
     Token typeToken = peek();
-    if (match({TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL})) {
-        typeToken = previous();
-    } else {
-        throw std::runtime_error("Expected return type (int/float/bool) before function name.");
+    if (!matchType(typeToken)) {
+        throw std::runtime_error("Expected return type (int/float/bool/string) before function name.");
     }
 
     Token name = consume(TokenType::IDENTIFIER, "Expect " + kind + " name.");
@@ -41,12 +95,13 @@ Statement* Parser::funcDeclaration(std::string kind) {
     if (!check(TokenType::RPAREN)) {
         do {
             if (parameters.size() >= 255) {
-                ErrorHandler::error(peek().line, "Can't have more than 255 parameters.");
+                ErrorHandler::error(peek(), "Can't have more than 255 parameters.");
             }
             
             // Parse Param Type
-            if (match({TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL})) {
-                paramTypes.push_back(previous());
+            Token paramType = peek();
+            if (matchType(paramType)) {
+                paramTypes.push_back(paramType);
             } else {
                  throw std::runtime_error("Expect parameter type.");
             }
@@ -57,17 +112,33 @@ Statement* Parser::funcDeclaration(std::string kind) {
     }
     consume(TokenType::RPAREN, "Expect ')' after parameters.");
     consume(TokenType::LBRACE, "Expect '{' before " + kind + " body.");
-    std::vector<std::unique_ptr<Statement>> body = block();
-    return new FunctionStmt(name, typeToken, parameters, paramTypes, std::move(body));
+    if (!skipBody) {
+        std::vector<std::unique_ptr<Statement>> body = block();
+        return new FunctionStmt(name, typeToken, parameters, paramTypes, std::move(body));
+    }
+
+    // Find the matching '}' by token type alone; braces inside strings and
+    // comments never became brace tokens
+    int begin = current;
+    const std::vector<Token>& all = *tokens;
+    for (int depth = 1; current < end; current++) {
+        TokenType type = all[current].type;
+        if (type == TokenType::LBRACE) depth++;
+        if (type == TokenType::RBRACE && --depth == 0) break;
+    }
+    int bodyEnd = current;
+    consume(TokenType::RBRACE, "Expect '}' after block.");
+    FunctionStmt* fn = new FunctionStmt(name, typeToken, parameters, paramTypes, {});
+    fn->lazy = std::make_unique<LazyBody>(LazyBody{tokens, begin, bodyEnd});
+    return fn;
 }
 
 Statement* Parser::varDeclaration() {
     // var int x = 10;
     Token type = peek();
-    if (!match({TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL})) {
+    if (!matchType(type)) {
          throw std::runtime_error("Expect variable type after 'var'.");
     }
-    type = previous();
 
     Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
     
@@ -84,11 +155,14 @@ Statement* Parser::statement() {
     if (match({TokenType::PRINT})) return printStatement();
     if (match({TokenType::RETURN})) return returnStatement();
     if (match({TokenType::WHILE})) return whileStatement();
+    if (match({TokenType::FOR})) return forStatement();
+    if (match({TokenType::PARALLEL})) return parallelForStatement();
     if (match({TokenType::LBRACE})) return new BlockStmt(block());
     return expressionStatement();
 }
 
 Statement* Parser::ifStatement() {
+    Token keyword = previous();
     consume(TokenType::LPAREN, "Expect '(' after 'if'.");
     Expression* condition = expression();
     consume(TokenType::RPAREN, "Expect ')' after if condition.");
@@ -98,15 +172,106 @@ Statement* Parser::ifStatement() {
     if (match({TokenType::ELSE})) {
         elseBranch = statement();
     }
-    return new IfStmt(std::unique_ptr<Expression>(condition), std::unique_ptr<Statement>(thenBranch), std::unique_ptr<Statement>(elseBranch));
+    return new IfStmt(std::unique_ptr<Expression>(condition), std::unique_ptr<Statement>(thenBranch), std::unique_ptr<Statement>(elseBranch),
+                      keyword.line, keyword.column);
 }
 
 Statement* Parser::whileStatement() {
+    Token keyword = previous();
     consume(TokenType::LPAREN, "Expect '(' after 'while'.");
     Expression* condition = expression();
     consume(TokenType::RPAREN, "Expect ')' after condition.");
     Statement* body = statement();
-    return new WhileStmt(std::unique_ptr<Expression>(condition), std::unique_ptr<Statement>(body));
+    return new WhileStmt(std::unique_ptr<Expression>(condition), std::unique_ptr<Statement>(body), keyword.line, keyword.column);
+}
+
+// for (initializer; condition; increment) body
+// is desugared into { initializer; while (condition) { body; increment; } }
+Statement* Parser::forStatement() {
+    Token keyword = previous();
+    consume(TokenType::LPAREN, "Expect '(' after 'for'.");
+
+    std::unique_ptr<Statement> initializer;
+    if (match({TokenType::SEMICOLON})) {
+        // No initializer
+    } else if (match({TokenType::VAR})) {
+        initializer.reset(varDeclaration());
+    } else {
+        initializer.reset(expressionStatement());
+    }
+
+    std::unique_ptr<Expression> condition;
+    if (!check(TokenType::SEMICOLON)) condition.reset(expression());
+    consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
+
+    std::unique_ptr<Expression> increment;
+    if (!check(TokenType::RPAREN)) increment.reset(expression());
+    consume(TokenType::RPAREN, "Expect ')' after for clauses.");
+    std::unique_ptr<Statement> body(statement());
+
+    if (increment) {
+        std::vector<std::unique_ptr<Statement>> statements;
+        statements.push_back(std::move(body));
+        statements.push_back(std::make_unique<ExpressionStmt>(std::move(increment)));
+        body = std::make_unique<BlockStmt>(std::move(statements));
+    }
+    if (!condition) condition = std::make_unique<LiteralExpr>("true", TokenType::TYPE_BOOL);
+    std::unique_ptr<Statement> loop =
+        std::make_unique<WhileStmt>(std::move(condition), std::move(body), keyword.line, keyword.column);
+
+    if (!initializer) return loop.release();
+    std::vector<std::unique_ptr<Statement>> statements;
+    statements.push_back(std::move(initializer));
+    statements.push_back(std::move(loop));
+    return new BlockStmt(std::move(statements));
+}
+
+// parallel for (var int i = start; i < end; i = i + 1) body
+// Only this counted form is accepted, so the iteration space is known
+// before the loop starts.
+Statement* Parser::parallelForStatement() {
+    Token keyword = previous();
+    consume(TokenType::FOR, "Expect 'for' after 'parallel'.");
+    consume(TokenType::LPAREN, "Expect '(' after 'for'.");
+    consume(TokenType::VAR, "Expect 'var int' loop variable in parallel for.");
+    Token type = peek();
+    if (!matchType(type) || type.type != TokenType::TYPE_INT) {
+        ErrorHandler::error(type, "The loop variable of a parallel for must be an int.");
+        throw std::runtime_error("The loop variable of a parallel for must be an int.");
+    }
+    Token name = consume(TokenType::IDENTIFIER, "Expect loop variable name.");
+    consume(TokenType::EQUAL, "Expect '=' after loop variable.");
+    std::unique_ptr<Expression> start(expression());
+    consume(TokenType::SEMICOLON, "Expect ';' after loop start.");
+
+    auto expectLoopVariable = [&](const std::string& message) {
+        Token token = consume(TokenType::IDENTIFIER, message);
+        if (token.lexeme != name.lexeme) {
+            ErrorHandler::error(token, message);
+            throw std::runtime_error(message);
+        }
+    };
+
+    const std::string conditionForm = "A parallel for must test '" + name.lexeme + " < end'.";
+    expectLoopVariable(conditionForm);
+    consume(TokenType::LESS, conditionForm);
+    std::unique_ptr<Expression> end(expression());
+    consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
+
+    const std::string incrementForm = "A parallel for must count up by one ('" + name.lexeme + " = " + name.lexeme + " + 1').";
+    expectLoopVariable(incrementForm);
+    consume(TokenType::EQUAL, incrementForm);
+    expectLoopVariable(incrementForm);
+    consume(TokenType::PLUS, incrementForm);
+    Token one = consume(TokenType::INT_LITERAL, incrementForm);
+    if (one.literal != "1") {
+        ErrorHandler::error(one, incrementForm);
+        throw std::runtime_error(incrementForm);
+    }
+    consume(TokenType::RPAREN, "Expect ')' after for clauses.");
+
+    std::unique_ptr<Statement> body(statement());
+    return new ParallelForStmt(keyword, name, std::move(start), std::move(end), std::move(body));
 }
 
 Statement* Parser::printStatement() {
@@ -129,7 +294,7 @@ Statement* Parser::returnStatement() {
 
 std::vector<std::unique_ptr<Statement>> Parser::block() {
     std::vector<std::unique_ptr<Statement>> statements;
-    while (!check(TokenType::RBRACE) && !isAtEnd()) {
+    while (!check(TokenType::RBRACE) && !isAtEnd() && !ErrorHandler::limitReached()) {
         Statement* stmt = declaration();
         if(stmt) statements.emplace_back(stmt);
     }
@@ -162,7 +327,14 @@ Expression* Parser::assignment() {
             delete expr; 
             return new AssignExpr(name, std::unique_ptr<Expression>(value));
         }
-        ErrorHandler::error(equals.line, "Invalid assignment target.");
+        IndexExpr* indexExpr = dynamic_cast<IndexExpr*>(expr);
+        if (indexExpr != nullptr) {
+            Expression* target = new IndexAssignExpr(std::move(indexExpr->array), indexExpr->bracket,
+                                                     std::move(indexExpr->index), std::unique_ptr<Expression>(value));
+            delete expr;
+            return target;
+        }
+        ErrorHandler::error(equals, "Invalid assignment target.");
     }
     return expr;
 }
@@ -241,6 +413,11 @@ Expression* Parser::call() {
     while (true) {
         if (match({TokenType::LPAREN})) {
             expr = finishCall(expr);
+        } else if (match({TokenType::LBRACKET})) {
+            Token bracket = previous();
+            Expression* index = expression();
+            consume(TokenType::RBRACKET, "Expect ']' after index.");
+            expr = new IndexExpr(std::unique_ptr<Expression>(expr), bracket, std::unique_ptr<Expression>(index));
         } else {
             break;
         }
@@ -253,7 +430,7 @@ Expression* Parser::finishCall(Expression* callee) {
     if (!check(TokenType::RPAREN)) {
         do {
             if (arguments.size() >= 255) {
-                ErrorHandler::error(peek().line, "Can't have more than 255 arguments.");
+                ErrorHandler::error(peek(), "Can't have more than 255 arguments.");
             }
             arguments.push_back(std::unique_ptr<Expression>(expression()));
         } while (match({TokenType::COMMA}));
@@ -267,7 +444,28 @@ Expression* Parser::primary() {
     if (match({TokenType::TRUE_KEYWORD})) return new LiteralExpr("true", TokenType::TYPE_BOOL);
     if (match({TokenType::INT_LITERAL})) return new LiteralExpr(previous().literal, TokenType::TYPE_INT);
     if (match({TokenType::FLOAT_LITERAL})) return new LiteralExpr(previous().literal, TokenType::TYPE_FLOAT);
+    if (match({TokenType::STRING})) return new LiteralExpr(previous().literal, TokenType::TYPE_STRING);
     if (match({TokenType::IDENTIFIER})) return new VariableExpr(previous());
+    if (match({TokenType::LBRACKET})) {
+        // Array literal: [a, b, c]
+        Token bracket = previous();
+        std::vector<std::unique_ptr<Expression>> elements;
+        if (!check(TokenType::RBRACKET)) {
+            do {
+                elements.push_back(std::unique_ptr<Expression>(expression()));
+            } while (match({TokenType::COMMA}));
+        }
+        consume(TokenType::RBRACKET, "Expect ']' after array elements.");
+        return new ArrayExpr(bracket, TokenType::END_OF_FILE, std::move(elements), nullptr);
+    }
+    if ((check(TokenType::TYPE_INT) || check(TokenType::TYPE_FLOAT)) && (*tokens)[current + 1].type == TokenType::LBRACKET) {
+        // Allocation: int[n] / float[n]
+        TokenType elementType = advance().type;
+        Token bracket = advance();
+        Expression* length = expression();
+        consume(TokenType::RBRACKET, "Expect ']' after array length.");
+        return new ArrayExpr(bracket, elementType, {}, std::unique_ptr<Expression>(length));
+    }
     if (match({TokenType::LPAREN})) {
         Expression* expr = expression();
         consume(TokenType::RPAREN, "Expect ')' after expression.");
@@ -277,6 +475,25 @@ Expression* Parser::primary() {
 }
 
 // Helpers
+
+// A type name: int, float, bool or string, where int and float may be
+// followed by `[]` (bool and string take no `[]` suffix). Array types come
+// back as one synthesized TYPE_*_ARRAY token.
+bool Parser::matchType(Token& type) {
+    if (!match({TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL, TokenType::TYPE_STRING})) return false;
+    type = previous();
+    if (match({TokenType::LBRACKET})) {
+        consume(TokenType::RBRACKET, "Expect ']' after '[' in array type.");
+        if (type.type != TokenType::TYPE_INT && type.type != TokenType::TYPE_FLOAT) {
+            ErrorHandler::error(type, "Only int and float arrays are supported.");
+        } else {
+            TokenType arrayType = type.type == TokenType::TYPE_INT ? TokenType::TYPE_INT_ARRAY : TokenType::TYPE_FLOAT_ARRAY;
+            type = Token(arrayType, type.lexeme + "[]", "", type.line, type.column);
+        }
+    }
+    return true;
+}
+
 bool Parser::match(const std::vector<TokenType>& types) {
     for (TokenType type : types) {
         if (check(type)) {
@@ -297,13 +514,13 @@ Token Parser::advance() {
     return previous();
 }
 
-bool Parser::isAtEnd() { return peek().type == TokenType::END_OF_FILE; }
-Token Parser::peek() { return tokens[current]; }
-Token Parser::previous() { return tokens[current - 1]; }
+bool Parser::isAtEnd() { return current >= end || peek().type == TokenType::END_OF_FILE; }
+Token Parser::peek() { return (*tokens)[current]; }
+Token Parser::previous() { return (*tokens)[current - 1]; }
 
 Token Parser::consume(TokenType type, std::string message) {
     if (check(type)) return advance();
-    ErrorHandler::error(peek().line, message);
+    ErrorHandler::error(peek(), message);
     throw std::runtime_error(message);
 }
 
@@ -316,6 +533,8 @@ void Parser::synchronize() {
             case TokenType::FUNC:
             case TokenType::VAR:
             case TokenType::FOR:
+            case TokenType::PARALLEL:
+            case TokenType::IMPORT:
             case TokenType::IF:
             case TokenType::WHILE:
             case TokenType::PRINT:
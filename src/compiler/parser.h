@@ -6,16 +6,26 @@
 
 class Parser {
 private:
-    std::vector<Token> tokens;
+    std::shared_ptr<const std::vector<Token>> tokens; // Shared with the bodies `lazy` skips
     int current = 0;
+    int end;                     // Index of the token that ends the input
+    std::vector<Token> imports;  // The path strings of `import "path";`
+    bool importsAllowed = true;  // Until the first other declaration
+    bool lazy = false;
+    bool topLevel = false;       // The next declaration is not inside a block
+
+    Parser(std::shared_ptr<const std::vector<Token>> tokens, int begin, int end);
+
+    void importDeclaration();
 
     Statement* declaration();
     Statement* varDeclaration();
-    Statement* funcDeclaration(std::string kind);
+    Statement* funcDeclaration(std::string kind, bool skipBody);
     Statement* statement();
     Statement* ifStatement();
     Statement* whileStatement();
     Statement* forStatement();
+    Statement* parallelForStatement();
     Statement* returnStatement();
     Statement* printStatement();
     std::vector<std::unique_ptr<Statement>> block();
@@ -34,6 +44,7 @@ private:
     Expression* finishCall(Expression* callee);
     Expression* primary();
 
+    bool matchType(Token& type);
     bool match(const std::vector<TokenType>& types);
     bool check(TokenType type);
     Token advance();
@@ -44,6 +55,14 @@ private:
     void synchronize();
 
 public:
-    Parser(std::vector<Token> tokens);
+    // With `lazy`, top-level function bodies are only brace-matched; each
+    // FunctionStmt keeps its body's tokens in `lazy` for parseBody()
+    Parser(std::vector<Token> tokens, bool lazy = false);
     std::vector<std::unique_ptr<Statement>> parse();
+
+    // Builds the body of a function whose body was skipped
+    static void parseBody(FunctionStmt* fn);
+
+    // Modules named by the import declarations at the top of the file
+    const std::vector<Token>& importedPaths() const { return imports; }
 };
\ No newline at end of file
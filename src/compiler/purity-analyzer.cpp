@@ -0,0 +1,158 @@
+#include "purity-analyzer.h"
+
+void PurityAnalyzer::analyze(const std::vector<std::unique_ptr<Statement>>& program) {
+    facts.clear();
+    pure.clear();
+    globalDeclarations.clear();
+    assignedGlobals.clear();
+    arrayGlobals.clear();
+    declarationOrder.clear();
+    walk(program);
+
+    for (const auto& entry : facts) {
+        const Facts& f = entry.second;
+        bool ok = !f.sideEffects && !f.unresolvedCall;
+        for (const auto& name : f.globalReads) ok = ok && isImmutableGlobal(name);
+        if (ok) pure.insert(entry.first);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = pure.begin(); it != pure.end();) {
+            bool callsImpure = false;
+            for (FunctionStmt* callee : facts[*it].callees) callsImpure = callsImpure || !pure.count(callee);
+            if (callsImpure) {
+                it = pure.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool PurityAnalyzer::isImmutableGlobal(const std::string& name) const {
+    auto found = globalDeclarations.find(name);
+    return found != globalDeclarations.end() && found->second == 1 && !assignedGlobals.count(name) &&
+           !arrayGlobals.count(name);
+}
+
+bool PurityAnalyzer::isRecursive(FunctionStmt* fn) const {
+    std::set<FunctionStmt*> seen;
+    std::vector<FunctionStmt*> worklist(facts.at(fn).callees.begin(), facts.at(fn).callees.end());
+    while (!worklist.empty()) {
+        FunctionStmt* f = worklist.back();
+        worklist.pop_back();
+        if (f == fn) return true;
+        if (!seen.insert(f).second || !facts.count(f)) continue;
+        for (FunctionStmt* next : facts.at(f).callees) worklist.push_back(next);
+    }
+    return false;
+}
+
+std::vector<FunctionStmt*> PurityAnalyzer::memoizationCandidates() const {
+    std::vector<FunctionStmt*> result;
+    for (FunctionStmt* fn : declarationOrder) {
+        // Cached strings would outlive the heap of the interpreter that built them
+        TokenType returnType = fn->returnType.type;
+        if (!isPure(fn) || fn->params.empty() || isArrayType(returnType) || returnType == TokenType::TYPE_STRING) continue;
+        bool keyable = true;
+        for (const auto& type : fn->paramTypes) {
+            keyable = keyable && (type.type == TokenType::TYPE_INT || type.type == TokenType::TYPE_BOOL);
+        }
+        if (keyable && isRecursive(fn)) result.push_back(fn);
+    }
+    return result;
+}
+
+int PurityAnalyzer::classify(const std::string& name) const {
+    for (size_t i = scopes.size(); i-- > 0;) {
+        if (!scopes[i].count(name)) continue;
+        bool own = functionBases.empty() || i >= functionBases.back();
+        return own ? 0 : 1;
+    }
+    return -1;
+}
+
+void PurityAnalyzer::declare(const std::string& name) {
+    scopes.back().insert(name);
+}
+
+void PurityAnalyzer::markImpure() {
+    if (!functions.empty()) facts[functions.back()].sideEffects = true;
+}
+
+void PurityAnalyzer::visitVariableExpr(VariableExpr* expr) {
+    int where = classify(expr->name.lexeme);
+    if (where == 1) {
+        markImpure();
+    } else if (where == -1 && !functions.empty()) {
+        facts[functions.back()].globalReads.insert(expr->name.lexeme);
+    }
+}
+
+void PurityAnalyzer::visitAssignExpr(AssignExpr* expr) {
+    expr->value->accept(this);
+    int where = classify(expr->name.lexeme);
+    if (where == -1) assignedGlobals.insert(expr->name.lexeme);
+    if (where != 0) markImpure();
+}
+
+void PurityAnalyzer::visitCallExpr(CallExpr* expr) {
+    for (const auto& arg : expr->arguments) arg->accept(this);
+    if (functions.empty() || expr->builtin != Builtin::NONE) return;
+    if (expr->resolved) {
+        facts[functions.back()].callees.insert(expr->resolved);
+    } else {
+        facts[functions.back()].unresolvedCall = true;
+    }
+}
+
+void PurityAnalyzer::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    markImpure();
+    ASTWalker::visitIndexAssignExpr(expr);
+}
+
+void PurityAnalyzer::visitBlockStmt(BlockStmt* stmt) {
+    scopes.emplace_back();
+    walk(stmt->statements);
+    scopes.pop_back();
+}
+
+void PurityAnalyzer::visitParallelForStmt(ParallelForStmt* stmt) {
+    stmt->start->accept(this);
+    stmt->end->accept(this);
+    scopes.emplace_back();
+    declare(stmt->name.lexeme);
+    stmt->body->accept(this);
+    scopes.pop_back();
+}
+
+void PurityAnalyzer::visitFunctionStmt(FunctionStmt* stmt) {
+    facts[stmt];
+    declarationOrder.push_back(stmt);
+    functions.push_back(stmt);
+    functionBases.push_back(scopes.size());
+    scopes.emplace_back();
+    for (const auto& param : stmt->params) declare(param.lexeme);
+    walk(stmt->body);
+    scopes.pop_back();
+    functionBases.pop_back();
+    functions.pop_back();
+}
+
+void PurityAnalyzer::visitPrintStmt(PrintStmt* stmt) {
+    markImpure();
+    ASTWalker::visitPrintStmt(stmt);
+}
+
+void PurityAnalyzer::visitVarStmt(VarStmt* stmt) {
+    ASTWalker::visitVarStmt(stmt);
+    if (scopes.empty()) {
+        globalDeclarations[stmt->name.lexeme]++;
+        if (isArrayType(stmt->type.type)) arrayGlobals.insert(stmt->name.lexeme);
+    } else {
+        declare(stmt->name.lexeme);
+    }
+}
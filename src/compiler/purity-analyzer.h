@@ -0,0 +1,65 @@
+#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include "../data/AST.h"
+
+// Finds functions whose result depends only on their arguments.
+//
+// A function is pure when it does not print, never assigns a global or an
+// array element, only reads its own locals and globals that are never
+// reassigned (global arrays never qualify: their elements can be changed
+// through any alias), and only calls pure functions. The last rule is
+// solved optimistically (assume every function is pure, then remove
+// violators until nothing changes) so that recursive functions such as
+// factorial can be pure.
+// Must run after semantic analysis (it relies on CallExpr::resolved).
+class PurityAnalyzer : public ASTWalker {
+private:
+    struct Facts {
+        bool sideEffects = false;        // Print, global write or closure access
+        std::set<std::string> globalReads;
+        std::set<FunctionStmt*> callees;
+        bool unresolvedCall = false;
+    };
+
+    std::map<FunctionStmt*, Facts> facts;
+    std::set<FunctionStmt*> pure;
+    std::map<std::string, int> globalDeclarations;
+    std::set<std::string> assignedGlobals;
+    std::set<std::string> arrayGlobals;
+
+    // Innermost scopes last; each function starts a new frame of scopes
+    std::vector<std::set<std::string>> scopes;
+    std::vector<size_t> functionBases;
+    std::vector<FunctionStmt*> functions;
+    std::vector<FunctionStmt*> declarationOrder;
+
+    // -1: global, 0: local of the current function, 1: local of enclosing code
+    int classify(const std::string& name) const;
+    void declare(const std::string& name);
+    void markImpure();
+    bool isRecursive(FunctionStmt* fn) const;
+
+public:
+    void analyze(const std::vector<std::unique_ptr<Statement>>& program);
+
+    bool isPure(FunctionStmt* fn) const { return pure.count(fn) > 0; }
+    // True for top-level variables that are declared once and never reassigned
+    bool isImmutableGlobal(const std::string& name) const;
+
+    // Pure recursive functions whose parameters are all int/bool and whose
+    // result is a scalar, in source order: the ones worth running through a
+    // result cache.
+    std::vector<FunctionStmt*> memoizationCandidates() const;
+
+    void visitVariableExpr(VariableExpr* expr) override;
+    void visitAssignExpr(AssignExpr* expr) override;
+    void visitCallExpr(CallExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitPrintStmt(PrintStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+};
@@ -0,0 +1,378 @@
+#include "race-checker.h"
+#include "../util/error-handler.h"
+
+namespace {
+
+Expression* stripGroups(Expression* expr) {
+    while (GroupingExpr* group = dynamic_cast<GroupingExpr*>(expr)) expr = group->expression.get();
+    return expr;
+}
+
+bool isVariable(Expression* expr, const std::string& name) {
+    VariableExpr* var = dynamic_cast<VariableExpr*>(stripGroups(expr));
+    return var && var->name.lexeme == name;
+}
+
+// Does the expression use `name` at all? (Ignores shadowing, which only
+// makes the answer more conservative.)
+class Mentions : public ASTWalker {
+public:
+    const std::string& name;
+    bool found = false;
+    explicit Mentions(const std::string& name) : name(name) {}
+    void visitVariableExpr(VariableExpr* expr) override { found = found || expr->name.lexeme == name; }
+    void visitAssignExpr(AssignExpr* expr) override {
+        found = found || expr->name.lexeme == name;
+        ASTWalker::visitAssignExpr(expr);
+    }
+};
+
+bool mentions(Expression* expr, const std::string& name) {
+    Mentions scan(name);
+    expr->accept(&scan);
+    return scan.found;
+}
+
+// Walks a function or loop body and resolves names against the
+// declarations made inside it. Parameters and loop variables have no
+// VarStmt and map to nullptr; undeclared names live outside.
+class ScopedScan : public ASTWalker {
+protected:
+    std::vector<std::map<std::string, VarStmt*>> scopes{1};
+    std::set<VarStmt*> allocated;  // Initialized with an array literal or allocation
+    std::set<VarStmt*> reassigned;
+    std::vector<std::pair<VarStmt*, Token>> elementWrites; // Into arrays declared here
+
+    // Scope index of the innermost declaration, or -1
+    int depthOf(const std::string& name, VarStmt** declaration = nullptr) const {
+        for (size_t i = scopes.size(); i-- > 0;) {
+            auto found = scopes[i].find(name);
+            if (found == scopes[i].end()) continue;
+            if (declaration) *declaration = found->second;
+            return (int)i;
+        }
+        return -1;
+    }
+
+    // First element write into a local array that might be reachable from
+    // elsewhere: one that was not allocated here or was reassigned
+    const Token* unsafeElementWrite() const {
+        for (const auto& write : elementWrites) {
+            if (!allocated.count(write.first) || reassigned.count(write.first)) return &write.second;
+        }
+        return nullptr;
+    }
+
+public:
+    void visitBlockStmt(BlockStmt* stmt) override {
+        scopes.emplace_back();
+        walk(stmt->statements);
+        scopes.pop_back();
+    }
+    void visitVarStmt(VarStmt* stmt) override {
+        if (stmt->initializer) stmt->initializer->accept(this);
+        scopes.back()[stmt->name.lexeme] = stmt;
+        if (stmt->initializer && dynamic_cast<ArrayExpr*>(stripGroups(stmt->initializer.get()))) allocated.insert(stmt);
+    }
+    void visitFunctionStmt(FunctionStmt*) override {
+        // Checked on its own if it is called
+    }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        stmt->start->accept(this);
+        stmt->end->accept(this);
+        scopes.emplace_back();
+        scopes.back()[stmt->name.lexeme] = nullptr;
+        stmt->body->accept(this);
+        scopes.pop_back();
+    }
+};
+
+// Direct effects of one function on state outside its frame
+class FunctionEffects : public ScopedScan {
+public:
+    std::string problem;
+    std::vector<FunctionStmt*> callees;
+    std::set<std::string> globalsRead;
+
+    explicit FunctionEffects(FunctionStmt* fn) {
+        for (const auto& param : fn->params) scopes.back()[param.lexeme] = nullptr;
+        walk(fn->body);
+        if (const Token* write = unsafeElementWrite()) {
+            note("it writes elements of '" + write->lexeme + "', which may be shared");
+        }
+    }
+
+    void note(const std::string& what) {
+        if (problem.empty()) problem = what;
+    }
+
+    void visitVariableExpr(VariableExpr* expr) override {
+        if (depthOf(expr->name.lexeme) < 0) globalsRead.insert(expr->name.lexeme);
+    }
+    void visitAssignExpr(AssignExpr* expr) override {
+        expr->value->accept(this);
+        VarStmt* declaration = nullptr;
+        if (depthOf(expr->name.lexeme, &declaration) < 0) {
+            note("it assigns the global '" + expr->name.lexeme + "'");
+        } else if (declaration) {
+            reassigned.insert(declaration);
+        }
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        VariableExpr* array = dynamic_cast<VariableExpr*>(stripGroups(expr->array.get()));
+        VarStmt* declaration = nullptr;
+        int depth = array ? depthOf(array->name.lexeme, &declaration) : -1;
+        if (!array) {
+            note("it writes elements of an array it did not allocate");
+            expr->array->accept(this);
+        } else if (depth < 0) {
+            note("it writes elements of the global '" + array->name.lexeme + "'");
+        } else if (!declaration) {
+            note("it writes elements of its parameter '" + array->name.lexeme + "'");
+        } else {
+            elementWrites.push_back({declaration, array->name});
+        }
+        expr->index->accept(this);
+        expr->value->accept(this);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        if (expr->resolved) callees.push_back(expr->resolved);
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitPrintStmt(PrintStmt* stmt) override {
+        note("it prints");
+        ASTWalker::visitPrintStmt(stmt);
+    }
+};
+
+// Checks the body of one parallel for against the rules in race-checker.h
+class LoopBody : public ScopedScan {
+public:
+    struct Reduction {
+        Token name;
+        ReductionOp op;
+    };
+
+    ParallelForStmt* loop;
+    std::vector<Reduction> reductions;
+    std::map<std::string, Token> writtenArrays; // Shared arrays written at [i]
+    std::map<std::string, Token> plainReads;    // Other uses of shared names
+    std::vector<std::pair<FunctionStmt*, Token>> calls;
+
+    explicit LoopBody(ParallelForStmt* loop) : loop(loop) {
+        scopes.back()[loop->name.lexeme] = nullptr;
+        loop->body->accept(this);
+    }
+
+    const Token* unsafeLocalWrite() const { return unsafeElementWrite(); }
+
+    bool isShared(const std::string& name) const { return depthOf(name) < 0; }
+
+    // `i` itself, not a nested declaration of the same name
+    bool isLoopIndex(Expression* expr) const {
+        VariableExpr* var = dynamic_cast<VariableExpr*>(stripGroups(expr));
+        return var && var->name.lexeme == loop->name.lexeme && depthOf(var->name.lexeme) == 0;
+    }
+
+    // `x = x + e` and friends for a shared x; walks `e` if it matches
+    bool matchReduction(Expression* expr) {
+        AssignExpr* assign = dynamic_cast<AssignExpr*>(expr);
+        if (!assign || !isShared(assign->name.lexeme)) return false;
+        const std::string& name = assign->name.lexeme;
+        Expression* value = stripGroups(assign->value.get());
+
+        ReductionOp op = ReductionOp::NONE;
+        Expression* left = nullptr;
+        Expression* right = nullptr;
+        if (BinaryExpr* binary = dynamic_cast<BinaryExpr*>(value)) {
+            if (binary->op.type == TokenType::PLUS) op = ReductionOp::SUM;
+            if (binary->op.type == TokenType::STAR) op = ReductionOp::PRODUCT;
+            left = binary->left.get();
+            right = binary->right.get();
+        } else if (CallExpr* call = dynamic_cast<CallExpr*>(value)) {
+            if (call->arguments.size() == 2 && call->builtin == Builtin::MIN) op = ReductionOp::MIN;
+            if (call->arguments.size() == 2 && call->builtin == Builtin::MAX) op = ReductionOp::MAX;
+            if (op != ReductionOp::NONE) {
+                left = call->arguments[0].get();
+                right = call->arguments[1].get();
+            }
+        }
+        if (op == ReductionOp::NONE) return false;
+
+        Expression* operand = isVariable(left, name) ? right : isVariable(right, name) ? left : nullptr;
+        if (!operand || mentions(operand, name)) return false;
+        reductions.push_back({assign->name, op});
+        operand->accept(this);
+        return true;
+    }
+
+    void visitExpressionStmt(ExpressionStmt* stmt) override {
+        if (!matchReduction(stmt->expression.get())) stmt->expression->accept(this);
+    }
+    void visitVariableExpr(VariableExpr* expr) override {
+        if (isShared(expr->name.lexeme)) plainReads.emplace(expr->name.lexeme, expr->name);
+    }
+    void visitAssignExpr(AssignExpr* expr) override {
+        expr->value->accept(this);
+        VarStmt* declaration = nullptr;
+        int depth = depthOf(expr->name.lexeme, &declaration);
+        if (depth < 0) {
+            const std::string& x = expr->name.lexeme;
+            ErrorHandler::error(expr->name, "'" + x + "' is shared by all iterations of the parallel for; it can only be updated as a reduction (" +
+                                                x + " = " + x + " + e, " + x + " * e, min(" + x + ", e) or max(" + x + ", e)).");
+        } else if (!declaration) {
+            ErrorHandler::error(expr->name, "Cannot assign to the loop variable '" + expr->name.lexeme + "' of a parallel for.");
+        } else {
+            reassigned.insert(declaration);
+        }
+    }
+    void visitIndexExpr(IndexExpr* expr) override {
+        VariableExpr* array = dynamic_cast<VariableExpr*>(stripGroups(expr->array.get()));
+        if (array && isShared(array->name.lexeme) && isLoopIndex(expr->index.get())) return; // a[i]
+        ASTWalker::visitIndexExpr(expr);
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        VariableExpr* array = dynamic_cast<VariableExpr*>(stripGroups(expr->array.get()));
+        VarStmt* declaration = nullptr;
+        int depth = array ? depthOf(array->name.lexeme, &declaration) : -1;
+        if (!array) {
+            ErrorHandler::error(expr->bracket, "Only array variables can be written inside a parallel for.");
+            expr->array->accept(this);
+            expr->index->accept(this);
+        } else if (depth < 0) {
+            if (isLoopIndex(expr->index.get())) {
+                writtenArrays.emplace(array->name.lexeme, array->name);
+            } else {
+                ErrorHandler::error(expr->bracket, "Shared array '" + array->name.lexeme + "' can only be written at the loop index ('" +
+                                                       array->name.lexeme + "[" + loop->name.lexeme + "] = ...') inside a parallel for.");
+                expr->index->accept(this);
+            }
+        } else {
+            if (declaration) elementWrites.push_back({declaration, array->name});
+            expr->index->accept(this);
+        }
+        expr->value->accept(this);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        if (expr->resolved) calls.push_back({expr->resolved, expr->paren});
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitPrintStmt(PrintStmt* stmt) override {
+        ErrorHandler::error(loop->keyword, "A parallel for cannot print: its iterations run in no fixed order.");
+        ASTWalker::visitPrintStmt(stmt);
+    }
+    void visitReturnStmt(ReturnStmt* stmt) override {
+        ErrorHandler::error(stmt->keyword, "Cannot return from inside a parallel for.");
+        ASTWalker::visitReturnStmt(stmt);
+    }
+};
+
+} // namespace
+
+void RaceChecker::checkLoop(ParallelForStmt* loop, SymbolTable& symbols) {
+    LoopBody body(loop);
+    loop->writes.clear();
+    std::set<std::string> writtenGlobals; // What called functions must not read
+
+    for (const auto& reduction : body.reductions) {
+        const std::string& name = reduction.name.lexeme;
+        auto read = body.plainReads.find(name);
+        if (read != body.plainReads.end()) {
+            ErrorHandler::error(read->second, "'" + name + "' is read inside the parallel for, but other iterations update it.");
+            continue;
+        }
+        SymbolInfo info;
+        if (!symbols.get(name, info)) continue; // Undefined; already reported
+        if (info.type != TokenType::TYPE_INT && info.type != TokenType::TYPE_FLOAT) {
+            ErrorHandler::error(reduction.name, "Reduction variable '" + name + "' must be an int or float.");
+            continue;
+        }
+
+        bool seen = false;
+        for (SharedWrite& write : loop->writes) {
+            if (write.name.lexeme != name) continue;
+            seen = true;
+            if (write.op != reduction.op) {
+                ErrorHandler::error(reduction.name, "Reduction of '" + name + "' mixes different operators.");
+            }
+        }
+        if (!seen) loop->writes.push_back(SharedWrite{reduction.name, reduction.op, info.type, Slot()});
+        if (symbols.isGlobal(name)) writtenGlobals.insert(name);
+    }
+
+    for (const auto& written : body.writtenArrays) {
+        auto read = body.plainReads.find(written.first);
+        if (read != body.plainReads.end()) {
+            ErrorHandler::error(read->second, "'" + written.first + "' is written at the loop index, so the parallel for can only read it as '" +
+                                                  written.first + "[" + loop->name.lexeme + "]'.");
+        }
+        SymbolInfo info;
+        if (!symbols.get(written.first, info)) continue;
+        loop->writes.push_back(SharedWrite{written.second, ReductionOp::NONE, info.type, Slot()});
+        if (symbols.isGlobal(written.first)) writtenGlobals.insert(written.first);
+    }
+
+    if (const Token* write = body.unsafeLocalWrite()) {
+        ErrorHandler::error(*write, "Array '" + write->lexeme + "' may be shared with other iterations; a parallel for can only write "
+                                    "arrays it allocates itself at any index.");
+    }
+
+    for (const auto& call : body.calls) calls.push_back({call.first, call.second, writtenGlobals});
+}
+
+const RaceChecker::Effects& RaceChecker::effectsOf(FunctionStmt* fn) {
+    auto found = effects.find(fn);
+    if (found != effects.end()) return found->second;
+    FunctionEffects scan(fn);
+    Effects& result = effects[fn];
+    result.problem = scan.problem;
+    result.callees = scan.callees;
+    result.globalsRead = scan.globalsRead;
+    return result;
+}
+
+void RaceChecker::assume(FunctionStmt* fn, const std::string& problem, const std::set<std::string>& globalsRead) {
+    Effects& facts = effects[fn];
+    facts.problem = problem;
+    facts.callees.clear();
+    facts.globalsRead = globalsRead;
+}
+
+void RaceChecker::summarize(FunctionStmt* fn, std::string& problem, std::set<std::string>& globalsRead) {
+    problem.clear();
+    globalsRead.clear();
+    std::set<FunctionStmt*> seen{fn};
+    std::vector<FunctionStmt*> worklist{fn};
+    while (!worklist.empty()) {
+        FunctionStmt* next = worklist.back();
+        worklist.pop_back();
+        const Effects& facts = effectsOf(next);
+        if (problem.empty() && !facts.problem.empty()) {
+            problem = next == fn ? facts.problem : "it calls '" + next->name.lexeme + "', and " + facts.problem;
+        }
+        globalsRead.insert(facts.globalsRead.begin(), facts.globalsRead.end());
+        for (FunctionStmt* callee : facts.callees) {
+            if (seen.insert(callee).second) worklist.push_back(callee);
+        }
+    }
+}
+
+void RaceChecker::finish() {
+    for (const Call& call : calls) {
+        std::string problem;
+        std::set<std::string> globalsRead;
+        summarize(call.callee, problem, globalsRead);
+        std::string conflict;
+        for (const auto& name : globalsRead) {
+            if (conflict.empty() && call.writtenGlobals.count(name)) conflict = name;
+        }
+
+        const std::string& callee = call.callee->name.lexeme;
+        if (!problem.empty()) {
+            ErrorHandler::error(call.paren, "'" + callee + "' cannot be called inside a parallel for: " + problem + ".");
+        } else if (!conflict.empty()) {
+            ErrorHandler::error(call.paren, "'" + callee + "' reads '" + conflict + "', which this parallel for writes.");
+        }
+    }
+    calls.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "../data/AST.h"
+#include "../util/symbol-table.h"
+
+// Proves that the iterations of a parallel for are independent, so they
+// can run in any order and at the same time.
+//
+// Inside the body, a shared variable (one declared outside it) may only be
+//  - a reduction: updated by statements `x = x + e`, `x = x * e`,
+//    `x = min(x, e)` or `x = max(x, e)` (either operand order, `e` not
+//    mentioning x, one operator per variable) and not read otherwise, or
+//  - an array written at the loop index, `a[i] = e`, and otherwise only
+//    read as `a[i]`.
+// All other shared variables are read-only. An array declared in the body
+// may be written at any index if it was allocated there and is never
+// reassigned. The body cannot print or return.
+//
+// Functions called from the body, directly or not, must not assign
+// globals, write arrays they did not allocate, print, or read a global
+// the loop writes (an array or a reduction variable). Those calls are
+// checked by finish(), once every function has been analyzed.
+class RaceChecker {
+public:
+    // Checks a loop whose body was just type-checked, and fills in
+    // loop->writes. `symbols` no longer contains the body's scopes.
+    void checkLoop(ParallelForStmt* loop, SymbolTable& symbols);
+
+    void finish();
+
+    // Everything `fn` does, its callees included: why it cannot be called
+    // inside a parallel for (empty if it can) and the globals it reads
+    void summarize(FunctionStmt* fn, std::string& problem, std::set<std::string>& globalsRead);
+    // Takes a summary as the whole story of `fn` instead of reading its
+    // body; for functions of imported modules
+    void assume(FunctionStmt* fn, const std::string& problem, const std::set<std::string>& globalsRead);
+
+private:
+    struct Call {
+        FunctionStmt* callee;
+        Token paren;
+        std::set<std::string> writtenGlobals; // Global arrays and reductions the calling loop writes
+    };
+
+    // What a function does by itself, ignoring its callees
+    struct Effects {
+        std::string problem; // Empty if it touches nothing shared
+        std::vector<FunctionStmt*> callees;
+        std::set<std::string> globalsRead;
+    };
+
+    std::vector<Call> calls;
+    std::map<FunctionStmt*, Effects> effects;
+
+    const Effects& effectsOf(FunctionStmt* fn);
+};
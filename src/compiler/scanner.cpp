@@ -13,15 +13,19 @@ std::map<std::string, TokenType> Scanner::keywords = {
     {"true", TokenType::TRUE_KEYWORD},
     {"var", TokenType::VAR},
     {"while", TokenType::WHILE},
+    {"for", TokenType::FOR},
+    {"parallel", TokenType::PARALLEL},
+    {"import", TokenType::IMPORT},
     {"int", TokenType::TYPE_INT},
     {"float", TokenType::TYPE_FLOAT},
-    {"bool", TokenType::TYPE_BOOL}
+    {"bool", TokenType::TYPE_BOOL},
+    {"string", TokenType::TYPE_STRING}
 };
 
 Scanner::Scanner(std::string source) : source(source) {}
 
 std::vector<Token> Scanner::scanTokens() {
-    while (!isAtEnd()) {
+    while (!isAtEnd() && !ErrorHandler::limitReached()) {
         start = current;
         char c = advance();
         switch (c) {
@@ -29,6 +33,8 @@ std::vector<Token> Scanner::scanTokens() {
             case ')': addToken(TokenType::RPAREN); break;
             case '{': addToken(TokenType::LBRACE); break;
             case '}': addToken(TokenType::RBRACE); break;
+            case '[': addToken(TokenType::LBRACKET); break;
+            case ']': addToken(TokenType::RBRACKET); break;
             case ',': addToken(TokenType::COMMA); break;
             case '.': addToken(TokenType::DOT); break;
             case '-': addToken(TokenType::MINUS); break;
@@ -54,6 +60,7 @@ std::vector<Token> Scanner::scanTokens() {
                 break;
             case '\n':
                 line++;
+                lineStart = current;
                 break;
             case '"': string(); break;
             default:
@@ -62,12 +69,12 @@ std::vector<Token> Scanner::scanTokens() {
                 } else if (isalpha(c) || c == '_') {
                     identifier();
                 } else {
-                    ErrorHandler::error(line, "Unexpected character.");
+                    ErrorHandler::error(line, start - lineStart + 1, 1, "Unexpected character.");
                 }
                 break;
         }
     }
-    tokens.emplace_back(TokenType::END_OF_FILE, "", "", line);
+    tokens.emplace_back(TokenType::END_OF_FILE, "", "", line, current - lineStart + 1);
     return tokens;
 }
 
@@ -77,7 +84,8 @@ char Scanner::advance() { return source[current++]; }
 void Scanner::addToken(TokenType type) { addToken(type, ""); }
 void Scanner::addToken(TokenType type, std::string literal) {
     std::string text = source.substr(start, current - start);
-    tokens.emplace_back(type, text, literal, line);
+    // A string spanning lines started before lineStart; its column is unknown
+    tokens.emplace_back(type, text, literal, line, start >= lineStart ? start - lineStart + 1 : 0);
 }
 
 bool Scanner::match(char expected) {
@@ -91,16 +99,41 @@ char Scanner::peek() { return isAtEnd() ? '\0' : source[current]; }
 char Scanner::peekNext() { return (current + 1 >= source.length()) ? '\0' : source[current + 1]; }
 
 void Scanner::string() {
+    int startLine = line;
+    int startColumn = start - lineStart + 1;
+    std::string value;
     while (peek() != '"' && !isAtEnd()) {
-        if (peek() == '\n') line++;
-        advance();
+        if (peek() == '\n') {
+            line++;
+            lineStart = current + 1;
+        }
+        char c = advance();
+        if (c != '\\' || isAtEnd()) {
+            value += c;
+            continue;
+        }
+        // Only \n, \t, \" and \\ are escape sequences
+        int column = current - lineStart;
+        char escaped = advance();
+        switch (escaped) {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            default:
+                ErrorHandler::error(line, column, 2, "Unknown escape sequence '\\" + std::string(1, escaped) + "'.");
+                if (escaped == '\n') {
+                    line++;
+                    lineStart = current;
+                }
+                break;
+        }
     }
     if (isAtEnd()) {
-        ErrorHandler::error(line, "Unterminated string.");
+        ErrorHandler::error(startLine, startColumn, 1, "Unterminated string.");
         return;
     }
     advance(); // The closing ".
-    std::string value = source.substr(start + 1, current - start - 2);
     addToken(TokenType::STRING, value);
 }
 
@@ -11,6 +11,7 @@ private:
     int start = 0;
     int current = 0;
     int line = 1;
+    int lineStart = 0; // Offset of the first character of the current line
 
     static std::map<std::string, TokenType> keywords;
 
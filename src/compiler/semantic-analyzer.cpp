@@ -1,10 +1,71 @@
 #include "semantic-analyzer.h"
+#include "parser.h"
 #include "../util/error-handler.h"
+#include "../util/trace.h"
+
+namespace {
+
+Builtin builtinNamed(const std::string& name) {
+    if (name == "len") return Builtin::LEN;
+    if (name == "sum") return Builtin::SUM;
+    if (name == "dot") return Builtin::DOT;
+    if (name == "min") return Builtin::MIN;
+    if (name == "max") return Builtin::MAX;
+    if (name == "str") return Builtin::STR;
+    return Builtin::NONE;
+}
+
+bool isNumber(TokenType type) { return type == TokenType::TYPE_INT || type == TokenType::TYPE_FLOAT; }
+
+} // namespace
 
 void SemanticAnalyzer::analyze(const std::vector<std::unique_ptr<Statement>>& statements) {
     for (const auto& stmt : statements) {
+        const Token* name = nullptr;
+        if (VarStmt* var = dynamic_cast<VarStmt*>(stmt.get())) name = &var->name;
+        if (FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get())) name = &fn->name;
+        if (name && importedNames.count(name->lexeme)) {
+            ErrorHandler::error(*name, "'" + name->lexeme + "' is already declared by an imported module.");
+            continue;
+        }
         stmt->accept(this);
     }
+    for (size_t i = 0; i < reachedBodies.size(); i++) {
+        auto reached = reachedBodies[i]; // Checking it may reach more
+        checkSkippedBody(reached.first, reached.second);
+    }
+    reachedBodies.clear();
+    raceChecker.finish();
+}
+
+// --- Modules ---
+
+void SemanticAnalyzer::importModule(const ModuleInterface& module, const std::map<std::string, FunctionStmt*>& declarations) {
+    // Two imports declaring one name is reported when modules are linked
+    for (const auto& global : module.globals) {
+        if (symbolTable.declare(global.name, global.type)) importedNames.insert(global.name);
+    }
+    for (const auto& fn : module.functions) {
+        FunctionStmt* declaration = declarations.at(fn.name);
+        if (!symbolTable.declareFunction({fn.name, fn.returnType, fn.paramTypes, declaration})) continue;
+        importedNames.insert(fn.name);
+        raceChecker.assume(declaration, fn.raceProblem, fn.globalsRead);
+    }
+}
+
+ModuleInterface SemanticAnalyzer::exports(const std::vector<std::unique_ptr<Statement>>& statements) {
+    ModuleInterface module;
+    for (const auto& stmt : statements) {
+        if (VarStmt* var = dynamic_cast<VarStmt*>(stmt.get())) {
+            module.globals.push_back({var->name.lexeme, var->type.type, var->name.line, var->name.column});
+        } else if (FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get())) {
+            ModuleInterface::Function exported{fn->name.lexeme, fn->returnType.type, {}, fn->name.line, fn->name.column, "", {}};
+            for (const auto& type : fn->paramTypes) exported.paramTypes.push_back(type.type);
+            raceChecker.summarize(fn, exported.raceProblem, exported.globalsRead);
+            module.functions.push_back(exported);
+        }
+    }
+    return module;
 }
 
 // --- Scopes ---
@@ -20,69 +81,96 @@ void SemanticAnalyzer::visitBlockStmt(BlockStmt* stmt) {
 void SemanticAnalyzer::visitVarStmt(VarStmt* stmt) {
     // 1. Check initializer
     if (stmt->initializer) {
-        stmt->initializer->accept(this);
+        TokenType valueType = check(stmt->initializer.get());
         // Check if initializer type matches variable type
-        if (lastComputedType != stmt->type.type && lastComputedType != TokenType::END_OF_FILE) {
+        if (valueType != stmt->type.type && valueType != TokenType::END_OF_FILE) {
              // Note: END_OF_FILE used here as a placeholder for "unknown/void"
-             // Simplified check. In real compiler, we check implicit casting (int->float).
-             if (stmt->type.type == TokenType::TYPE_FLOAT && lastComputedType == TokenType::TYPE_INT) {
+             if (promote(stmt->initializer.get(), stmt->type.type)) {
                  // Allowed (Implicit cast)
+             } else if (retypeLiteral(stmt->initializer.get(), stmt->type.type)) {
+                 // [1, 2] as a float[]
              } else {
-                 ErrorHandler::error(stmt->name.line, "Type mismatch in initialization.");
+                 ErrorHandler::error(stmt->name, "Type mismatch in initialization.");
              }
         }
     }
 
     // 2. Declare variable
     if (!symbolTable.declare(stmt->name.lexeme, stmt->type.type)) {
-        ErrorHandler::error(stmt->name.line, "Variable with this name already declared in this scope.");
+        ErrorHandler::error(stmt->name, "Variable with this name already declared in this scope.");
     }
 }
 
 void SemanticAnalyzer::visitVariableExpr(VariableExpr* expr) {
     SymbolInfo info;
     if (!symbolTable.get(expr->name.lexeme, info)) {
-        ErrorHandler::error(expr->name.line, "Undefined variable '" + expr->name.lexeme + "'.");
-        lastComputedType = TokenType::END_OF_FILE;
+        ErrorHandler::error(expr->name, "Undefined variable '" + expr->name.lexeme + "'.");
+        expr->type = TokenType::END_OF_FILE;
     } else {
-        lastComputedType = info.type;
+        expr->type = info.type;
     }
 }
 
 void SemanticAnalyzer::visitAssignExpr(AssignExpr* expr) {
-    expr->value->accept(this);
-    TokenType valType = lastComputedType;
+    TokenType valType = check(expr->value.get());
 
     SymbolInfo info;
     if (!symbolTable.get(expr->name.lexeme, info)) {
-        ErrorHandler::error(expr->name.line, "Undefined variable '" + expr->name.lexeme + "'.");
+        ErrorHandler::error(expr->name, "Undefined variable '" + expr->name.lexeme + "'.");
     } else {
-        if (info.type != valType) {
-            // Very basic strict type checking
-             ErrorHandler::error(expr->name.line, "Type mismatch in assignment.");
+        if (info.type != valType && valType != TokenType::END_OF_FILE && !retypeLiteral(expr->value.get(), info.type)) {
+            // Very basic strict type checking (unknown types were already reported)
+             ErrorHandler::error(expr->name, "Type mismatch in assignment.");
         }
-        lastComputedType = info.type;
+        expr->type = info.type;
     }
 }
 
 void SemanticAnalyzer::visitBinaryExpr(BinaryExpr* expr) {
-    expr->left->accept(this);
-    TokenType leftType = lastComputedType;
-    expr->right->accept(this);
-    TokenType rightType = lastComputedType;
+    TokenType leftType = check(expr->left.get());
+    TokenType rightType = check(expr->right.get());
+    // An operand whose type is unknown already produced an error; don't cascade
+    bool unknown = leftType == TokenType::END_OF_FILE || rightType == TokenType::END_OF_FILE;
+    bool numbers = isNumber(leftType) && isNumber(rightType);
+    if (numbers && leftType != rightType) {
+        // Mixed int and float: the int side is widened
+        promote(expr->left.get(), TokenType::TYPE_FLOAT);
+        promote(expr->right.get(), TokenType::TYPE_FLOAT);
+    }
 
     // Simple type checking logic
     if (expr->op.type == TokenType::PLUS || expr->op.type == TokenType::MINUS || 
         expr->op.type == TokenType::STAR || expr->op.type == TokenType::SLASH) {
         
-        if (leftType == TokenType::TYPE_INT && rightType == TokenType::TYPE_INT) {
-            lastComputedType = TokenType::TYPE_INT;
-        } else if ((leftType == TokenType::TYPE_INT || leftType == TokenType::TYPE_FLOAT) &&
-                   (rightType == TokenType::TYPE_INT || rightType == TokenType::TYPE_FLOAT)) {
-            lastComputedType = TokenType::TYPE_FLOAT;
+        if (unknown) {
+            expr->type = TokenType::END_OF_FILE;
+        } else if (leftType == TokenType::TYPE_STRING || rightType == TokenType::TYPE_STRING) {
+            // Concatenation; numbers must be converted explicitly with str()
+            if (expr->op.type == TokenType::PLUS && leftType == rightType) {
+                expr->type = TokenType::TYPE_STRING;
+            } else {
+                ErrorHandler::error(expr->op, expr->op.type == TokenType::PLUS
+                                                  ? "Only strings can be added to strings; use str() to convert."
+                                                  : "Strings only support '+'.");
+                expr->type = TokenType::END_OF_FILE;
+            }
+        } else if (leftType == TokenType::TYPE_INT && rightType == TokenType::TYPE_INT) {
+            expr->type = TokenType::TYPE_INT;
+        } else if (numbers) {
+            expr->type = TokenType::TYPE_FLOAT;
+        } else if ((isArrayType(leftType) || isArrayType(rightType)) &&
+                   leftType != TokenType::TYPE_BOOL && rightType != TokenType::TYPE_BOOL) {
+            // Elementwise: array op array, or array op scalar (the scalar applies to every element)
+            bool anyFloat = leftType == TokenType::TYPE_FLOAT || leftType == TokenType::TYPE_FLOAT_ARRAY ||
+                            rightType == TokenType::TYPE_FLOAT || rightType == TokenType::TYPE_FLOAT_ARRAY;
+            expr->type = anyFloat ? TokenType::TYPE_FLOAT_ARRAY : TokenType::TYPE_INT_ARRAY;
+            if (anyFloat) {
+                promote(expr->left.get(), TokenType::TYPE_FLOAT);
+                promote(expr->right.get(), TokenType::TYPE_FLOAT);
+            }
         } else {
-            ErrorHandler::error(expr->op.line, "Operands must be numbers.");
-            lastComputedType = TokenType::END_OF_FILE;
+            ErrorHandler::error(expr->op, "Operands must be numbers.");
+            expr->type = TokenType::END_OF_FILE;
         }
     } 
     else if (expr->op.type == TokenType::GREATER || expr->op.type == TokenType::LESS ||
@@ -90,38 +178,50 @@ void SemanticAnalyzer::visitBinaryExpr(BinaryExpr* expr) {
              expr->op.type == TokenType::EQUAL_EQUAL || expr->op.type == TokenType::BANG_EQUAL) {
         // Comparison returns BOOL
         // Allow comparing int with int, float with float, or int with float
-        if ((leftType == TokenType::TYPE_INT || leftType == TokenType::TYPE_FLOAT) &&
-            (rightType == TokenType::TYPE_INT || rightType == TokenType::TYPE_FLOAT)) {
+        if (unknown) {
+            // Already reported
+        } else if (numbers) {
             // Numeric comparison is valid
         } else if (leftType == TokenType::TYPE_BOOL && rightType == TokenType::TYPE_BOOL) {
             // Bool comparison is valid
+        } else if (leftType == TokenType::TYPE_STRING && rightType == TokenType::TYPE_STRING) {
+            if (expr->op.type != TokenType::EQUAL_EQUAL && expr->op.type != TokenType::BANG_EQUAL) {
+                ErrorHandler::error(expr->op, "Strings can only be compared with '==' and '!='.");
+            }
         } else {
-            ErrorHandler::error(expr->op.line, "Cannot compare incompatible types.");
+            ErrorHandler::error(expr->op, "Cannot compare incompatible types.");
         }
-        lastComputedType = TokenType::TYPE_BOOL;
+        expr->type = TokenType::TYPE_BOOL;
+    } else {
+        // and / or
+        expr->type = TokenType::TYPE_BOOL;
     }
 }
 
 void SemanticAnalyzer::visitLiteralExpr(LiteralExpr* expr) {
-    lastComputedType = expr->typeHint;
+    expr->type = expr->typeHint;
 }
 
 void SemanticAnalyzer::visitGroupingExpr(GroupingExpr* expr) {
-    expr->expression->accept(this);
+    expr->type = check(expr->expression.get());
 }
 
 void SemanticAnalyzer::visitUnaryExpr(UnaryExpr* expr) {
-    expr->right->accept(this);
+    expr->type = check(expr->right.get());
     // If operator is BANG (!), type must be BOOL
-    if (expr->op.type == TokenType::BANG && lastComputedType != TokenType::TYPE_BOOL) {
-        ErrorHandler::error(expr->op.line, "Expected boolean for '!' operator.");
+    if (expr->op.type == TokenType::BANG && expr->type != TokenType::TYPE_BOOL) {
+        ErrorHandler::error(expr->op, "Expected boolean for '!' operator.");
     }
     // If operator is MINUS (-), type must be Number
+    if (expr->op.type == TokenType::MINUS && expr->type != TokenType::TYPE_INT &&
+        expr->type != TokenType::TYPE_FLOAT && expr->type != TokenType::END_OF_FILE) {
+        ErrorHandler::error(expr->op, "Operand of '-' must be a number.");
+        expr->type = TokenType::END_OF_FILE;
+    }
 }
 
 void SemanticAnalyzer::visitIfStmt(IfStmt* stmt) {
-    stmt->condition->accept(this);
-    if (lastComputedType != TokenType::TYPE_BOOL) {
+    if (check(stmt->condition.get()) != TokenType::TYPE_BOOL) {
         // ErrorHandler::error(..., "Condition must be boolean."); // Location hard to get without token in IfStmt
         // For simplicity, we skip line number here or add Token to IfStmt
     }
@@ -130,16 +230,48 @@ void SemanticAnalyzer::visitIfStmt(IfStmt* stmt) {
 }
 
 void SemanticAnalyzer::visitWhileStmt(WhileStmt* stmt) {
-    stmt->condition->accept(this);
-    if (lastComputedType != TokenType::TYPE_BOOL) {
+    if (check(stmt->condition.get()) != TokenType::TYPE_BOOL) {
          // Error: Condition must be bool
     }
     stmt->body->accept(this);
 }
 
+void SemanticAnalyzer::visitParallelForStmt(ParallelForStmt* stmt) {
+    TokenType startType = check(stmt->start.get());
+    TokenType endType = check(stmt->end.get());
+    if ((startType != TokenType::TYPE_INT && startType != TokenType::END_OF_FILE) ||
+        (endType != TokenType::TYPE_INT && endType != TokenType::END_OF_FILE)) {
+        ErrorHandler::error(stmt->keyword, "Bounds of a parallel for must be ints.");
+    }
+
+    symbolTable.beginScope();
+    symbolTable.declare(stmt->name.lexeme, TokenType::TYPE_INT);
+    stmt->body->accept(this);
+    symbolTable.endScope();
+
+    raceChecker.checkLoop(stmt, symbolTable);
+}
+
 void SemanticAnalyzer::visitFunctionStmt(FunctionStmt* stmt) {
-    symbolTable.declare(stmt->name.lexeme, stmt->returnType.type); // Add func to scope
-    
+    TraceSpan span("analyze function");
+    if (span.active()) {
+        span.rename("analyze " + stmt->name.lexeme);
+        span.arg("line", (long long)stmt->name.line);
+    }
+
+    FunctionSignature signature{stmt->name.lexeme, stmt->returnType.type, {}, stmt};
+    for (const auto& type : stmt->paramTypes) {
+        signature.paramTypes.push_back(type.type);
+    }
+    symbolTable.declareFunction(signature); // Add func to scope
+    if (stmt->lazy) {
+        skippedBodies[stmt] = symbolTable.declarationCount();
+        return;
+    }
+    checkBody(stmt);
+}
+
+void SemanticAnalyzer::checkBody(FunctionStmt* stmt) {
     // Save old state
     bool enclosingFunction = inFunction;
     TokenType enclosingType = currentFunctionReturnType;
@@ -162,14 +294,29 @@ void SemanticAnalyzer::visitFunctionStmt(FunctionStmt* stmt) {
     currentFunctionReturnType = enclosingType;
 }
 
+// Runs with only the global scope open, as the function's own declaration did
+void SemanticAnalyzer::checkSkippedBody(FunctionStmt* stmt, size_t visibleGlobals) {
+    TraceSpan span("analyze function");
+    if (span.active()) {
+        span.rename("analyze " + stmt->name.lexeme);
+        span.arg("line", (long long)stmt->name.line);
+    }
+
+    Parser::parseBody(stmt);
+    symbolTable.hideGlobalsFrom(visibleGlobals);
+    checkBody(stmt);
+    symbolTable.hideGlobalsFrom(SIZE_MAX);
+}
+
 void SemanticAnalyzer::visitReturnStmt(ReturnStmt* stmt) {
     if (!inFunction) {
-        ErrorHandler::error(stmt->keyword.line, "Cannot return from top-level code.");
+        ErrorHandler::error(stmt->keyword, "Cannot return from top-level code.");
     }
     if (stmt->value) {
-        stmt->value->accept(this);
-        if (lastComputedType != currentFunctionReturnType) {
-             ErrorHandler::error(stmt->keyword.line, "Return value does not match function type.");
+        TokenType valueType = check(stmt->value.get());
+        if (valueType != currentFunctionReturnType && valueType != TokenType::END_OF_FILE &&
+            !retypeLiteral(stmt->value.get(), currentFunctionReturnType)) {
+             ErrorHandler::error(stmt->keyword, "Return value does not match function type.");
         }
     }
 }
@@ -183,19 +330,212 @@ void SemanticAnalyzer::visitExpressionStmt(ExpressionStmt* stmt) {
 }
 
 void SemanticAnalyzer::visitCallExpr(CallExpr* expr) {
-    // 1. Check if callee exists (usually a function name)
-    // For this simple project, we aren't tracking Function Signatures in the SymbolTable 
-    // (just that the name exists).
-    // In a real compiler, SymbolInfo would hold vector<Type> paramTypes.
-    
-    expr->callee->accept(this); // Check if function name exists
-    TokenType functionReturnType = lastComputedType; // Store the function's return type
-    
-    // Check arguments
-    for (const auto& arg : expr->arguments) {
-        arg->accept(this);
+    // 1. Resolve the callee. Named functions carry a full signature.
+    const FunctionSignature* signature = nullptr;
+    VariableExpr* callee = dynamic_cast<VariableExpr*>(expr->callee.get());
+    if (callee) {
+        SymbolInfo info;
+        bool declared = symbolTable.get(callee->name.lexeme, info);
+        Builtin builtin = builtinNamed(callee->name.lexeme);
+        if (!declared && builtin != Builtin::NONE) {
+            // Builtins are only used when no declaration shadows them
+            checkBuiltinCall(expr, builtin, callee->name.lexeme);
+            return;
+        }
+        if (!declared) {
+            ErrorHandler::error(callee->name, "Undefined function '" + callee->name.lexeme + "'.");
+        } else if (!info.signature) {
+            ErrorHandler::error(expr->paren, "'" + callee->name.lexeme + "' is not a function.");
+        } else {
+            signature = info.signature;
+            expr->resolved = signature->declaration;
+            auto skipped = skippedBodies.find(expr->resolved);
+            if (skipped != skippedBodies.end()) {
+                reachedBodies.push_back(*skipped);
+                skippedBodies.erase(skipped);
+            }
+        }
+    } else {
+        expr->callee->accept(this);
     }
-    
+
+    // 2. Check arguments against the parameter list
+    if (signature && expr->arguments.size() != signature->paramTypes.size()) {
+        ErrorHandler::error(expr->paren, "Expected " + std::to_string(signature->paramTypes.size()) +
+                                                  " arguments but got " + std::to_string(expr->arguments.size()) + ".");
+    }
+    for (size_t i = 0; i < expr->arguments.size(); i++) {
+        Expression* arg = expr->arguments[i].get();
+        TokenType argType = check(arg);
+        if (!signature || i >= signature->paramTypes.size()) continue;
+
+        TokenType expected = signature->paramTypes[i];
+        if (argType == expected || argType == TokenType::END_OF_FILE) continue;
+        if (promote(arg, expected)) continue; // Implicit cast
+        if (retypeLiteral(arg, expected)) continue;
+        ErrorHandler::error(expr->paren, "Argument " + std::to_string(i + 1) + " of '" + signature->name +
+                                                  "' has the wrong type.");
+    }
+
     // Set the result type to the function's return type
-    lastComputedType = functionReturnType;
-}
\ No newline at end of file
+    expr->type = signature ? signature->returnType : TokenType::END_OF_FILE;
+}
+
+// --- Types ---
+
+TokenType SemanticAnalyzer::check(Expression* expr) {
+    expr->accept(this);
+    return expr->type;
+}
+
+bool SemanticAnalyzer::promote(Expression* expr, TokenType target) {
+    if (target != TokenType::TYPE_FLOAT || expr->type != TokenType::TYPE_INT) return false;
+    expr->promoted = true;
+    return true;
+}
+
+// --- Arrays ---
+
+bool SemanticAnalyzer::retypeLiteral(Expression* value, TokenType target) {
+    if (target != TokenType::TYPE_FLOAT_ARRAY || value->type != TokenType::TYPE_INT_ARRAY) return false;
+    Expression* outer = value;
+    while (GroupingExpr* group = dynamic_cast<GroupingExpr*>(value)) value = group->expression.get();
+    ArrayExpr* literal = dynamic_cast<ArrayExpr*>(value);
+    if (!literal || literal->length) return false;
+    literal->elementType = TokenType::TYPE_FLOAT; // The interpreter converts the elements
+    for (const auto& element : literal->elements) promote(element.get(), TokenType::TYPE_FLOAT);
+    literal->type = target;
+    outer->type = target;
+    return true;
+}
+
+void SemanticAnalyzer::visitArrayExpr(ArrayExpr* expr) {
+    if (expr->length) {
+        TokenType lengthType = check(expr->length.get());
+        if (lengthType != TokenType::TYPE_INT && lengthType != TokenType::END_OF_FILE) {
+            ErrorHandler::error(expr->bracket, "Array length must be an int.");
+        }
+        expr->type = arrayTypeOf(expr->elementType);
+        return;
+    }
+
+    if (expr->elements.empty()) {
+        ErrorHandler::error(expr->bracket, "Empty array literal; use int[0] or float[0] instead.");
+    }
+    bool anyFloat = false;
+    bool unknown = false;
+    for (const auto& element : expr->elements) {
+        TokenType elementType = check(element.get());
+        if (elementType == TokenType::END_OF_FILE) {
+            unknown = true;
+        } else if (!isNumber(elementType)) {
+            ErrorHandler::error(expr->bracket, "Array elements must be int or float.");
+            unknown = true;
+        }
+        anyFloat = anyFloat || elementType == TokenType::TYPE_FLOAT;
+    }
+    if (expr->elementType == TokenType::END_OF_FILE) {
+        expr->elementType = anyFloat ? TokenType::TYPE_FLOAT : TokenType::TYPE_INT;
+    }
+    for (const auto& element : expr->elements) promote(element.get(), expr->elementType);
+    expr->type = unknown || expr->elements.empty() ? TokenType::END_OF_FILE : arrayTypeOf(expr->elementType);
+}
+
+void SemanticAnalyzer::visitIndexExpr(IndexExpr* expr) {
+    TokenType arrayType = check(expr->array.get());
+    TokenType indexType = check(expr->index.get());
+    if (indexType != TokenType::TYPE_INT && indexType != TokenType::END_OF_FILE) {
+        ErrorHandler::error(expr->bracket, "Array index must be an int.");
+    }
+    if (arrayType != TokenType::END_OF_FILE && !isArrayType(arrayType)) {
+        ErrorHandler::error(expr->bracket, "Only arrays can be indexed.");
+    }
+    expr->type = isArrayType(arrayType) ? elementTypeOf(arrayType) : TokenType::END_OF_FILE;
+}
+
+void SemanticAnalyzer::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    TokenType arrayType = check(expr->array.get());
+    TokenType indexType = check(expr->index.get());
+    if (indexType != TokenType::TYPE_INT && indexType != TokenType::END_OF_FILE) {
+        ErrorHandler::error(expr->bracket, "Array index must be an int.");
+    }
+    TokenType valueType = check(expr->value.get());
+
+    if (arrayType != TokenType::END_OF_FILE && !isArrayType(arrayType)) {
+        ErrorHandler::error(expr->bracket, "Only arrays can be indexed.");
+    }
+    if (!isArrayType(arrayType)) {
+        expr->type = TokenType::END_OF_FILE;
+        return;
+    }
+    TokenType elementType = elementTypeOf(arrayType);
+    bool converts = promote(expr->value.get(), elementType);
+    if (valueType != elementType && valueType != TokenType::END_OF_FILE && !converts) {
+        ErrorHandler::error(expr->bracket, "Type mismatch in element assignment.");
+    }
+    expr->type = elementType;
+}
+
+// len(a) -> int; sum/min/max(a) -> element type; dot(a, b) -> int only for two int[];
+// min/max(x, y) of two numbers -> int only for two ints
+void SemanticAnalyzer::checkBuiltinCall(CallExpr* expr, Builtin builtin, const std::string& name) {
+    expr->builtin = builtin;
+    std::vector<TokenType> types;
+    for (const auto& arg : expr->arguments) types.push_back(check(arg.get()));
+    expr->type = TokenType::END_OF_FILE;
+
+    if ((builtin == Builtin::MIN || builtin == Builtin::MAX) && types.size() == 2) {
+        for (size_t i = 0; i < types.size(); i++) {
+            if (types[i] == TokenType::END_OF_FILE) return;
+            if (!isNumber(types[i])) {
+                ErrorHandler::error(expr->paren, "Argument " + std::to_string(i + 1) + " of '" + name + "' must be a number.");
+                return;
+            }
+        }
+        bool ints = types[0] == TokenType::TYPE_INT && types[1] == TokenType::TYPE_INT;
+        expr->type = ints ? TokenType::TYPE_INT : TokenType::TYPE_FLOAT;
+        for (const auto& arg : expr->arguments) promote(arg.get(), expr->type);
+        return;
+    }
+
+    size_t arity = builtin == Builtin::DOT ? 2 : 1;
+    if (types.size() != arity) {
+        ErrorHandler::error(expr->paren, "Expected " + std::to_string(arity) + " arguments but got " +
+                                             std::to_string(types.size()) + ".");
+        return;
+    }
+    if (builtin == Builtin::STR) {
+        if (types[0] != TokenType::END_OF_FILE && !isNumber(types[0]) && types[0] != TokenType::TYPE_BOOL &&
+            types[0] != TokenType::TYPE_STRING) {
+            ErrorHandler::error(expr->paren, "Argument 1 of 'str' must be a number, bool or string.");
+            return;
+        }
+        expr->type = TokenType::TYPE_STRING;
+        return;
+    }
+    if (builtin == Builtin::LEN && types[0] == TokenType::TYPE_STRING) {
+        expr->type = TokenType::TYPE_INT;
+        return;
+    }
+    for (size_t i = 0; i < types.size(); i++) {
+        if (types[i] == TokenType::END_OF_FILE) return;
+        if (!isArrayType(types[i])) {
+            ErrorHandler::error(expr->paren, "Argument " + std::to_string(i + 1) + " of '" + name + "' must be an array" +
+                                                 (builtin == Builtin::LEN ? " or string." : "."));
+            return;
+        }
+    }
+
+    switch (builtin) {
+        case Builtin::LEN:
+            expr->type = TokenType::TYPE_INT;
+            break;
+        case Builtin::DOT:
+            expr->type = types[0] == TokenType::TYPE_INT_ARRAY && types[1] == TokenType::TYPE_INT_ARRAY
+                             ? TokenType::TYPE_INT : TokenType::TYPE_FLOAT;
+            break;
+        default:
+            expr->type = elementTypeOf(types[0]);
+            break;
+    }
+}
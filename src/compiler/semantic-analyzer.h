@@ -1,19 +1,53 @@
 #pragma once
+#include <map>
+#include <set>
 #include "../data/AST.h"
+#include "../data/module-interface.h"
 #include "../util/symbol-table.h"
+#include "race-checker.h"
 
 class SemanticAnalyzer : public ASTVisitor {
 private:
     SymbolTable symbolTable;
     TokenType currentFunctionReturnType;
     bool inFunction = false;
+    RaceChecker raceChecker;
+    std::set<std::string> importedNames; // Declared by importModule()
+
+    // Functions whose bodies the parser skipped (--lazy), with the number
+    // of declarations before each. A body is parsed and checked once a
+    // call reaches it, after the top-level code.
+    std::map<FunctionStmt*, size_t> skippedBodies;
+    std::vector<std::pair<FunctionStmt*, size_t>> reachedBodies;
 
     // Helper to map generic tokens to types if needed
     TokenType getResultType(TokenType t1, TokenType t2, TokenType op);
 
+    // Visits `expr` and returns the type it was given
+    TokenType check(Expression* expr);
+    // Marks an int expression used as a float; false for any other pair
+    bool promote(Expression* expr, TokenType target);
+    // Lets an int array literal initialize a float[] (`var float[] a = [1, 2];`)
+    bool retypeLiteral(Expression* value, TokenType target);
+    void checkBuiltinCall(CallExpr* expr, Builtin builtin, const std::string& name);
+    void checkBody(FunctionStmt* stmt);
+    void checkSkippedBody(FunctionStmt* stmt, size_t visibleGlobals);
+
 public:
     void analyze(const std::vector<std::unique_ptr<Statement>>& statements);
 
+    // Declares the globals and functions of an imported module, before
+    // analyze(). `declarations` maps each function to the FunctionStmt
+    // calls should resolve to (the real one, or a bodiless stand-in when
+    // the module was not analyzed in this build).
+    void importModule(const ModuleInterface& module, const std::map<std::string, FunctionStmt*>& declarations);
+    // The interface of the module just analyzed: its top-level declarations
+    ModuleInterface exports(const std::vector<std::unique_ptr<Statement>>& statements);
+
+    // Every function signature seen during analysis, in declaration order
+    const std::deque<FunctionSignature>& functionSignatures() const { return symbolTable.allSignatures(); }
+    size_t maxScopeDepth() const { return symbolTable.maxScopeDepth(); }
+
     // Visit methods
     void visitBlockStmt(BlockStmt* stmt) override;
     void visitVarStmt(VarStmt* stmt) override;
@@ -26,14 +60,14 @@ public:
     void visitLiteralExpr(LiteralExpr* expr) override;
     void visitUnaryExpr(UnaryExpr* expr) override;
     void visitCallExpr(CallExpr* expr) override;
+    void visitArrayExpr(ArrayExpr* expr) override;
+    void visitIndexExpr(IndexExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
     void visitExpressionStmt(ExpressionStmt* stmt) override;
     void visitFunctionStmt(FunctionStmt* stmt) override;
     void visitIfStmt(IfStmt* stmt) override;
     void visitPrintStmt(PrintStmt* stmt) override;
     void visitReturnStmt(ReturnStmt* stmt) override;
     void visitWhileStmt(WhileStmt* stmt) override;
-
-    // We need a way to store the "Type" of the last evaluated expression
-    // to check against expected types.
-    TokenType lastComputedType; 
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
 };
\ No newline at end of file
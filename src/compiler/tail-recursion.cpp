@@ -0,0 +1,342 @@
+#include "tail-recursion.h"
+#include <algorithm>
+
+namespace {
+
+Token synth(TokenType type, const std::string& lexeme, int line) {
+    return Token(type, lexeme, "", line);
+}
+
+// Expressions built here are typed the way the analyzer would have typed them
+template <typename T>
+std::unique_ptr<T> typed(std::unique_ptr<T> expr, TokenType type) {
+    expr->type = type;
+    return expr;
+}
+
+Expression* stripGrouping(Expression* expr) {
+    while (GroupingExpr* group = dynamic_cast<GroupingExpr*>(expr)) expr = group->expression.get();
+    return expr;
+}
+
+// Finds calls, assignments and variable and element reads inside an expression
+class ExprScan : public ASTWalker {
+public:
+    std::string callee;
+    bool callsCallee = false;
+    bool hasCall = false;
+    bool hasAssign = false;
+    bool readsElement = false;
+    std::vector<std::string> reads;
+
+    void visitCallExpr(CallExpr* expr) override {
+        hasCall = true;
+        VariableExpr* var = dynamic_cast<VariableExpr*>(expr->callee.get());
+        if (var && var->name.lexeme == callee) callsCallee = true;
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitAssignExpr(AssignExpr* expr) override {
+        hasAssign = true;
+        ASTWalker::visitAssignExpr(expr);
+    }
+    void visitVariableExpr(VariableExpr* expr) override { reads.push_back(expr->name.lexeme); }
+    void visitIndexExpr(IndexExpr* expr) override {
+        readsElement = true;
+        ASTWalker::visitIndexExpr(expr);
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        hasAssign = true;
+        ASTWalker::visitIndexAssignExpr(expr);
+    }
+};
+
+} // namespace
+
+int TailRecursionEliminator::run(std::vector<std::unique_ptr<Statement>>& program) {
+    rewritten = 0;
+    walk(program);
+    return rewritten;
+}
+
+void TailRecursionEliminator::visitFunctionStmt(FunctionStmt* stmt) {
+    ASTWalker::visitFunctionStmt(stmt); // Nested functions first
+    if (transform(stmt)) rewritten++;
+}
+
+bool TailRecursionEliminator::isSelfCall(Expression* expr) {
+    CallExpr* call = dynamic_cast<CallExpr*>(stripGrouping(expr));
+    if (!call || call->arguments.size() != function->params.size()) return false;
+    VariableExpr* callee = dynamic_cast<VariableExpr*>(call->callee.get());
+    return callee && callee->name.lexeme == function->name.lexeme;
+}
+
+bool TailRecursionEliminator::hasSelfCall(Expression* expr) {
+    ExprScan scan;
+    scan.callee = function->name.lexeme;
+    expr->accept(&scan);
+    return scan.callsCallee;
+}
+
+bool TailRecursionEliminator::classify(ReturnStmt* stmt, TailSite& outSite) {
+    if (!stmt->value) return false;
+    Expression* value = stripGrouping(stmt->value.get());
+
+    if (isSelfCall(value)) {
+        outSite = {stmt, static_cast<CallExpr*>(value), TokenType::END_OF_FILE, nullptr};
+        return true;
+    }
+
+    // Accumulator patterns only for int, where + and * are associative
+    BinaryExpr* binary = dynamic_cast<BinaryExpr*>(value);
+    if (!binary || function->returnType.type != TokenType::TYPE_INT) return false;
+    if (binary->op.type != TokenType::PLUS && binary->op.type != TokenType::STAR) return false;
+
+    bool callOnLeft = isSelfCall(binary->left.get());
+    bool callOnRight = isSelfCall(binary->right.get());
+    if (callOnLeft == callOnRight) return false;
+
+    Expression* operand = callOnLeft ? binary->right.get() : binary->left.get();
+    ExprScan scan;
+    scan.callee = function->name.lexeme;
+    operand->accept(&scan);
+    if (scan.hasCall || scan.hasAssign) return false;
+
+    if (callOnLeft) {
+        // The operand now runs before the recursive work instead of after it,
+        // so it may only depend on values the call cannot change.
+        if (scan.readsElement) return false;
+        for (const auto& name : scan.reads) {
+            bool isParam = std::any_of(function->params.begin(), function->params.end(),
+                                       [&](const Token& p) { return p.lexeme == name; });
+            if (!isParam) return false;
+        }
+    }
+
+    CallExpr* call = static_cast<CallExpr*>(stripGrouping(callOnLeft ? binary->left.get() : binary->right.get()));
+    outSite = {stmt, call, binary->op.type, operand};
+    return true;
+}
+
+bool TailRecursionEliminator::alwaysReturns(Statement* stmt) {
+    if (dynamic_cast<ReturnStmt*>(stmt)) return true;
+    if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (const auto& s : block->statements) {
+            if (alwaysReturns(s.get())) return true;
+        }
+        return false;
+    }
+    if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        return ifStmt->elseBranch && alwaysReturns(ifStmt->thenBranch.get()) && alwaysReturns(ifStmt->elseBranch.get());
+    }
+    return false;
+}
+
+// `if (c) { ...return; } rest` becomes `if (c) { ...return; } else { rest }`,
+// which puts returns inside `rest` into tail position.
+void TailRecursionEliminator::normalize(std::vector<std::unique_ptr<Statement>>& statements) {
+    for (size_t i = 0; i < statements.size(); i++) {
+        Statement* stmt = statements[i].get();
+        if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+            normalize(block->statements);
+            continue;
+        }
+        IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt);
+        if (!ifStmt) continue;
+
+        if (!ifStmt->elseBranch && i + 1 < statements.size() && alwaysReturns(ifStmt->thenBranch.get())) {
+            std::vector<std::unique_ptr<Statement>> rest;
+            for (size_t j = i + 1; j < statements.size(); j++) rest.push_back(std::move(statements[j]));
+            statements.resize(i + 1);
+            ifStmt->elseBranch = std::make_unique<BlockStmt>(std::move(rest));
+        }
+
+        for (Statement* branch : {ifStmt->thenBranch.get(), ifStmt->elseBranch.get()}) {
+            BlockStmt* block = dynamic_cast<BlockStmt*>(branch);
+            if (block) normalize(block->statements);
+        }
+    }
+}
+
+// Only returns that end the loop body structurally can be turned into
+// "assign and loop again"; anything inside a while body or followed by
+// more statements keeps its real call. So do returns in a block that
+// declares a local named like a parameter: the reassignments would go to
+// the local.
+void TailRecursionEliminator::collectSites(std::vector<std::unique_ptr<Statement>>& statements, bool tail, bool shadowed) {
+    for (const auto& stmt : statements) {
+        VarStmt* var = dynamic_cast<VarStmt*>(stmt.get());
+        if (var && std::any_of(function->params.begin(), function->params.end(),
+                               [&](const Token& p) { return p.lexeme == var->name.lexeme; })) {
+            shadowed = true;
+        }
+    }
+    for (size_t i = 0; i < statements.size(); i++) {
+        collectSites(statements[i].get(), tail && i + 1 == statements.size(), shadowed);
+    }
+}
+
+void TailRecursionEliminator::collectSites(Statement* stmt, bool tail, bool shadowed) {
+    if (!tail) return;
+    if (ReturnStmt* ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        TailSite site;
+        if (!shadowed && classify(ret, site)) sites.push_back(site);
+    } else if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        collectSites(block->statements, true, shadowed);
+    } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        collectSites(ifStmt->thenBranch.get(), true, shadowed);
+        if (ifStmt->elseBranch) collectSites(ifStmt->elseBranch.get(), true, shadowed);
+    }
+}
+
+std::unique_ptr<Statement> TailRecursionEliminator::makeLoopBack(const TailSite& site) {
+    int line = site.stmt->keyword.line;
+    std::vector<std::unique_ptr<Statement>> stmts;
+
+    if (site.accumulatorOp != TokenType::END_OF_FILE) {
+        Token acc = synth(TokenType::IDENTIFIER, "tco$acc", line);
+        Token op = synth(site.accumulatorOp, site.accumulatorOp == TokenType::STAR ? "*" : "+", line);
+
+        // Detach the operand from the return expression before it is destroyed
+        BinaryExpr* binary = static_cast<BinaryExpr*>(stripGrouping(site.stmt->value.get()));
+        std::unique_ptr<Expression> operand = binary->left.get() == site.operand ? std::move(binary->left)
+                                                                                 : std::move(binary->right);
+        auto update = typed(std::make_unique<BinaryExpr>(typed(std::make_unique<VariableExpr>(acc), TokenType::TYPE_INT), op,
+                                                         std::make_unique<GroupingExpr>(std::move(operand))),
+                            TokenType::TYPE_INT);
+        stmts.push_back(std::make_unique<ExpressionStmt>(
+            typed(std::make_unique<AssignExpr>(acc, std::move(update)), TokenType::TYPE_INT)));
+    }
+
+    // Evaluate every argument before any parameter changes
+    auto& args = site.call->arguments;
+    const auto& params = function->params;
+    std::vector<std::unique_ptr<Statement>> assigns;
+    for (size_t i = 0; i < params.size(); i++) {
+        TokenType type = function->paramTypes[i].type;
+        VariableExpr* same = dynamic_cast<VariableExpr*>(args[i].get());
+        if (same && same->name.lexeme == params[i].lexeme) continue; // Unchanged
+
+        if (params.size() == 1) {
+            assigns.push_back(std::make_unique<ExpressionStmt>(typed(std::make_unique<AssignExpr>(params[i], std::move(args[i])), type)));
+            continue;
+        }
+        Token temp = synth(TokenType::IDENTIFIER, "tco$" + params[i].lexeme, line);
+        stmts.push_back(std::make_unique<VarStmt>(temp, function->paramTypes[i], std::move(args[i])));
+        assigns.push_back(std::make_unique<ExpressionStmt>(
+            typed(std::make_unique<AssignExpr>(params[i], typed(std::make_unique<VariableExpr>(temp), type)), type)));
+    }
+    for (auto& assign : assigns) stmts.push_back(std::move(assign));
+
+    Token loop = synth(TokenType::IDENTIFIER, "tco$loop", line);
+    stmts.push_back(std::make_unique<ExpressionStmt>(
+        typed(std::make_unique<AssignExpr>(loop, std::make_unique<LiteralExpr>("true", TokenType::TYPE_BOOL)), TokenType::TYPE_BOOL)));
+    return std::make_unique<BlockStmt>(std::move(stmts));
+}
+
+void TailRecursionEliminator::rewrite(std::vector<std::unique_ptr<Statement>>& statements) {
+    for (auto& stmt : statements) rewrite(stmt);
+}
+
+void TailRecursionEliminator::rewrite(std::unique_ptr<Statement>& slot) {
+    Statement* stmt = slot.get();
+    if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        rewrite(block->statements);
+    } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        rewrite(ifStmt->thenBranch);
+        if (ifStmt->elseBranch) rewrite(ifStmt->elseBranch);
+    } else if (WhileStmt* whileStmt = dynamic_cast<WhileStmt*>(stmt)) {
+        rewrite(whileStmt->body);
+    } else if (ReturnStmt* ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        for (const auto& site : sites) {
+            if (site.stmt == ret) {
+                slot = makeLoopBack(site);
+                return;
+            }
+        }
+        if (accumulatorOp == TokenType::END_OF_FILE) return;
+
+        // Every other exit folds the accumulator into its result
+        int line = ret->keyword.line;
+        Token acc = synth(TokenType::IDENTIFIER, "tco$acc", line);
+        Token op = synth(accumulatorOp, accumulatorOp == TokenType::STAR ? "*" : "+", line);
+        std::unique_ptr<Expression> value = ret->value ? std::move(ret->value)
+                                                       : std::make_unique<LiteralExpr>("0", TokenType::TYPE_INT);
+        ret->value = typed(std::make_unique<BinaryExpr>(typed(std::make_unique<VariableExpr>(acc), TokenType::TYPE_INT), op,
+                                                        std::make_unique<GroupingExpr>(std::move(value))),
+                           TokenType::TYPE_INT);
+    }
+    // Nested FunctionStmts are transformed on their own
+}
+
+bool TailRecursionEliminator::transform(FunctionStmt* stmt) {
+    function = stmt;
+    sites.clear();
+    accumulatorOp = TokenType::END_OF_FILE;
+
+    // Cheap pre-check before restructuring anything
+    bool candidate = false;
+    class ReturnScan : public ASTWalker {
+    public:
+        TailRecursionEliminator* self;
+        bool* found;
+        void visitReturnStmt(ReturnStmt* ret) override {
+            if (ret->value && self->hasSelfCall(ret->value.get())) *found = true;
+        }
+        void visitFunctionStmt(FunctionStmt*) override {}
+    } scan;
+    scan.self = this;
+    scan.found = &candidate;
+    for (const auto& s : stmt->body) s->accept(&scan);
+    if (!candidate) return false;
+
+    normalize(stmt->body);
+    collectSites(stmt->body, true, false);
+    if (sites.empty()) return false;
+
+    // One accumulator operator per function; the minority keeps real calls
+    int plus = 0, star = 0;
+    for (const auto& site : sites) {
+        if (site.accumulatorOp == TokenType::PLUS) plus++;
+        if (site.accumulatorOp == TokenType::STAR) star++;
+    }
+    if (plus + star > 0) {
+        accumulatorOp = star >= plus ? TokenType::STAR : TokenType::PLUS;
+        sites.erase(std::remove_if(sites.begin(), sites.end(), [&](const TailSite& s) {
+                        return s.accumulatorOp != TokenType::END_OF_FILE && s.accumulatorOp != accumulatorOp;
+                    }),
+                    sites.end());
+    }
+
+    rewrite(stmt->body);
+
+    int line = stmt->name.line;
+    Token loop = synth(TokenType::IDENTIFIER, "tco$loop", line);
+    Token boolType = synth(TokenType::TYPE_BOOL, "bool", line);
+    std::vector<std::unique_ptr<Statement>> loopBody;
+    loopBody.push_back(std::make_unique<ExpressionStmt>(
+        typed(std::make_unique<AssignExpr>(loop, std::make_unique<LiteralExpr>("false", TokenType::TYPE_BOOL)), TokenType::TYPE_BOOL)));
+    for (auto& s : stmt->body) loopBody.push_back(std::move(s));
+
+    std::vector<std::unique_ptr<Statement>> body;
+    if (accumulatorOp != TokenType::END_OF_FILE) {
+        Token acc = synth(TokenType::IDENTIFIER, "tco$acc", line);
+        Token intType = synth(TokenType::TYPE_INT, "int", line);
+        std::string identity = accumulatorOp == TokenType::STAR ? "1" : "0";
+        body.push_back(std::make_unique<VarStmt>(acc, intType, std::make_unique<LiteralExpr>(identity, TokenType::TYPE_INT)));
+    }
+    body.push_back(std::make_unique<VarStmt>(loop, boolType, std::make_unique<LiteralExpr>("true", TokenType::TYPE_BOOL)));
+    body.push_back(std::make_unique<WhileStmt>(typed(std::make_unique<VariableExpr>(loop), TokenType::TYPE_BOOL),
+                                               std::make_unique<BlockStmt>(std::move(loopBody)), line));
+    if (accumulatorOp != TokenType::END_OF_FILE) {
+        // Reached only when the original body fell off the end (result 0)
+        Token acc = synth(TokenType::IDENTIFIER, "tco$acc", line);
+        Token op = synth(accumulatorOp, accumulatorOp == TokenType::STAR ? "*" : "+", line);
+        body.push_back(std::make_unique<ReturnStmt>(
+            synth(TokenType::RETURN, "return", line),
+            typed(std::make_unique<BinaryExpr>(typed(std::make_unique<VariableExpr>(acc), TokenType::TYPE_INT), op,
+                                               std::make_unique<LiteralExpr>("0", TokenType::TYPE_INT)),
+                  TokenType::TYPE_INT)));
+    }
+    stmt->body = std::move(body);
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../data/AST.h"
+
+// Rewrites self-recursive calls in tail position (`return f(...)`) into a
+// loop that reassigns the parameters, so recursion depth no longer grows.
+//
+// For int functions, `return e * f(...)` / `return e + f(...)` (either
+// operand order) are handled too by introducing an accumulator:
+//
+//     var int tco$acc = 1;
+//     var bool tco$loop = true;
+//     while (tco$loop) {
+//         tco$loop = false;
+//         ...  // return x;         ->  return tco$acc * (x);
+//         ...  // return n * f(m);  ->  tco$acc = tco$acc * (n); n = m; tco$loop = true;
+//     }
+//     return tco$acc * 0;           // Original body fell off the end
+//
+// Must run after semantic analysis. Synthesized names contain '$' so they
+// can never clash with user identifiers.
+class TailRecursionEliminator : public ASTWalker {
+private:
+    struct TailSite {
+        ReturnStmt* stmt;
+        CallExpr* call;
+        TokenType accumulatorOp; // PLUS/STAR, or END_OF_FILE for a plain tail call
+        Expression* operand;     // The non-recursive side of the accumulator pattern
+    };
+
+    FunctionStmt* function = nullptr;
+    TokenType accumulatorOp = TokenType::END_OF_FILE;
+    std::vector<TailSite> sites;
+    int rewritten = 0;
+
+    bool isSelfCall(Expression* expr);
+    bool hasSelfCall(Expression* expr);
+    bool classify(ReturnStmt* stmt, TailSite& outSite);
+    bool alwaysReturns(Statement* stmt);
+    void normalize(std::vector<std::unique_ptr<Statement>>& statements);
+    void collectSites(std::vector<std::unique_ptr<Statement>>& statements, bool tail, bool shadowed);
+    void collectSites(Statement* stmt, bool tail, bool shadowed);
+    void rewrite(std::unique_ptr<Statement>& slot);
+    void rewrite(std::vector<std::unique_ptr<Statement>>& statements);
+    std::unique_ptr<Statement> makeLoopBack(const TailSite& site);
+    bool transform(FunctionStmt* stmt);
+
+public:
+    // Returns the number of functions that were rewritten
+    int run(std::vector<std::unique_ptr<Statement>>& program);
+
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+};
@@ -1,5 +1,7 @@
 #pragma once
-#include "Token.h"
+#include "token.h"
+#include "value.h"
+#include <cstdlib>
 #include <vector>
 #include <memory>
 #include <string>
@@ -12,6 +14,9 @@ class UnaryExpr;
 class VariableExpr;
 class AssignExpr;
 class CallExpr;
+class ArrayExpr;
+class IndexExpr;
+class IndexAssignExpr;
 
 class BlockStmt;
 class ExpressionStmt;
@@ -21,6 +26,7 @@ class PrintStmt;
 class ReturnStmt;
 class VarStmt;
 class WhileStmt;
+class ParallelForStmt;
 
 class ASTVisitor {
 public:
@@ -31,6 +37,9 @@ public:
     virtual void visitVariableExpr(VariableExpr* expr) = 0;
     virtual void visitAssignExpr(AssignExpr* expr) = 0;
     virtual void visitCallExpr(CallExpr* expr) = 0;
+    virtual void visitArrayExpr(ArrayExpr* expr) = 0;
+    virtual void visitIndexExpr(IndexExpr* expr) = 0;
+    virtual void visitIndexAssignExpr(IndexAssignExpr* expr) = 0;
 
     virtual void visitBlockStmt(BlockStmt* stmt) = 0;
     virtual void visitExpressionStmt(ExpressionStmt* stmt) = 0;
@@ -40,6 +49,7 @@ public:
     virtual void visitReturnStmt(ReturnStmt* stmt) = 0;
     virtual void visitVarStmt(VarStmt* stmt) = 0;
     virtual void visitWhileStmt(WhileStmt* stmt) = 0;
+    virtual void visitParallelForStmt(ParallelForStmt* stmt) = 0;
 };
 
 class ASTNode {
@@ -48,9 +58,30 @@ public:
     virtual void accept(ASTVisitor* visitor) = 0;
 };
 
-class Expression : public ASTNode {};
+// Every expression carries its static type, set once by SemanticAnalyzer
+// (END_OF_FILE while unknown, or after an error that was reported), and
+// whether its value is widened from int to float where it is used: as the
+// initializer of a float variable, an argument for a float parameter, an
+// element of a float array, or the int operand next to a float one.
+// Passes that build expressions after analysis fill both in themselves.
+class Expression : public ASTNode {
+public:
+    TokenType type = TokenType::END_OF_FILE;
+    bool promoted = false;
+
+    // The type the surrounding code sees
+    TokenType usedType() const { return promoted ? TokenType::TYPE_FLOAT : type; }
+};
+
 class Statement : public ASTNode {};
 
+// Storage assigned to a variable by the interpreter's resolver: a global
+// index, or a slot in the current call frame.
+struct Slot {
+    bool global = false;
+    int index = -1;
+};
+
 // --- Expression Implementations ---
 
 class BinaryExpr : public Expression {
@@ -66,15 +97,27 @@ public:
 class GroupingExpr : public Expression {
 public:
     std::unique_ptr<Expression> expression;
-    GroupingExpr(std::unique_ptr<Expression> expression) : expression(std::move(expression)) {}
+    GroupingExpr(std::unique_ptr<Expression> expression) : expression(std::move(expression)) {
+        type = this->expression->type;
+    }
     void accept(ASTVisitor* visitor) override { visitor->visitGroupingExpr(this); }
 };
 
 class LiteralExpr : public Expression {
 public:
     std::string value;
-    TokenType typeHint; // Helper to know if it's int/float/bool
-    LiteralExpr(std::string value, TokenType typeHint) : value(value), typeHint(typeHint) {}
+    TokenType typeHint; // Helper to know if it's int/float/bool/string
+    Value constant;     // The parsed value, so evaluators never re-parse the text
+    LiteralExpr(std::string value, TokenType typeHint) : value(value), typeHint(typeHint) {
+        type = typeHint;
+        switch (typeHint) {
+            case TokenType::TYPE_INT: constant = Value::ofInt(Value::wrap(std::strtoll(value.c_str(), nullptr, 10))); break;
+            case TokenType::TYPE_FLOAT: constant = Value::ofFloat(std::strtod(value.c_str(), nullptr)); break;
+            case TokenType::TYPE_BOOL: constant = Value::ofBool(value == "true"); break;
+            case TokenType::TYPE_STRING: constant = Value::ofString(StringPool::intern(value)); break;
+            default: break;
+        }
+    }
     void accept(ASTVisitor* visitor) override { visitor->visitLiteralExpr(this); }
 };
 
@@ -89,6 +132,7 @@ public:
 class VariableExpr : public Expression {
 public:
     Token name;
+    Slot slot;
     VariableExpr(Token name) : name(name) {}
     void accept(ASTVisitor* visitor) override { visitor->visitVariableExpr(this); }
 };
@@ -97,20 +141,66 @@ class AssignExpr : public Expression {
 public:
     Token name;
     std::unique_ptr<Expression> value;
+    Slot slot;
     AssignExpr(Token name, std::unique_ptr<Expression> value) : name(name), value(std::move(value)) {}
     void accept(ASTVisitor* visitor) override { visitor->visitAssignExpr(this); }
 };
 
+// Array operations built into the language; they are called like functions
+// but only when no user function of the same name is in scope.
+enum class Builtin { NONE, LEN, SUM, DOT, MIN, MAX, STR };
+
 class CallExpr : public Expression {
 public:
     std::unique_ptr<Expression> callee;
     Token paren; // Location for errors
     std::vector<std::unique_ptr<Expression>> arguments;
+    FunctionStmt* resolved = nullptr; // Callee declaration, filled in by SemanticAnalyzer
+    Builtin builtin = Builtin::NONE;  // Set by SemanticAnalyzer instead of `resolved`
     CallExpr(std::unique_ptr<Expression> callee, Token paren, std::vector<std::unique_ptr<Expression>> arguments)
         : callee(std::move(callee)), paren(paren), arguments(std::move(arguments)) {}
     void accept(ASTVisitor* visitor) override { visitor->visitCallExpr(this); }
 };
 
+// `[1, 2, 3]` (elements) or `float[n]` (a zero-filled array of `length`
+// elements). A literal's element type is settled by SemanticAnalyzer,
+// since `[1, 2]` may also initialize a float[].
+class ArrayExpr : public Expression {
+public:
+    Token bracket;
+    TokenType elementType; // TYPE_INT or TYPE_FLOAT; END_OF_FILE until known
+    std::vector<std::unique_ptr<Expression>> elements;
+    std::unique_ptr<Expression> length; // Set for allocations only
+    ArrayExpr(Token bracket, TokenType elementType, std::vector<std::unique_ptr<Expression>> elements,
+              std::unique_ptr<Expression> length)
+        : bracket(bracket), elementType(elementType), elements(std::move(elements)), length(std::move(length)) {}
+    void accept(ASTVisitor* visitor) override { visitor->visitArrayExpr(this); }
+};
+
+class IndexExpr : public Expression {
+public:
+    std::unique_ptr<Expression> array;
+    Token bracket; // Location for errors
+    std::unique_ptr<Expression> index;
+    IndexExpr(std::unique_ptr<Expression> array, Token bracket, std::unique_ptr<Expression> index)
+        : array(std::move(array)), bracket(bracket), index(std::move(index)) {}
+    void accept(ASTVisitor* visitor) override { visitor->visitIndexExpr(this); }
+};
+
+// `a[i] = v`; arrays are shared by reference, so this is visible through
+// every variable holding the same array.
+class IndexAssignExpr : public Expression {
+public:
+    std::unique_ptr<Expression> array;
+    Token bracket;
+    std::unique_ptr<Expression> index;
+    std::unique_ptr<Expression> value;
+    IndexAssignExpr(std::unique_ptr<Expression> array, Token bracket, std::unique_ptr<Expression> index,
+                    std::unique_ptr<Expression> value)
+        : array(std::move(array)), bracket(bracket), index(std::move(index)), value(std::move(value)) {}
+    void accept(ASTVisitor* visitor) override { visitor->visitIndexAssignExpr(this); }
+};
+
 // --- Statement Implementations ---
 
 class BlockStmt : public Statement {
@@ -127,6 +217,14 @@ public:
     void accept(ASTVisitor* visitor) override { visitor->visitExpressionStmt(this); }
 };
 
+// A function body the parser skipped (--lazy): the tokens between its
+// braces, turned into statements by Parser::parseBody when a call reaches it
+struct LazyBody {
+    std::shared_ptr<const std::vector<Token>> tokens;
+    int begin; // First token after '{'
+    int end;   // The closing '}'
+};
+
 class FunctionStmt : public Statement {
 public:
     Token name;
@@ -134,6 +232,8 @@ public:
     std::vector<Token> params;      // Parameter names
     std::vector<Token> paramTypes;  // Parameter types
     std::vector<std::unique_ptr<Statement>> body;
+    std::unique_ptr<LazyBody> lazy; // Set while the body is unparsed
+    int frameSize = -1; // Locals incl. parameters; -1 until resolved
     FunctionStmt(Token name, Token returnType, std::vector<Token> params, std::vector<Token> paramTypes, std::vector<std::unique_ptr<Statement>> body)
         : name(name), returnType(returnType), params(params), paramTypes(paramTypes), body(std::move(body)) {}
     void accept(ASTVisitor* visitor) override { visitor->visitFunctionStmt(this); }
@@ -144,8 +244,11 @@ public:
     std::unique_ptr<Expression> condition;
     std::unique_ptr<Statement> thenBranch;
     std::unique_ptr<Statement> elseBranch;
-    IfStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> thenBranch, std::unique_ptr<Statement> elseBranch)
-        : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
+    int line, column; // Of the `if` keyword; keys for execution profiles
+    IfStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> thenBranch, std::unique_ptr<Statement> elseBranch,
+           int line = 0, int column = 0)
+        : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)),
+          line(line), column(column) {}
     void accept(ASTVisitor* visitor) override { visitor->visitIfStmt(this); }
 };
 
@@ -169,6 +272,7 @@ public:
     Token name;
     Token type; 
     std::unique_ptr<Expression> initializer;
+    Slot slot;
     VarStmt(Token name, Token type, std::unique_ptr<Expression> initializer)
         : name(name), type(type), initializer(std::move(initializer)) {}
     void accept(ASTVisitor* visitor) override { visitor->visitVarStmt(this); }
@@ -178,7 +282,166 @@ class WhileStmt : public Statement {
 public:
     std::unique_ptr<Expression> condition;
     std::unique_ptr<Statement> body;
-    WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body)
-        : condition(std::move(condition)), body(std::move(body)) {}
+    int line, column; // Of the `while` keyword, for diagnostics and profiles
+    WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body, int line = 0, int column = 0)
+        : condition(std::move(condition)), body(std::move(body)), line(line), column(column) {}
     void accept(ASTVisitor* visitor) override { visitor->visitWhileStmt(this); }
-};
\ No newline at end of file
+};
+
+// How a parallel for combines the per-iteration updates of a shared
+// variable; NONE marks an array that is only written at the loop index.
+enum class ReductionOp { NONE, SUM, PRODUCT, MIN, MAX };
+
+// A variable declared outside a parallel for that its body writes
+struct SharedWrite {
+    Token name;
+    ReductionOp op = ReductionOp::NONE;
+    TokenType type = TokenType::END_OF_FILE; // Declared type of the variable
+    Slot slot;
+};
+
+// `parallel for (var int i = start; i < end; i = i + 1) body`. Both bounds
+// are evaluated once, before the first iteration, and iterations may run
+// concurrently. SemanticAnalyzer checks that they are independent and
+// records the shared variables they write in `writes`.
+class ParallelForStmt : public Statement {
+public:
+    Token keyword;
+    Token name; // The loop variable, an int local to the body
+    std::unique_ptr<Expression> start;
+    std::unique_ptr<Expression> end;
+    std::unique_ptr<Statement> body;
+    Slot slot;
+    std::vector<SharedWrite> writes;
+    ParallelForStmt(Token keyword, Token name, std::unique_ptr<Expression> start, std::unique_ptr<Expression> end,
+                    std::unique_ptr<Statement> body)
+        : keyword(keyword), name(name), start(std::move(start)), end(std::move(end)), body(std::move(body)) {}
+    void accept(ASTVisitor* visitor) override { visitor->visitParallelForStmt(this); }
+};
+
+// --- Default traversal ---
+
+// Visits every child node. Passes that only care about a few node kinds
+// derive from this and call the base method to keep descending.
+class ASTWalker : public ASTVisitor {
+public:
+    void walk(const std::vector<std::unique_ptr<Statement>>& statements) {
+        for (const auto& stmt : statements) {
+            if (stmt) stmt->accept(this);
+        }
+    }
+
+    void visitBinaryExpr(BinaryExpr* expr) override {
+        expr->left->accept(this);
+        expr->right->accept(this);
+    }
+    void visitGroupingExpr(GroupingExpr* expr) override { expr->expression->accept(this); }
+    void visitLiteralExpr(LiteralExpr*) override {}
+    void visitUnaryExpr(UnaryExpr* expr) override { expr->right->accept(this); }
+    void visitVariableExpr(VariableExpr*) override {}
+    void visitAssignExpr(AssignExpr* expr) override { expr->value->accept(this); }
+    void visitCallExpr(CallExpr* expr) override {
+        expr->callee->accept(this);
+        for (const auto& arg : expr->arguments) arg->accept(this);
+    }
+    void visitArrayExpr(ArrayExpr* expr) override {
+        for (const auto& element : expr->elements) element->accept(this);
+        if (expr->length) expr->length->accept(this);
+    }
+    void visitIndexExpr(IndexExpr* expr) override {
+        expr->array->accept(this);
+        expr->index->accept(this);
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        expr->array->accept(this);
+        expr->index->accept(this);
+        expr->value->accept(this);
+    }
+
+    void visitBlockStmt(BlockStmt* stmt) override { walk(stmt->statements); }
+    void visitExpressionStmt(ExpressionStmt* stmt) override { stmt->expression->accept(this); }
+    void visitFunctionStmt(FunctionStmt* stmt) override { walk(stmt->body); }
+    void visitIfStmt(IfStmt* stmt) override {
+        stmt->condition->accept(this);
+        stmt->thenBranch->accept(this);
+        if (stmt->elseBranch) stmt->elseBranch->accept(this);
+    }
+    void visitPrintStmt(PrintStmt* stmt) override { stmt->expression->accept(this); }
+    void visitReturnStmt(ReturnStmt* stmt) override {
+        if (stmt->value) stmt->value->accept(this);
+    }
+    void visitVarStmt(VarStmt* stmt) override {
+        if (stmt->initializer) stmt->initializer->accept(this);
+    }
+    void visitWhileStmt(WhileStmt* stmt) override {
+        stmt->condition->accept(this);
+        stmt->body->accept(this);
+    }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        stmt->start->accept(this);
+        stmt->end->accept(this);
+        stmt->body->accept(this);
+    }
+};
+
+// Like ASTWalker, but hands every child through its owning slot so a pass
+// can replace nodes in place. Override rewrite() and call the base version
+// to keep descending.
+class ASTRewriter : public ASTWalker {
+public:
+    virtual void rewrite(std::unique_ptr<Expression>& slot) {
+        if (slot) slot->accept(this);
+    }
+    virtual void rewrite(std::unique_ptr<Statement>& slot) {
+        if (slot) slot->accept(this);
+    }
+    void rewrite(std::vector<std::unique_ptr<Statement>>& statements) {
+        for (auto& stmt : statements) rewrite(stmt);
+    }
+
+    void visitBinaryExpr(BinaryExpr* expr) override {
+        rewrite(expr->left);
+        rewrite(expr->right);
+    }
+    void visitGroupingExpr(GroupingExpr* expr) override { rewrite(expr->expression); }
+    void visitUnaryExpr(UnaryExpr* expr) override { rewrite(expr->right); }
+    void visitAssignExpr(AssignExpr* expr) override { rewrite(expr->value); }
+    void visitCallExpr(CallExpr* expr) override {
+        rewrite(expr->callee);
+        for (auto& arg : expr->arguments) rewrite(arg);
+    }
+    void visitArrayExpr(ArrayExpr* expr) override {
+        for (auto& element : expr->elements) rewrite(element);
+        rewrite(expr->length);
+    }
+    void visitIndexExpr(IndexExpr* expr) override {
+        rewrite(expr->array);
+        rewrite(expr->index);
+    }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override {
+        rewrite(expr->array);
+        rewrite(expr->index);
+        rewrite(expr->value);
+    }
+
+    void visitBlockStmt(BlockStmt* stmt) override { rewrite(stmt->statements); }
+    void visitExpressionStmt(ExpressionStmt* stmt) override { rewrite(stmt->expression); }
+    void visitFunctionStmt(FunctionStmt* stmt) override { rewrite(stmt->body); }
+    void visitIfStmt(IfStmt* stmt) override {
+        rewrite(stmt->condition);
+        rewrite(stmt->thenBranch);
+        rewrite(stmt->elseBranch);
+    }
+    void visitPrintStmt(PrintStmt* stmt) override { rewrite(stmt->expression); }
+    void visitReturnStmt(ReturnStmt* stmt) override { rewrite(stmt->value); }
+    void visitVarStmt(VarStmt* stmt) override { rewrite(stmt->initializer); }
+    void visitWhileStmt(WhileStmt* stmt) override {
+        rewrite(stmt->condition);
+        rewrite(stmt->body);
+    }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        rewrite(stmt->start);
+        rewrite(stmt->end);
+        rewrite(stmt->body);
+    }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Mid-level SSA intermediate representation.
+// A Module holds one Function per FunctionStmt plus a synthetic ".toplevel"
+// function for the script's top-level statements. Globals live in memory
+// (GLOAD/GSTORE); every local and parameter is an SSA value. Array values
+// are references to heap buffers, read and written with ALOAD/ASTORE.
+// Strings are immutable references; a STRING constant holds its text in
+// `symbol`.
+
+enum class IRType { VOID, INT, FLOAT, BOOL, STRING, INT_ARRAY, FLOAT_ARRAY };
+
+inline bool isArrayIRType(IRType type) { return type == IRType::INT_ARRAY || type == IRType::FLOAT_ARRAY; }
+
+enum class Opcode {
+    CONST, PARAM, PHI,
+
+    // Integer and float arithmetic are kept apart so later passes never
+    // have to look at operand types.
+    IADD, ISUB, IMUL, IDIV, INEG,
+    FADD, FSUB, FMUL, FDIV, FNEG,
+
+    // Comparisons produce BOOL. Bools compare as 0/1 with the ICMP forms.
+    ICMP_EQ, ICMP_NE, ICMP_LT, ICMP_LE, ICMP_GT, ICMP_GE,
+    FCMP_EQ, FCMP_NE, FCMP_LT, FCMP_LE, FCMP_GT, FCMP_GE,
+
+    NOT, ITOF,
+
+    // Memory and side effects
+    GLOAD, GSTORE, CALL, PRINT,
+
+    // Arrays. NEWARRAY takes a length; INTRINSIC is a bulk operation named
+    // by `symbol` (add, sub, mul, div, sum, dot, min, max), or a string
+    // operation (concat, streq, strne, strlen, str).
+    NEWARRAY, ALOAD, ASTORE, ALEN, INTRINSIC,
+
+    // Terminators
+    BR, CONDBR, RET
+};
+
+class BasicBlock;
+
+class Instruction {
+public:
+    int id;                             // SSA value number, unique within a function
+    Opcode op;
+    IRType type;
+    std::vector<Instruction*> operands;
+    std::vector<BasicBlock*> blocks;    // BR/CONDBR targets, or PHI incoming blocks (parallel to operands)
+    std::vector<long long> weights;     // CONDBR: profiled counts per target, when a profile was used
+    std::string symbol;                 // Global for GLOAD/GSTORE, callee for CALL/INTRINSIC, name for PARAM, text for STRING CONST
+    int intValue = 0;                   // CONST payload (INT and BOOL)
+    double floatValue = 0.0;            // CONST payload (FLOAT)
+    BasicBlock* parent = nullptr;       // nullptr for PARAM/CONST, which dominate the whole function
+
+    Instruction(int id, Opcode op, IRType type) : id(id), op(op), type(type) {}
+
+    bool isTerminator() const { return op == Opcode::BR || op == Opcode::CONDBR || op == Opcode::RET; }
+
+    // True for instructions whose only effect is producing their value.
+    // Array allocations are not: two equal NEWARRAYs are different arrays.
+    bool isPure() const {
+        switch (op) {
+            case Opcode::GLOAD: case Opcode::GSTORE: case Opcode::CALL:
+            case Opcode::PRINT: case Opcode::BR: case Opcode::CONDBR:
+            case Opcode::RET: case Opcode::PHI: case Opcode::PARAM:
+            case Opcode::NEWARRAY: case Opcode::ALOAD: case Opcode::ASTORE:
+            case Opcode::INTRINSIC:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    // Pure instructions that may still fault at runtime must not be speculated.
+    bool mayTrap() const {
+        if (op != Opcode::IDIV) return false;
+        Instruction* divisor = operands[1];
+        return divisor->op != Opcode::CONST || divisor->intValue == 0 || divisor->intValue == -1;
+    }
+};
+
+class BasicBlock {
+public:
+    int id;
+    std::string label;
+    std::vector<std::unique_ptr<Instruction>> instructions;
+    std::vector<BasicBlock*> preds;
+    std::vector<BasicBlock*> succs;
+
+    BasicBlock(int id, std::string label) : id(id), label(label) {}
+
+    Instruction* terminator() const {
+        if (instructions.empty() || !instructions.back()->isTerminator()) return nullptr;
+        return instructions.back().get();
+    }
+};
+
+class Function {
+public:
+    std::string name;
+    IRType returnType;
+    std::vector<std::unique_ptr<Instruction>> params;
+    std::vector<std::unique_ptr<Instruction>> constants;
+    std::vector<std::unique_ptr<BasicBlock>> blocks; // blocks[0] is the entry block
+    int nextValueId = 0;
+    int nextBlockId = 0;
+
+    Function(std::string name, IRType returnType) : name(name), returnType(returnType) {}
+
+    BasicBlock* entry() const { return blocks.empty() ? nullptr : blocks.front().get(); }
+
+    // Constants are uniqued per function so identical literals share one value.
+    Instruction* constant(IRType type, int intValue, double floatValue = 0.0) {
+        long long bits = intValue;
+        if (type == IRType::FLOAT) std::memcpy(&bits, &floatValue, sizeof(bits));
+        auto key = std::make_pair((int)type, bits);
+        auto found = constantCache.find(key);
+        if (found != constantCache.end()) return found->second;
+
+        constants.push_back(std::make_unique<Instruction>(nextValueId++, Opcode::CONST, type));
+        Instruction* c = constants.back().get();
+        c->intValue = intValue;
+        c->floatValue = floatValue;
+        constantCache[key] = c;
+        return c;
+    }
+
+    Instruction* constant(const std::string& text) {
+        auto found = stringCache.find(text);
+        if (found != stringCache.end()) return found->second;
+
+        constants.push_back(std::make_unique<Instruction>(nextValueId++, Opcode::CONST, IRType::STRING));
+        Instruction* c = constants.back().get();
+        c->symbol = text;
+        stringCache[text] = c;
+        return c;
+    }
+
+    Instruction* zero(IRType type) { return type == IRType::STRING ? constant(std::string()) : constant(type, 0, 0.0); }
+
+    // Rewrites every operand through `replacements`, following chains.
+    void replaceAllUses(const std::unordered_map<Instruction*, Instruction*>& replacements) {
+        if (replacements.empty()) return;
+        for (auto& block : blocks) {
+            for (auto& inst : block->instructions) {
+                for (auto& operand : inst->operands) {
+                    auto found = replacements.find(operand);
+                    while (found != replacements.end()) {
+                        operand = found->second;
+                        found = replacements.find(operand);
+                    }
+                }
+            }
+        }
+    }
+
+    // Drops the given instructions from whichever blocks hold them.
+    void erase(const std::unordered_set<Instruction*>& dead) {
+        if (dead.empty()) return;
+        for (auto& block : blocks) {
+            auto& list = block->instructions;
+            list.erase(std::remove_if(list.begin(), list.end(),
+                           [&](const std::unique_ptr<Instruction>& inst) { return dead.count(inst.get()) > 0; }),
+                       list.end());
+        }
+    }
+
+    void dropUnusedConstants(const std::unordered_set<Instruction*>& used) {
+        constants.erase(std::remove_if(constants.begin(), constants.end(),
+                            [&](const std::unique_ptr<Instruction>& c) { return used.count(c.get()) == 0; }),
+                        constants.end());
+        for (auto it = constantCache.begin(); it != constantCache.end();) {
+            if (used.count(it->second) == 0) it = constantCache.erase(it);
+            else ++it;
+        }
+        for (auto it = stringCache.begin(); it != stringCache.end();) {
+            if (used.count(it->second) == 0) it = stringCache.erase(it);
+            else ++it;
+        }
+    }
+
+private:
+    std::map<std::pair<int, long long>, Instruction*> constantCache;
+    std::map<std::string, Instruction*> stringCache;
+};
+
+struct GlobalVar {
+    std::string name;
+    IRType type;
+};
+
+class Module {
+public:
+    std::vector<GlobalVar> globals;
+    std::vector<std::unique_ptr<Function>> functions;
+};
+
+inline const char* irTypeName(IRType type) {
+    switch (type) {
+        case IRType::VOID: return "void";
+        case IRType::INT: return "int";
+        case IRType::FLOAT: return "float";
+        case IRType::BOOL: return "bool";
+        case IRType::STRING: return "string";
+        case IRType::INT_ARRAY: return "int[]";
+        case IRType::FLOAT_ARRAY: return "float[]";
+    }
+    return "?";
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include "token-type.h"
+
+class ArrayHeap;
+
+inline bool isArrayType(TokenType type) {
+    return type == TokenType::TYPE_INT_ARRAY || type == TokenType::TYPE_FLOAT_ARRAY;
+}
+
+// int[] -> int, float[] -> float
+inline TokenType elementTypeOf(TokenType arrayType) {
+    return arrayType == TokenType::TYPE_FLOAT_ARRAY ? TokenType::TYPE_FLOAT : TokenType::TYPE_INT;
+}
+
+// int -> int[], float -> float[]
+inline TokenType arrayTypeOf(TokenType elementType) {
+    return elementType == TokenType::TYPE_FLOAT ? TokenType::TYPE_FLOAT_ARRAY : TokenType::TYPE_INT_ARRAY;
+}
+
+// Storage of an int[] (32-bit ints) or float[] (doubles). The elements are
+// contiguous and zero-filled, and the buffer starts on a 32-byte boundary
+// and is padded to a multiple of 32 bytes, so vector kernels can use aligned
+// loads of whole AVX registers.
+class ArrayBuffer {
+public:
+    static const size_t kAlignment = 32;
+
+    const TokenType elementType; // TYPE_INT or TYPE_FLOAT
+    const size_t length;
+    bool marked = false; // Reachability flag for ArrayHeap
+    const ArrayHeap* owner = nullptr;
+
+private:
+    void* storage;
+
+    static size_t paddedBytes(TokenType elementType, size_t length) {
+        size_t bytes = length * (elementType == TokenType::TYPE_FLOAT ? sizeof(double) : sizeof(int));
+        return bytes == 0 ? kAlignment : (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+public:
+    ArrayBuffer(TokenType elementType, size_t length)
+        : elementType(elementType), length(length),
+          storage(::operator new(paddedBytes(elementType, length), std::align_val_t(kAlignment))) {
+        std::memset(storage, 0, paddedBytes(elementType, length));
+    }
+    ~ArrayBuffer() { ::operator delete(storage, std::align_val_t(kAlignment)); }
+
+    ArrayBuffer(const ArrayBuffer&) = delete;
+    ArrayBuffer& operator=(const ArrayBuffer&) = delete;
+
+    int* ints() { return static_cast<int*>(storage); }
+    const int* ints() const { return static_cast<const int*>(storage); }
+    double* floats() { return static_cast<double*>(storage); }
+    const double* floats() const { return static_cast<const double*>(storage); }
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AST.h"
+
+// Branch and call counts recorded by `--profile-gen` and read back by
+// `--profile-use`.
+//
+// Entries are keyed by source position (line and column of the `if` or
+// `while` keyword, or of a call's '('), so a profile stays valid as long as
+// the script is unchanged, and inlined or unrolled copies of a statement
+// share the entry of the original.
+//
+// The file is plain text, one entry per line, sorted by position:
+//
+//     nanoc-profile 1 <source hash>
+//     if <line> <column> <then count> <else count>
+//     while <line> <column> <iterations> <exits>
+//     call <line> <column> <count>
+class ExecutionProfile {
+public:
+    struct BranchCounts {
+        long long taken = 0;    // Then branch / loop iterations
+        long long notTaken = 0; // Else branch (or fall-through) / loop exits
+    };
+
+    uint64_t sourceHash = 0;
+    std::unordered_map<long long, BranchCounts> ifs;
+    std::unordered_map<long long, BranchCounts> loops;
+    std::unordered_map<long long, long long> calls;
+
+    static long long key(int line, int column) { return ((long long)line << 32) | (uint32_t)column; }
+
+    // FNV-1a, to notice profiles recorded for another version of a script
+    static uint64_t hashSource(const std::string& source) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (unsigned char c : source) {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    const BranchCounts* find(const IfStmt* stmt) const {
+        auto found = ifs.find(key(stmt->line, stmt->column));
+        return found == ifs.end() ? nullptr : &found->second;
+    }
+
+    const BranchCounts* find(const WhileStmt* stmt) const {
+        auto found = loops.find(key(stmt->line, stmt->column));
+        return found == loops.end() ? nullptr : &found->second;
+    }
+
+    long long callCount(const CallExpr* expr) const {
+        auto found = calls.find(key(expr->paren.line, expr->paren.column));
+        return found == calls.end() ? 0 : found->second;
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+        out << "nanoc-profile 1 " << std::hex << sourceHash << std::dec << "\n";
+        auto writeBranches = [&](const char* kind, const std::unordered_map<long long, BranchCounts>& entries) {
+            std::vector<long long> keys;
+            for (const auto& entry : entries) keys.push_back(entry.first);
+            std::sort(keys.begin(), keys.end());
+            for (long long k : keys) {
+                const BranchCounts& c = entries.at(k);
+                out << kind << " " << (k >> 32) << " " << (uint32_t)k << " " << c.taken << " " << c.notTaken << "\n";
+            }
+        };
+        writeBranches("if", ifs);
+        writeBranches("while", loops);
+        std::vector<long long> keys;
+        for (const auto& entry : calls) keys.push_back(entry.first);
+        std::sort(keys.begin(), keys.end());
+        for (long long k : keys) out << "call " << (k >> 32) << " " << (uint32_t)k << " " << calls.at(k) << "\n";
+        return (bool)out;
+    }
+
+    // Returns false with a message in `error` if the file is missing or malformed
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            error = "Could not open profile: " + path;
+            return false;
+        }
+        std::string magic;
+        int version = 0;
+        if (!(in >> magic >> version >> std::hex >> sourceHash >> std::dec) || magic != "nanoc-profile" || version != 1) {
+            error = path + " is not a nanoc profile.";
+            return false;
+        }
+        std::string line;
+        std::getline(in, line);
+        int lineNumber = 1;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            if (line.empty()) continue;
+            std::istringstream fields(line);
+            std::string kind;
+            long long sourceLine = 0, column = 0, first = 0, second = 0;
+            bool ok = (bool)(fields >> kind >> sourceLine >> column >> first);
+            if (ok && kind != "call") ok = (bool)(fields >> second);
+            if (!ok || (kind != "if" && kind != "while" && kind != "call")) {
+                error = path + ":" + std::to_string(lineNumber) + ": malformed entry.";
+                return false;
+            }
+            long long k = key((int)sourceLine, (int)column);
+            if (kind == "if") ifs[k] = {first, second};
+            else if (kind == "while") loops[k] = {first, second};
+            else calls[k] = first;
+        }
+        return true;
+    }
+};
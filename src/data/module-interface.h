@@ -0,0 +1,196 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "execution-profile.h"
+#include "token-type.h"
+
+// What a module shows the modules that import it: the types of its
+// top-level globals and the signatures of its top-level functions, plus
+// what the race checker needs to know about each function (see
+// RaceChecker::summarize()).
+struct ModuleInterface {
+    struct Global {
+        std::string name;
+        TokenType type;
+        int line = 0;
+        int column = 0;
+    };
+
+    struct Function {
+        std::string name;
+        TokenType returnType;
+        std::vector<TokenType> paramTypes;
+        int line = 0;
+        int column = 0;
+        std::string raceProblem; // Why it cannot run inside a parallel for, or empty
+        std::set<std::string> globalsRead;
+    };
+
+    std::vector<Global> globals;
+    std::vector<Function> functions;
+
+    static const char* typeName(TokenType type) {
+        switch (type) {
+            case TokenType::TYPE_INT: return "int";
+            case TokenType::TYPE_FLOAT: return "float";
+            case TokenType::TYPE_BOOL: return "bool";
+            case TokenType::TYPE_STRING: return "string";
+            case TokenType::TYPE_INT_ARRAY: return "int[]";
+            case TokenType::TYPE_FLOAT_ARRAY: return "float[]";
+            default: return "?";
+        }
+    }
+
+    static bool typeNamed(const std::string& name, TokenType& type) {
+        for (TokenType t : {TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL, TokenType::TYPE_STRING,
+                            TokenType::TYPE_INT_ARRAY, TokenType::TYPE_FLOAT_ARRAY}) {
+            if (name == typeName(t)) {
+                type = t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Changes only when something a dependent could observe changes:
+    // positions are left out, so moving a declaration is not a change
+    uint64_t hash() const {
+        std::string text;
+        for (const Global& global : globals) text += std::string("g ") + typeName(global.type) + " " + global.name + "\n";
+        for (const Function& fn : functions) {
+            text += std::string("f ") + typeName(fn.returnType) + " " + fn.name;
+            for (TokenType type : fn.paramTypes) text += std::string(" ") + typeName(type);
+            text += "\n! " + fn.raceProblem + "\nr";
+            for (const auto& name : fn.globalsRead) text += " " + name;
+            text += "\n";
+        }
+        return ExecutionProfile::hashSource(text);
+    }
+};
+
+// A module's entry in the `--module-cache` directory, written after it
+// analyzes cleanly. A later check-only build that finds the same source
+// and the same interfaces behind its imports skips the module. A module
+// whose body changed is analyzed again, but its dependents are skipped as
+// long as its interface hash did not change.
+//
+// The file is plain text, named after a hash of the module's path:
+//
+//     nanoc-interface 1 <source hash>
+//     path <module path>
+//     import <interface hash> <line> <column> <path as written>
+//     global <line> <column> <type> <name>
+//     func <line> <column> <return type> <name> <param types...>
+//     reads <function> <globals...>
+//     problem <function> <reason>
+struct ModuleCacheEntry {
+    struct Import {
+        uint64_t interfaceHash = 0; // Of the imported module, when this one was analyzed
+        int line = 0;
+        int column = 0;
+        std::string path; // As written in the `import`
+    };
+
+    std::string path;
+    uint64_t sourceHash = 0;
+    std::vector<Import> imports; // In source order
+    ModuleInterface interface;
+
+    static std::string fileFor(const std::string& directory, const std::string& modulePath) {
+        std::ostringstream name;
+        name << std::hex << ExecutionProfile::hashSource(modulePath) << ".nsi";
+        return directory + "/" + name.str();
+    }
+
+    bool save(const std::string& file) const {
+        std::ofstream out(file);
+        if (!out.is_open()) return false;
+        out << "nanoc-interface 1 " << std::hex << sourceHash << std::dec << "\n";
+        out << "path " << path << "\n";
+        for (const auto& import : imports) {
+            out << "import " << std::hex << import.interfaceHash << std::dec << " " << import.line << " " << import.column << " "
+                << import.path << "\n";
+        }
+        for (const auto& global : interface.globals) {
+            out << "global " << global.line << " " << global.column << " " << ModuleInterface::typeName(global.type) << " "
+                << global.name << "\n";
+        }
+        for (const auto& fn : interface.functions) {
+            out << "func " << fn.line << " " << fn.column << " " << ModuleInterface::typeName(fn.returnType) << " " << fn.name;
+            for (TokenType type : fn.paramTypes) out << " " << ModuleInterface::typeName(type);
+            out << "\n";
+            if (!fn.globalsRead.empty()) {
+                out << "reads " << fn.name;
+                for (const auto& name : fn.globalsRead) out << " " << name;
+                out << "\n";
+            }
+            if (!fn.raceProblem.empty()) out << "problem " << fn.name << " " << fn.raceProblem << "\n";
+        }
+        return (bool)out;
+    }
+
+    // False if the file is missing or malformed; a bad entry is simply
+    // not used, so there is no message
+    bool load(const std::string& file) {
+        std::ifstream in(file);
+        if (!in.is_open()) return false;
+        std::string magic;
+        int version = 0;
+        if (!(in >> magic >> version >> std::hex >> sourceHash >> std::dec) || magic != "nanoc-interface" || version != 1) {
+            return false;
+        }
+        std::string line;
+        std::getline(in, line);
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            std::istringstream fields(line);
+            std::string kind;
+            fields >> kind;
+            if (kind == "path") {
+                fields >> std::ws;
+                std::getline(fields, path);
+            } else if (kind == "import") {
+                Import import;
+                if (!(fields >> std::hex >> import.interfaceHash >> std::dec >> import.line >> import.column >> std::ws)) {
+                    return false;
+                }
+                std::getline(fields, import.path);
+                imports.push_back(import);
+            } else if (kind == "global") {
+                ModuleInterface::Global global;
+                std::string type;
+                if (!(fields >> global.line >> global.column >> type >> global.name)) return false;
+                if (!ModuleInterface::typeNamed(type, global.type)) return false;
+                interface.globals.push_back(global);
+            } else if (kind == "func") {
+                ModuleInterface::Function fn;
+                std::string type;
+                if (!(fields >> fn.line >> fn.column >> type >> fn.name)) return false;
+                if (!ModuleInterface::typeNamed(type, fn.returnType)) return false;
+                while (fields >> type) {
+                    TokenType param;
+                    if (!ModuleInterface::typeNamed(type, param)) return false;
+                    fn.paramTypes.push_back(param);
+                }
+                interface.functions.push_back(fn);
+            } else if (kind == "reads" || kind == "problem") {
+                std::string name;
+                if (!(fields >> name) || interface.functions.empty() || interface.functions.back().name != name) return false;
+                ModuleInterface::Function& fn = interface.functions.back();
+                if (kind == "reads") {
+                    while (fields >> name) fn.globalsRead.insert(name);
+                } else {
+                    fields >> std::ws;
+                    std::getline(fields, fn.raceProblem);
+                }
+            } else {
+                return false;
+            }
+        }
+        return !path.empty();
+    }
+};
@@ -0,0 +1,252 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "value.h"
+
+// The globals of a program after its top-level code ran, saved by
+// `--snapshot` so that later runs can start at `main()` without running
+// that code again.
+//
+// The file is binary, in native byte order (it is only read on the machine
+// that wrote it), and is mapped rather than read:
+//
+//     "nanosnap" <version> <source hash> <array count> <global count>
+//     array:  <element tag> <length> <elements: 4-byte ints or 8-byte doubles>
+//     global: <type tag> <name length> <name> <value>
+//
+// A global array's value is its index in the array list, so globals that
+// shared one array before the snapshot still share one after a restore.
+// Strings are stored flattened.
+class Snapshot {
+public:
+    static const uint32_t kVersion = 1;
+
+    struct Array {
+        TokenType elementType;
+        size_t length;
+        const void* elements; // Into the mapping; unaligned
+    };
+
+    struct Global {
+        std::string_view name;
+        TokenType type;
+        Value scalar;          // Ints, floats and bools
+        std::string_view text; // Strings
+        size_t array = 0;      // Arrays: index in arrays()
+    };
+
+    Snapshot() = default;
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    ~Snapshot() {
+        if (mapping) munmap(mapping, mappedSize);
+    }
+
+    const std::vector<Array>& arrays() const { return arrayList; }
+    const std::vector<Global>& globals() const { return globalList; }
+
+    // Writes to a temporary file next to `path` and renames it, so a run
+    // that maps the snapshot never sees half of one
+    static bool save(const std::string& path, uint64_t sourceHash, const std::vector<std::pair<std::string, Value>>& globals) {
+        std::unordered_map<const ArrayBuffer*, uint64_t> arrayIndex;
+        std::vector<const ArrayBuffer*> arrays;
+        for (const auto& global : globals) {
+            const ArrayBuffer* array = global.second.array;
+            if (array && arrayIndex.emplace(array, arrays.size()).second) arrays.push_back(array);
+        }
+
+        std::string temp = path + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(temp, std::ios::binary);
+            if (!out.is_open()) return false;
+            auto put = [&](auto value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+            out.write("nanosnap", 8);
+            put(kVersion);
+            put(sourceHash);
+            put((uint64_t)arrays.size());
+            put((uint64_t)globals.size());
+            for (const ArrayBuffer* array : arrays) {
+                put(tagOf(array->elementType));
+                put((uint64_t)array->length);
+                if (array->elementType == TokenType::TYPE_FLOAT) {
+                    out.write(reinterpret_cast<const char*>(array->floats()), array->length * sizeof(double));
+                } else {
+                    out.write(reinterpret_cast<const char*>(array->ints()), array->length * sizeof(int));
+                }
+            }
+            for (const auto& global : globals) {
+                const Value& value = global.second;
+                put(tagOf(value.type));
+                put((uint32_t)global.first.size());
+                out.write(global.first.data(), global.first.size());
+                switch (value.type) {
+                    case TokenType::TYPE_INT: put((int32_t)value.i); break;
+                    case TokenType::TYPE_FLOAT: put(value.f); break;
+                    case TokenType::TYPE_BOOL: put((uint8_t)value.b); break;
+                    case TokenType::TYPE_STRING: {
+                        std::string text = value.str->flatten();
+                        put((uint64_t)text.size());
+                        out.write(text.data(), text.size());
+                        break;
+                    }
+                    default: put(arrayIndex.at(value.array)); break;
+                }
+            }
+            if (!out) {
+                out.close();
+                std::remove(temp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // False if the file is missing, damaged, or was written for another
+    // version of the script; the caller then runs the top-level code again
+    bool load(const std::string& path, uint64_t sourceHash) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+        mapping = data;
+        mappedSize = (size_t)info.st_size;
+        if (parse(sourceHash)) return true;
+        arrayList.clear();
+        globalList.clear();
+        return false;
+    }
+
+private:
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+    size_t offset = 0; // Read position while parsing
+    std::vector<Array> arrayList;
+    std::vector<Global> globalList;
+
+    // Stable numbers for the types, independent of TokenType's order
+    static uint32_t tagOf(TokenType type) {
+        switch (type) {
+            case TokenType::TYPE_INT: return 1;
+            case TokenType::TYPE_FLOAT: return 2;
+            case TokenType::TYPE_BOOL: return 3;
+            case TokenType::TYPE_STRING: return 4;
+            case TokenType::TYPE_INT_ARRAY: return 5;
+            case TokenType::TYPE_FLOAT_ARRAY: return 6;
+            default: return 0;
+        }
+    }
+
+    static bool typeOf(uint32_t tag, TokenType& type) {
+        static const TokenType types[] = {TokenType::TYPE_INT, TokenType::TYPE_FLOAT, TokenType::TYPE_BOOL,
+                                          TokenType::TYPE_STRING, TokenType::TYPE_INT_ARRAY, TokenType::TYPE_FLOAT_ARRAY};
+        if (tag < 1 || tag > 6) return false;
+        type = types[tag - 1];
+        return true;
+    }
+
+    const char* bytes(size_t count) {
+        if (count > mappedSize - offset) return nullptr;
+        const char* start = static_cast<const char*>(mapping) + offset;
+        offset += count;
+        return start;
+    }
+
+    template <typename T>
+    bool get(T& value) {
+        const char* start = bytes(sizeof(T));
+        if (!start) return false;
+        std::memcpy(&value, start, sizeof(T));
+        return true;
+    }
+
+    bool parse(uint64_t sourceHash) {
+        const char* magic = bytes(8);
+        uint32_t version = 0;
+        uint64_t hash = 0, arrayCount = 0, globalCount = 0;
+        if (!magic || std::memcmp(magic, "nanosnap", 8) != 0 || !get(version) || version != kVersion || !get(hash) ||
+            hash != sourceHash || !get(arrayCount) || !get(globalCount)) {
+            return false;
+        }
+
+        for (uint64_t k = 0; k < arrayCount; k++) {
+            uint32_t tag = 0;
+            uint64_t length = 0;
+            Array array;
+            if (!get(tag) || !typeOf(tag, array.elementType) || !get(length)) return false;
+            if (array.elementType != TokenType::TYPE_INT && array.elementType != TokenType::TYPE_FLOAT) return false;
+            size_t width = array.elementType == TokenType::TYPE_FLOAT ? sizeof(double) : sizeof(int);
+            if (length > mappedSize / width) return false;
+            array.length = (size_t)length;
+            array.elements = bytes(array.length * width);
+            if (!array.elements) return false;
+            arrayList.push_back(array);
+        }
+
+        for (uint64_t k = 0; k < globalCount; k++) {
+            uint32_t tag = 0, nameLength = 0;
+            Global global;
+            if (!get(tag) || !typeOf(tag, global.type) || !get(nameLength)) return false;
+            const char* name = bytes(nameLength);
+            if (!name) return false;
+            global.name = std::string_view(name, nameLength);
+            switch (global.type) {
+                case TokenType::TYPE_INT: {
+                    int32_t i = 0;
+                    if (!get(i)) return false;
+                    global.scalar = Value::ofInt(i);
+                    break;
+                }
+                case TokenType::TYPE_FLOAT: {
+                    double f = 0.0;
+                    if (!get(f)) return false;
+                    global.scalar = Value::ofFloat(f);
+                    break;
+                }
+                case TokenType::TYPE_BOOL: {
+                    uint8_t b = 0;
+                    if (!get(b)) return false;
+                    global.scalar = Value::ofBool(b != 0);
+                    break;
+                }
+                case TokenType::TYPE_STRING: {
+                    uint64_t length = 0;
+                    if (!get(length) || length > mappedSize) return false;
+                    const char* text = bytes((size_t)length);
+                    if (!text) return false;
+                    global.text = std::string_view(text, (size_t)length);
+                    break;
+                }
+                default: {
+                    uint64_t index = 0;
+                    if (!get(index) || index >= arrayList.size()) return false;
+                    if (arrayTypeOf(arrayList[index].elementType) != global.type) return false;
+                    global.array = (size_t)index;
+                    break;
+                }
+            }
+            globalList.push_back(global);
+        }
+        return offset == mappedSize;
+    }
+};
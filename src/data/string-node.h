@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class StringHeap;
+
+// An immutable string: either a leaf holding its text, or the
+// concatenation of two other strings (a rope node). Concatenating never
+// copies the halves, so building a long string piece by piece in a loop
+// takes linear time; the text is only assembled when something needs it
+// in one piece. Ropes may be very deep, so every walk is iterative.
+//
+// Nodes are never modified after construction, which lets the threads of
+// a parallel for read the same strings without locks.
+class StringNode {
+public:
+    const size_t length;
+    const StringNode* const left = nullptr; // Both set for concatenations, null for leaves
+    const StringNode* const right = nullptr;
+    const std::string text;                 // Leaves only
+    const bool interned;                    // Lives in StringPool; equal text means the same node
+
+    mutable bool marked = false;       // Reachability flag for StringHeap
+    const StringHeap* owner = nullptr; // Null for interned strings
+
+    explicit StringNode(std::string text, bool interned = false)
+        : length(text.size()), text(std::move(text)), interned(interned) {}
+    StringNode(const StringNode* left, const StringNode* right)
+        : length(left->length + right->length), left(left), right(right), interned(false) {}
+
+    StringNode(const StringNode&) = delete;
+    StringNode& operator=(const StringNode&) = delete;
+
+    bool isLeaf() const { return left == nullptr; }
+
+    // Calls piece(text) for each leaf, left to right
+    template <typename Piece>
+    void forEachPiece(Piece piece) const {
+        std::vector<const StringNode*> pending{this};
+        while (!pending.empty()) {
+            const StringNode* node = pending.back();
+            pending.pop_back();
+            if (node->isLeaf()) {
+                piece(node->text);
+            } else {
+                pending.push_back(node->right);
+                pending.push_back(node->left);
+            }
+        }
+    }
+
+    std::string flatten() const {
+        if (isLeaf()) return text;
+        std::string result;
+        result.reserve(length);
+        forEachPiece([&](const std::string& piece) { result += piece; });
+        return result;
+    }
+
+    static bool equal(const StringNode* a, const StringNode* b) {
+        if (a == b) return true;
+        if (a->length != b->length || (a->interned && b->interned)) return false;
+        if (a->isLeaf() && b->isLeaf()) return a->text == b->text;
+        return a->flatten() == b->flatten();
+    }
+};
+
+// The string literals of the program, one node per distinct text. Every
+// LiteralExpr interns its text when it is built, so evaluating a literal
+// allocates nothing and two literals with the same text compare equal by
+// pointer. The pool only grows and is shared by all threads.
+class StringPool {
+public:
+    static const StringNode* intern(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& entries = pool();
+        auto found = entries.find(text);
+        if (found != entries.end()) return found->second.get();
+        auto node = std::make_unique<StringNode>(text, true);
+        const StringNode* result = node.get();
+        entries.emplace(text, std::move(node));
+        return result;
+    }
+
+    static const StringNode* empty() {
+        static const StringNode* node = intern("");
+        return node;
+    }
+
+private:
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+    static std::unordered_map<std::string, std::unique_ptr<StringNode>>& pool() {
+        static auto* entries = new std::unordered_map<std::string, std::unique_ptr<StringNode>>(); // Never destroyed
+        return *entries;
+    }
+};
@@ -2,7 +2,7 @@
 
 enum class TokenType {
     // Single-character tokens
-    LPAREN, RPAREN, LBRACE, RBRACE, COMMA, DOT, MINUS, PLUS, SEMICOLON, SLASH, STAR,
+    LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET, COMMA, DOT, MINUS, PLUS, SEMICOLON, SLASH, STAR,
 
     // One or two character tokens
     BANG, BANG_EQUAL,
@@ -15,8 +15,9 @@ enum class TokenType {
 
     // Keywords
     AND, ELSE, FALSE_KEYWORD, FUNC, IF, OR, PRINT, RETURN, TRUE_KEYWORD, VAR, WHILE,
-    TYPE_INT, TYPE_FLOAT, TYPE_BOOL, // for 'int', 'float', 'bool'
+    TYPE_INT, TYPE_FLOAT, TYPE_BOOL, TYPE_STRING, // for 'int', 'float', 'bool', 'string'
+    TYPE_INT_ARRAY, TYPE_FLOAT_ARRAY, // 'int[]' and 'float[]'; built by the parser, never scanned
 
-    FOR, CLASS,
+    FOR, PARALLEL, IMPORT, CLASS,
     END_OF_FILE
 };
\ No newline at end of file
@@ -10,9 +10,10 @@ public:
     std::string lexeme;
     std::string literal; // Storing values as strings for simplicity
     int line;
+    int column; // 1-based; 0 for tokens the compiler synthesizes
 
-    Token(TokenType type, std::string lexeme, std::string literal, int line)
-        : type(type), lexeme(lexeme), literal(literal), line(line) {}
+    Token(TokenType type, std::string lexeme, std::string literal, int line, int column = 0)
+        : type(type), lexeme(lexeme), literal(literal), line(line), column(column) {}
 
     std::string toString() const {
         return std::to_string((int)type) + " " + lexeme + " " + literal;
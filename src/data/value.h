@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include "array-buffer.h"
+#include "string-node.h"
+#include "token-type.h"
+
+// A runtime value. The type tag uses the same TokenTypes the semantic
+// analyzer uses for static types; END_OF_FILE marks "no value yet".
+// Arrays and strings are held by reference: copying a Value shares the
+// buffer or string, which belongs to the heap of the interpreter that
+// allocated it (or, for literals, to the StringPool).
+class Value {
+public:
+    TokenType type = TokenType::END_OF_FILE;
+    int i = 0;
+    double f = 0.0;
+    bool b = false;
+    ArrayBuffer* array = nullptr;
+    const StringNode* str = nullptr;
+
+    static Value ofInt(int v) {
+        Value value;
+        value.type = TokenType::TYPE_INT;
+        value.i = v;
+        return value;
+    }
+
+    static Value ofFloat(double v) {
+        Value value;
+        value.type = TokenType::TYPE_FLOAT;
+        value.f = v;
+        return value;
+    }
+
+    static Value ofBool(bool v) {
+        Value value;
+        value.type = TokenType::TYPE_BOOL;
+        value.b = v;
+        return value;
+    }
+
+    static Value ofArray(ArrayBuffer* buffer) {
+        Value value;
+        value.type = arrayTypeOf(buffer->elementType);
+        value.array = buffer;
+        return value;
+    }
+
+    static Value ofString(const StringNode* node) {
+        Value value;
+        value.type = TokenType::TYPE_STRING;
+        value.str = node;
+        return value;
+    }
+
+    // Scalars and strings; the interpreter allocates the empty array of an array type
+    static Value zero(TokenType type) {
+        switch (type) {
+            case TokenType::TYPE_FLOAT: return ofFloat(0.0);
+            case TokenType::TYPE_BOOL: return ofBool(false);
+            case TokenType::TYPE_STRING: return ofString(StringPool::empty());
+            default: return ofInt(0);
+        }
+    }
+
+    // Integer arithmetic wraps at 32 bits
+    static int wrap(long long v) { return (int)(uint32_t)(uint64_t)v; }
+
+    bool isDefined() const { return type != TokenType::END_OF_FILE; }
+    double asFloat() const { return type == TokenType::TYPE_FLOAT ? f : (double)i; }
+
+    // Applies the implicit int -> float conversion when `target` asks for it
+    Value convertTo(TokenType target) const {
+        if (target == TokenType::TYPE_FLOAT && type == TokenType::TYPE_INT) return ofFloat((double)i);
+        return *this;
+    }
+
+    bool operator==(const Value& other) const {
+        if (type != other.type) return false;
+        switch (type) {
+            case TokenType::TYPE_INT: return i == other.i;
+            case TokenType::TYPE_FLOAT: return f == other.f;
+            case TokenType::TYPE_BOOL: return b == other.b;
+            case TokenType::TYPE_STRING: return StringNode::equal(str, other.str);
+            case TokenType::TYPE_INT_ARRAY:
+            case TokenType::TYPE_FLOAT_ARRAY: return array == other.array;
+            default: return true;
+        }
+    }
+
+    // Text used by print
+    std::string toString() const {
+        switch (type) {
+            case TokenType::TYPE_INT: return std::to_string(i);
+            case TokenType::TYPE_BOOL: return b ? "true" : "false";
+            case TokenType::TYPE_STRING: return str->flatten();
+            case TokenType::TYPE_FLOAT: {
+                std::ostringstream out;
+                out << f;
+                return out.str();
+            }
+            case TokenType::TYPE_INT_ARRAY:
+            case TokenType::TYPE_FLOAT_ARRAY: {
+                std::ostringstream out;
+                out << "[";
+                for (size_t k = 0; k < array->length; k++) {
+                    if (k > 0) out << ", ";
+                    if (array->elementType == TokenType::TYPE_FLOAT) out << array->floats()[k];
+                    else out << array->ints()[k];
+                }
+                out << "]";
+                return out.str();
+            }
+            default: return "<undefined>";
+        }
+    }
+
+    // Text for a LiteralExpr that reproduces this value exactly (for
+    // strings, the text itself: LiteralExpr holds it unquoted)
+    std::string toLiteral() const {
+        if (type != TokenType::TYPE_FLOAT) return toString();
+        std::ostringstream out;
+        out << std::setprecision(17) << f;
+        std::string text = out.str();
+        if (text.find_first_of(".eni") == std::string::npos) text += ".0";
+        return text;
+    }
+};
@@ -7,28 +7,116 @@
 #include "compiler/parser.h"
 #include "util/error-handler.h"
 #include "compiler/semantic-analyzer.h"
+#include "compiler/tail-recursion.h"
+#include "compiler/inliner.h"
+#include "compiler/compile-time-evaluator.h"
+#include "compiler/induction-optimizer.h"
+#include "compiler/loop-unroller.h"
+#include "compiler/module-graph.h"
+#include "compiler/ast-printer.h"
+#include "compiler/purity-analyzer.h"
+#include "compiler/ir-builder.h"
+#include "compiler/ir-passes.h"
+#include "compiler/ir-printer.h"
+#include "runtime/interpreter.h"
+#include "runtime/vector-kernels.h"
+#include "runtime/work-stealing-pool.h"
+#include "util/options.h"
+#include "util/stats.h"
+#include "util/trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <optional>
+
+// Counting allocation hooks for --stats (see AllocationCounters)
+void* operator new(std::size_t size) {
+    AllocationCounters::recordAllocation(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept {
+    if (p) AllocationCounters::recordFree();
+    std::free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+// Over-aligned storage (ArrayBuffer) is counted too; aligned_alloc wants a
+// size that is a multiple of the alignment
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    AllocationCounters::recordAllocation(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t padded = size == 0 ? align : (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, padded)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { operator delete(p); }
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: nanoc <script>" << std::endl;
+    CompilerOptions options;
+    if (!options.parse(argc, argv)) {
+        CompilerOptions::printUsage();
+        return 1;
+    }
+
+    ErrorHandler::maxErrors = options.maxErrors;
+    ErrorHandler::format = options.diagnosticsJson ? ErrorHandler::Format::JSON : ErrorHandler::Format::TEXT;
+    if (!VectorKernels::select(options.simd)) {
+        std::cerr << "This CPU does not support --simd=" << options.simd << "." << std::endl;
         return 1;
     }
+    if (options.threads > 0) WorkStealingPool::configure((unsigned)options.threads);
+
+    // Writes the trace on every exit path, after all spans have closed
+    struct TraceSession {
+        std::string path;
+        ~TraceSession() {
+            if (!path.empty() && !Tracer::write(path)) std::cerr << "Could not write trace: " << path << std::endl;
+        }
+    } traceSession{options.tracePath};
+    if (!options.tracePath.empty()) Tracer::enable();
+
+    std::unique_ptr<CompilerStats> stats;
+    if (options.stats) stats = std::make_unique<CompilerStats>();
+    std::optional<TraceSpan> phaseSpan;
+    auto beginPhase = [&](const char* name) {
+        if (stats) stats->beginPhase(name);
+        phaseSpan.reset();
+        phaseSpan.emplace(name);
+    };
+    auto endPhase = [&]() {
+        if (stats) stats->endPhase();
+        phaseSpan.reset();
+    };
 
     // 1. Read File
-    std::ifstream file(argv[1]);
+    beginPhase("read");
+    std::ifstream file(options.scriptPath);
     if (!file.is_open()) {
-        std::cerr << "Could not open file: " << argv[1] << std::endl;
+        std::cerr << "Could not open file: " << options.scriptPath << std::endl;
         return 1;
     }
     std::stringstream buffer;
     buffer << file.rdbuf();
     std::string source = buffer.str();
+    endPhase();
 
-    std::cout << "--- Compiling " << argv[1] << " ---" << std::endl;
+    std::cout << "--- Compiling " << options.scriptPath << " ---" << std::endl;
 
     // 2. Scanning (Lexical Analysis)
     std::cout << "[Phase 1] Scanning..." << std::endl;
+    beginPhase("scan");
     Scanner scanner(source);
     std::vector<Token> tokens = scanner.scanTokens();
+    endPhase();
+    ErrorHandler::flush();
 
     if (ErrorHandler::hadError) return 65;
 
@@ -37,21 +125,226 @@ int main(int argc, char* argv[]) {
 
     // 3. Parsing (Syntax Analysis)
     std::cout << "[Phase 2] Parsing..." << std::endl;
-    Parser parser(tokens);
+    beginPhase("parse");
+    long long tokenCount = (long long)tokens.size();
+    Parser parser(std::move(tokens), options.lazyParsing());
     std::vector<std::unique_ptr<Statement>> ast = parser.parse();
+    endPhase();
+    ErrorHandler::flush();
 
     if (ErrorHandler::hadError) return 65;
+    if (stats) {
+        stats->tokens = tokenCount;
+        stats->countNodes(ast); // As parsed, before any -O rewrites
+    }
+    // --snapshot calls main() after the top-level code; under --lazy it
+    // counts as reached
+    FunctionStmt* entry = nullptr;
+    if (!options.snapshotPath.empty()) {
+        for (const auto& stmt : ast) {
+            FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get());
+            if (fn && fn->name.lexeme == "main") entry = fn;
+        }
+        if (!entry || entry->returnType.type != TokenType::TYPE_INT || !entry->params.empty()) {
+            std::cerr << "--snapshot needs an entry point 'func int main()'." << std::endl;
+            return 1;
+        }
+        if (entry->lazy) {
+            Parser::parseBody(entry);
+            ErrorHandler::flush();
+            if (ErrorHandler::hadError) return 65;
+        }
+    }
+    // --lazy: bodies the analyzer parses once a call reaches them
+    std::vector<FunctionStmt*> skipped;
+    for (const auto& stmt : ast) {
+        FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get());
+        if (fn && fn->lazy) skipped.push_back(fn);
+    }
+
+    // Imported modules are read and parsed before anything is analyzed. A
+    // build that only checks the program can skip unchanged modules.
+    std::unique_ptr<ModuleGraph> modules;
+    bool checkOnly = !options.run && !options.optimize && !options.wantsIR() && !options.dumpTypedAST;
+    if (!parser.importedPaths().empty()) {
+        if (!options.profileGenPath.empty() || !options.profileUsePath.empty()) {
+            std::cerr << "Execution profiles are not supported for scripts with imports." << std::endl;
+            return 1;
+        }
+        if (!options.snapshotPath.empty()) {
+            std::cerr << "Snapshots are not supported for scripts with imports." << std::endl;
+            return 1;
+        }
+        beginPhase("modules");
+        modules = std::make_unique<ModuleGraph>(options.moduleCache, checkOnly);
+        modules->addMain(options.scriptPath, source, parser.importedPaths(), std::move(ast));
+        bool loaded = modules->load();
+        endPhase();
+        ErrorHandler::flush();
+
+        if (!loaded || ErrorHandler::hadError) return 65;
+        if (stats) {
+            stats->tokens += modules->tokenCount();
+            for (const auto* program : modules->parsedPrograms()) stats->countNodes(*program);
+        }
+    }
 
     // 4. Semantic Analysis
     std::cout << "[Phase 3] Semantic Analysis..." << std::endl;
+    beginPhase("analyze");
     SemanticAnalyzer analyzer;
-    analyzer.analyze(ast);
+    if (modules) {
+        modules->analyze();
+    } else {
+        analyzer.analyze(ast);
+    }
+    endPhase();
+    ErrorHandler::flush();
 
     if (ErrorHandler::hadError) {
         std::cerr << "Compilation failed with semantic errors." << std::endl;
         return 70;
     }
+    if (modules) {
+        if (!options.moduleCache.empty()) {
+            size_t analyzed = modules->analyzedCount();
+            std::cout << "Modules: " << modules->moduleCount() << " (" << analyzed << " analyzed, "
+                      << modules->moduleCount() - analyzed << " unchanged)" << std::endl;
+        }
+        if (!checkOnly) ast = modules->link();
+    }
+    if (options.lazyParsing()) {
+        long long parsed = std::count_if(skipped.begin(), skipped.end(), [](FunctionStmt* fn) { return !fn->lazy; });
+        std::cout << "Function bodies: " << parsed << " of " << skipped.size() << " parsed" << std::endl;
+        // No checked code calls the others, so nothing can run them
+        ast.erase(std::remove_if(ast.begin(), ast.end(),
+                                 [](const std::unique_ptr<Statement>& stmt) {
+                                     FunctionStmt* fn = dynamic_cast<FunctionStmt*>(stmt.get());
+                                     return fn && fn->lazy;
+                                 }),
+                  ast.end());
+    }
+
+    // Recorded branch and call counts (--profile-use)
+    std::unique_ptr<ExecutionProfile> profile;
+    if (!options.profileUsePath.empty()) {
+        profile = std::make_unique<ExecutionProfile>();
+        std::string error;
+        if (!profile->load(options.profileUsePath, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        if (profile->sourceHash != ExecutionProfile::hashSource(source)) {
+            std::cerr << "Warning: " << options.profileUsePath
+                      << " was recorded for a different version of this script; unmatched positions are ignored." << std::endl;
+        }
+    }
+
+    // 5. Optional: AST-level optimizations. A --profile-gen run keeps the
+    // program as written so that every source position is observed.
+    if (options.optimize && options.profileGenPath.empty()) {
+        std::cout << "[Phase 4] Optimizing..." << std::endl;
+        beginPhase("optimize");
+        TailRecursionEliminator().run(ast);
+        Inliner inliner;
+        inliner.profile = profile.get();
+        inliner.run(ast);
+        CompileTimeEvaluator().run(ast);
+        InductionOptimizer().run(ast);
+        if (profile) LoopUnroller(*profile).run(ast);
+        endPhase();
+    }
+    if (options.dumpTypedAST) ASTPrinter(std::cout).print(ast);
+
+    // 6. Optional: lower to SSA IR and optimize
+    if (options.wantsIR()) {
+        std::cout << "[Phase 5] Building IR..." << std::endl;
+        beginPhase("ir");
+        std::unique_ptr<Module> module;
+        try {
+            IRBuilder builder;
+            builder.profile = profile.get();
+            module = builder.build(ast);
+        } catch (std::runtime_error& error) {
+            std::cerr << "IR generation failed: " << error.what() << std::endl;
+            return 70;
+        }
+
+        PassManager passes = PassManager::standard();
+        passes.run(*module);
+        endPhase();
+
+        if (options.dumpIR) IRPrinter(std::cout).print(*module);
+        if (options.timePasses) passes.printTimings(std::cout);
+    }
 
     std::cout << "Success! Valid NanoScript code." << std::endl;
-    return 0;
+
+    // 7. Optional: execute
+    int exitStatus = 0; // main()'s result with --snapshot
+    if (options.run) {
+        std::cout << "[Phase 6] Running..." << std::endl;
+        beginPhase("run");
+        Interpreter interpreter;
+        Profiler profiler;
+        if (!options.profilePath.empty()) interpreter.setProfiler(&profiler);
+        ExecutionProfile recorded;
+        recorded.sourceHash = ExecutionProfile::hashSource(source);
+        if (!options.profileGenPath.empty()) interpreter.recordExecution(&recorded);
+        if (options.memoize) {
+            PurityAnalyzer purity;
+            purity.analyze(ast);
+            for (FunctionStmt* fn : purity.memoizationCandidates()) interpreter.memoize(fn);
+        }
+        try {
+            if (!entry) {
+                interpreter.run(ast);
+            } else {
+                // The top-level code runs only when there is no snapshot for this source yet
+                uint64_t sourceHash = ExecutionProfile::hashSource(source);
+                Snapshot snapshot;
+                if (snapshot.load(options.snapshotPath, sourceHash)) {
+                    interpreter.restore(ast, snapshot);
+                    std::cout << "Snapshot: restored from " << options.snapshotPath << std::endl;
+                } else {
+                    interpreter.run(ast);
+                    if (Snapshot::save(options.snapshotPath, sourceHash, interpreter.globalValues())) {
+                        std::cout << "Snapshot: written to " << options.snapshotPath << std::endl;
+                    } else {
+                        std::cerr << "Could not write snapshot: " << options.snapshotPath << std::endl;
+                    }
+                }
+                exitStatus = interpreter.start(entry).i;
+            }
+            endPhase();
+        } catch (RuntimeError& error) {
+            std::cout.flush();
+            std::cerr << "[line " << error.line << "] Runtime error: " << error.what() << std::endl;
+            return 70;
+        }
+        if (options.memoStats) interpreter.printMemoStats(std::cout);
+        if (!options.profileGenPath.empty() && !recorded.save(options.profileGenPath)) {
+            std::cerr << "Could not write profile: " << options.profileGenPath << std::endl;
+            return 1;
+        }
+        if (!options.profilePath.empty()) {
+            profiler.printReport(std::cout);
+            std::ofstream folded(options.profilePath);
+            if (!folded.is_open()) {
+                std::cerr << "Could not write profile: " << options.profilePath << std::endl;
+                return 1;
+            }
+            profiler.writeCollapsed(folded);
+        }
+    }
+
+    if (stats) {
+        stats->maxScopeDepth = modules ? modules->maxScopeDepth() : analyzer.maxScopeDepth();
+        if (options.statsJson) {
+            stats->printJson(std::cout);
+        } else {
+            stats->printText(std::cout);
+        }
+    }
+    return exitStatus;
 }
\ No newline at end of file
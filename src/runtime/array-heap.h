@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "../data/value.h"
+
+// Owns every array one Interpreter allocates. Values point at arrays
+// without owning them, which keeps Value trivially copyable: scalar code
+// pays nothing for arrays existing.
+//
+// Unreachable arrays are reclaimed by mark and sweep. The interpreter
+// marks its roots (globals, the frame stack and the values it is holding)
+// between statements once kInitialThreshold bytes, or twice what survived
+// the previous collection, have been allocated since. Arrays hold no
+// references, so marking never recurses.
+//
+// Interpreters running the iterations of a parallel for share the arrays
+// of the one that started it. Each marks only the arrays it owns, so the
+// shared ones are never touched by two threads' collections.
+class ArrayHeap {
+public:
+    static const size_t kInitialThreshold = 1 << 20;
+
+    long long collections = 0;
+
+private:
+    std::vector<ArrayBuffer*> arrays;
+    size_t bytes = 0; // Live after the last sweep + allocated since
+    size_t threshold = kInitialThreshold;
+
+    static size_t sizeOf(const ArrayBuffer* array) {
+        return sizeof(ArrayBuffer) + array->length * (array->elementType == TokenType::TYPE_FLOAT ? sizeof(double) : sizeof(int));
+    }
+
+public:
+    ArrayHeap() = default;
+    ArrayHeap(const ArrayHeap&) = delete;
+    ArrayHeap& operator=(const ArrayHeap&) = delete;
+    ~ArrayHeap() {
+        for (ArrayBuffer* array : arrays) delete array;
+    }
+
+    // Throws std::bad_alloc like new
+    ArrayBuffer* allocate(TokenType elementType, size_t length) {
+        arrays.reserve(arrays.size() + 1);
+        ArrayBuffer* array = new ArrayBuffer(elementType, length);
+        array->owner = this;
+        arrays.push_back(array);
+        bytes += sizeOf(array);
+        return array;
+    }
+
+    bool wantsCollection() const { return bytes >= threshold; }
+
+    void mark(const Value& value) {
+        if (value.array && value.array->owner == this) value.array->marked = true;
+    }
+
+    // Frees every array that was not marked since the last sweep
+    void sweep() {
+        size_t kept = 0;
+        bytes = 0;
+        for (ArrayBuffer* array : arrays) {
+            if (!array->marked) {
+                delete array;
+                continue;
+            }
+            array->marked = false;
+            bytes += sizeOf(array);
+            arrays[kept++] = array;
+        }
+        arrays.resize(kept);
+        threshold = bytes * 2 > kInitialThreshold ? bytes * 2 : kInitialThreshold;
+        collections++;
+    }
+};
@@ -0,0 +1,845 @@
+#include "interpreter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include "../util/trace.h"
+#include "vector-kernels.h"
+#include "work-stealing-pool.h"
+
+// Assigns every variable reference its Slot and every function its frame
+// size. Locals get consecutive frame slots (parameters first); names that
+// are not local resolve to global indices.
+class SlotResolver : public ASTWalker {
+private:
+    Interpreter& interp;
+    std::vector<std::unordered_map<std::string, int>> scopes;
+    size_t functionBase = 0; // Scopes below this belong to enclosing code
+    int nextSlot = 0;
+
+    void resolve(const Token& name, Slot& slot) {
+        for (size_t i = scopes.size(); i-- > 0;) {
+            auto found = scopes[i].find(name.lexeme);
+            if (found == scopes[i].end()) continue;
+            if (i < functionBase) {
+                throw RuntimeError(name.line, "Functions cannot use locals of the code that declares them ('" + name.lexeme + "').");
+            }
+            slot.global = false;
+            slot.index = found->second;
+            return;
+        }
+        slot.global = true;
+        slot.index = interp.globalSlot(name.lexeme);
+    }
+
+public:
+    SlotResolver(Interpreter& interp) : interp(interp) {}
+
+    // Returns the number of slots needed by top-level blocks
+    int resolveProgram(const std::vector<std::unique_ptr<Statement>>& program) {
+        walk(program);
+        return nextSlot;
+    }
+
+    void resolveFunction(FunctionStmt* fn) {
+        interp.prepared.insert(fn);
+        size_t savedBase = functionBase;
+        int savedNext = nextSlot;
+
+        functionBase = scopes.size();
+        nextSlot = 0;
+        scopes.emplace_back();
+        for (const auto& param : fn->params) scopes.back()[param.lexeme] = nextSlot++;
+        walk(fn->body);
+        fn->frameSize = nextSlot;
+        scopes.pop_back();
+
+        functionBase = savedBase;
+        nextSlot = savedNext;
+    }
+
+    void visitVariableExpr(VariableExpr* expr) override { resolve(expr->name, expr->slot); }
+    void visitAssignExpr(AssignExpr* expr) override {
+        expr->value->accept(this);
+        resolve(expr->name, expr->slot);
+    }
+    void visitCallExpr(CallExpr* expr) override {
+        // The callee is reached through `resolved` (or is a builtin), not through a variable
+        for (const auto& arg : expr->arguments) arg->accept(this);
+        if (expr->resolved) interp.prepare(expr->resolved);
+    }
+
+    void visitBlockStmt(BlockStmt* stmt) override {
+        scopes.emplace_back();
+        walk(stmt->statements);
+        scopes.pop_back();
+    }
+    void visitFunctionStmt(FunctionStmt* stmt) override { resolveFunction(stmt); }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        stmt->start->accept(this);
+        stmt->end->accept(this);
+        for (SharedWrite& write : stmt->writes) resolve(write.name, write.slot);
+        // The loop variable always gets a frame slot, even at top level
+        scopes.emplace_back();
+        stmt->slot.global = false;
+        stmt->slot.index = nextSlot++;
+        scopes.back()[stmt->name.lexeme] = stmt->slot.index;
+        stmt->body->accept(this);
+        scopes.pop_back();
+    }
+    void visitVarStmt(VarStmt* stmt) override {
+        if (stmt->initializer) stmt->initializer->accept(this); // Still sees the outer name
+        if (scopes.empty()) {
+            stmt->slot.global = true;
+            stmt->slot.index = interp.globalSlot(stmt->name.lexeme);
+        } else {
+            stmt->slot.global = false;
+            stmt->slot.index = nextSlot++;
+            scopes.back()[stmt->name.lexeme] = stmt->slot.index;
+        }
+    }
+};
+
+int Interpreter::globalSlot(const std::string& name) {
+    auto found = globalIndex.find(name);
+    if (found != globalIndex.end()) return found->second;
+    int index = (int)globals.size();
+    globalIndex[name] = index;
+    globals.emplace_back();
+    return index;
+}
+
+void Interpreter::prepare(FunctionStmt* fn) {
+    if (prepared.count(fn)) return;
+    SlotResolver(*this).resolveFunction(fn);
+}
+
+void Interpreter::step() {
+    steps++;
+    if (limits.maxSteps > 0 && steps > limits.maxSteps) {
+        throw BudgetExceeded(currentLine, "Step budget exhausted.");
+    }
+}
+
+void Interpreter::execute(Statement* stmt) {
+    step();
+    if (heap.wantsCollection() || strings.wantsCollection()) collectGarbage();
+    stmt->accept(this);
+}
+
+Value Interpreter::evaluate(Expression* expr) {
+    expr->accept(this);
+    return lastValue;
+}
+
+Value& Interpreter::load(const Slot& slot, const Token& name) {
+    if (!slot.global) return stack[frameBase + slot.index];
+    Value& value = globals[slot.index];
+    if (!value.isDefined()) throw RuntimeError(name.line, "Undefined variable '" + name.lexeme + "'.");
+    return value;
+}
+
+Value Interpreter::zeroOf(TokenType type) {
+    if (!isArrayType(type)) return Value::zero(type);
+    return Value::ofArray(heap.allocate(elementTypeOf(type), 0));
+}
+
+void Interpreter::collectGarbage() {
+    for (const Value* roots : {&lastValue, &returnValue}) {
+        heap.mark(*roots);
+        strings.mark(*roots);
+    }
+    for (const Value& value : globals) {
+        heap.mark(value);
+        strings.mark(value);
+    }
+    for (const Value& value : stack) {
+        heap.mark(value);
+        strings.mark(value);
+    }
+    heap.sweep();
+    strings.sweep();
+}
+
+void Interpreter::flushOutput() {
+    out.write(output.data(), (std::streamsize)output.size());
+    output.clear();
+}
+
+Value Interpreter::callFunction(FunctionStmt* fn, size_t base, int line) {
+    MemoCache* cache = nullptr;
+    std::vector<Value> key; // The body may reassign its parameters
+    if (!memoCaches.empty()) {
+        auto found = memoCaches.find(fn);
+        if (found != memoCaches.end()) {
+            cache = &found->second;
+            Value cached;
+            if (cache->lookup(&stack[base], cached)) {
+                stack.resize(base);
+                return cached;
+            }
+            key.assign(stack.begin() + base, stack.begin() + base + fn->params.size());
+        }
+    }
+
+    step();
+    if (depth >= limits.maxDepth) throw BudgetExceeded(line, "Stack overflow.");
+    depth++;
+    if (profiler) profiler->enter(fn);
+
+    size_t savedBase = frameBase;
+    stack.resize(base + fn->frameSize);
+    frameBase = base;
+
+    for (const auto& stmt : fn->body) {
+        execute(stmt.get());
+        if (returning) break;
+    }
+
+    TokenType returnType = fn->returnType.type;
+    Value result = returning ? returnValue.convertTo(returnType) : zeroOf(returnType);
+    returning = false;
+    if (cache) cache->insert(key.data(), result);
+
+    stack.resize(base);
+    frameBase = savedBase;
+    depth--;
+    if (profiler) profiler->exit();
+    return result;
+}
+
+void Interpreter::run(const std::vector<std::unique_ptr<Statement>>& program) {
+    prepared.clear();
+    topLevelFrameSize = SlotResolver(*this).resolveProgram(program);
+
+    stack.assign(topLevelFrameSize, Value());
+    frameBase = 0;
+    if (profiler) profiler->begin();
+    try {
+        for (const auto& stmt : program) execute(stmt.get());
+    } catch (...) {
+        flushOutput(); // What was printed before the error
+        out.flush();
+        throw;
+    }
+    if (profiler) profiler->finish();
+    flushOutput();
+    out.flush();
+}
+
+std::vector<std::pair<std::string, Value>> Interpreter::globalValues() const {
+    std::vector<std::pair<std::string, Value>> values(globals.size());
+    for (const auto& entry : globalIndex) values[entry.second] = {entry.first, globals[entry.second]};
+    values.erase(std::remove_if(values.begin(), values.end(), [](const auto& value) { return !value.second.isDefined(); }),
+                 values.end());
+    return values;
+}
+
+void Interpreter::restore(const std::vector<std::unique_ptr<Statement>>& program, const Snapshot& snapshot) {
+    prepared.clear();
+    topLevelFrameSize = SlotResolver(*this).resolveProgram(program);
+    stack.assign(topLevelFrameSize, Value());
+    frameBase = 0;
+
+    std::vector<ArrayBuffer*> arrays;
+    for (const Snapshot::Array& saved : snapshot.arrays()) {
+        ArrayBuffer* array = heap.allocate(saved.elementType, saved.length);
+        size_t width = saved.elementType == TokenType::TYPE_FLOAT ? sizeof(double) : sizeof(int);
+        std::memcpy(array->elementType == TokenType::TYPE_FLOAT ? (void*)array->floats() : (void*)array->ints(),
+                    saved.elements, saved.length * width);
+        arrays.push_back(array);
+    }
+    for (const Snapshot::Global& saved : snapshot.globals()) {
+        auto found = globalIndex.find(std::string(saved.name));
+        if (found == globalIndex.end()) continue; // Same source, so every name is declared
+        Value& value = globals[found->second];
+        if (saved.type == TokenType::TYPE_STRING) {
+            value = Value::ofString(strings.leaf(std::string(saved.text)));
+        } else if (isArrayType(saved.type)) {
+            value = Value::ofArray(arrays[saved.array]);
+        } else {
+            value = saved.scalar;
+        }
+    }
+}
+
+Value Interpreter::start(FunctionStmt* entry) {
+    try {
+        Value result = call(entry, {});
+        flushOutput();
+        out.flush();
+        return result;
+    } catch (...) {
+        flushOutput();
+        out.flush();
+        throw;
+    }
+}
+
+Value Interpreter::call(FunctionStmt* fn, std::vector<Value> args) {
+    size_t savedSize = stack.size();
+    size_t savedBase = frameBase;
+    int savedDepth = depth;
+    try {
+        prepare(fn);
+        for (size_t i = 0; i < args.size(); i++) stack.push_back(args[i].convertTo(fn->paramTypes[i].type));
+        return callFunction(fn, savedSize, fn->name.line);
+    } catch (...) {
+        stack.resize(savedSize);
+        frameBase = savedBase;
+        depth = savedDepth;
+        returning = false;
+        throw;
+    }
+}
+
+Value Interpreter::evaluateConstant(Expression* expr) {
+    size_t savedSize = stack.size();
+    size_t savedBase = frameBase;
+    int savedDepth = depth;
+    try {
+        SlotResolver resolver(*this);
+        expr->accept(&resolver);
+        return evaluate(expr);
+    } catch (...) {
+        stack.resize(savedSize);
+        frameBase = savedBase;
+        depth = savedDepth;
+        returning = false;
+        throw;
+    }
+}
+
+void Interpreter::memoize(FunctionStmt* fn) {
+    if (memoCaches.count(fn)) return;
+    memoCaches.emplace(fn, MemoCache(fn->params.size()));
+    memoOrder.push_back(fn);
+}
+
+void Interpreter::printMemoStats(std::ostream& stats) const {
+    stats << "=== Memoization ===" << std::endl;
+    if (memoOrder.empty()) stats << "  (no candidate functions)" << std::endl;
+    stats << std::fixed << std::setprecision(1);
+    for (FunctionStmt* fn : memoOrder) {
+        const MemoCache& cache = memoCaches.at(fn);
+        stats << "  " << std::left << std::setw(16) << fn->name.lexeme << std::right
+              << std::setw(8) << cache.size() << " entries"
+              << std::setw(12) << cache.hits << " hits"
+              << std::setw(12) << cache.misses << " misses"
+              << std::setw(8) << cache.hitRate() * 100.0 << "% hit rate";
+        if (cache.dropped > 0) stats << "  (full: " << cache.dropped << " results not stored)";
+        stats << std::endl;
+    }
+    stats.unsetf(std::ios::floatfield);
+    stats << std::setprecision(6);
+}
+
+void Interpreter::setGlobal(const std::string& name, const Value& value) {
+    globals[globalSlot(name)] = value;
+}
+
+// --- Expressions ---
+
+void Interpreter::visitBinaryExpr(BinaryExpr* expr) {
+    TokenType op = expr->op.type;
+    currentLine = expr->op.line;
+
+    if (op == TokenType::AND || op == TokenType::OR) {
+        bool left = evaluate(expr->left.get()).b;
+        if (op == TokenType::AND ? !left : left) {
+            lastValue = Value::ofBool(left);
+            return;
+        }
+        lastValue = Value::ofBool(evaluate(expr->right.get()).b);
+        return;
+    }
+
+    Value left = evaluate(expr->left.get());
+    bool held = left.array || left.str;
+    if (held) stack.push_back(left);
+    Value right = evaluate(expr->right.get());
+    if (held) stack.pop_back();
+    if (left.array || right.array) {
+        lastValue = arrayArithmetic(expr->op, left, right);
+        return;
+    }
+    if (left.str) {
+        if (op == TokenType::PLUS) {
+            lastValue = Value::ofString(strings.concat(left.str, right.str));
+        } else {
+            bool equal = StringNode::equal(left.str, right.str);
+            lastValue = Value::ofBool(op == TokenType::EQUAL_EQUAL ? equal : !equal);
+        }
+        return;
+    }
+    bool ints = left.type == TokenType::TYPE_INT && right.type == TokenType::TYPE_INT;
+
+    switch (op) {
+        case TokenType::PLUS:
+            lastValue = ints ? Value::ofInt(Value::wrap((long long)left.i + right.i)) : Value::ofFloat(left.asFloat() + right.asFloat());
+            return;
+        case TokenType::MINUS:
+            lastValue = ints ? Value::ofInt(Value::wrap((long long)left.i - right.i)) : Value::ofFloat(left.asFloat() - right.asFloat());
+            return;
+        case TokenType::STAR:
+            lastValue = ints ? Value::ofInt(Value::wrap((long long)left.i * right.i)) : Value::ofFloat(left.asFloat() * right.asFloat());
+            return;
+        case TokenType::SLASH:
+            if (ints) {
+                if (right.i == 0) throw RuntimeError(expr->op.line, "Division by zero.");
+                lastValue = Value::ofInt(Value::wrap((long long)left.i / right.i));
+            } else {
+                lastValue = Value::ofFloat(left.asFloat() / right.asFloat());
+            }
+            return;
+        default:
+            break;
+    }
+
+    // Comparisons: bools compare as 0/1, mixed numbers as floats
+    double l, r;
+    if (left.type == TokenType::TYPE_BOOL || right.type == TokenType::TYPE_BOOL) {
+        l = left.b;
+        r = right.b;
+    } else if (ints) {
+        l = left.i;
+        r = right.i;
+    } else {
+        l = left.asFloat();
+        r = right.asFloat();
+    }
+    switch (op) {
+        case TokenType::EQUAL_EQUAL: lastValue = Value::ofBool(l == r); return;
+        case TokenType::BANG_EQUAL: lastValue = Value::ofBool(l != r); return;
+        case TokenType::LESS: lastValue = Value::ofBool(l < r); return;
+        case TokenType::LESS_EQUAL: lastValue = Value::ofBool(l <= r); return;
+        case TokenType::GREATER: lastValue = Value::ofBool(l > r); return;
+        case TokenType::GREATER_EQUAL: lastValue = Value::ofBool(l >= r); return;
+        default:
+            throw RuntimeError(expr->op.line, "Unsupported operator '" + expr->op.lexeme + "'.");
+    }
+}
+
+void Interpreter::visitGroupingExpr(GroupingExpr* expr) {
+    expr->expression->accept(this);
+}
+
+void Interpreter::visitLiteralExpr(LiteralExpr* expr) {
+    lastValue = expr->constant;
+}
+
+void Interpreter::visitUnaryExpr(UnaryExpr* expr) {
+    Value right = evaluate(expr->right.get());
+    if (expr->op.type == TokenType::BANG) {
+        lastValue = Value::ofBool(!right.b);
+    } else if (right.type == TokenType::TYPE_INT) {
+        lastValue = Value::ofInt(Value::wrap(-(long long)right.i));
+    } else {
+        lastValue = Value::ofFloat(-right.f);
+    }
+}
+
+void Interpreter::visitVariableExpr(VariableExpr* expr) {
+    lastValue = load(expr->slot, expr->name);
+}
+
+void Interpreter::visitAssignExpr(AssignExpr* expr) {
+    Value value = evaluate(expr->value.get());
+    Value& target = load(expr->slot, expr->name); // After evaluating: calls may grow the stack
+    target = value.convertTo(target.type);
+    lastValue = target;
+}
+
+void Interpreter::visitCallExpr(CallExpr* expr) {
+    if (expr->builtin != Builtin::NONE) {
+        lastValue = callBuiltin(expr);
+        return;
+    }
+    FunctionStmt* fn = expr->resolved;
+    if (!fn) throw RuntimeError(expr->paren.line, "Can only call functions.");
+
+    // Arguments go straight into the callee's frame; nested calls made
+    // while evaluating them push and pop above it.
+    size_t base = stack.size();
+    for (size_t i = 0; i < expr->arguments.size(); i++) {
+        Value arg = evaluate(expr->arguments[i].get());
+        stack.push_back(arg.convertTo(fn->paramTypes[i].type));
+    }
+    currentLine = expr->paren.line;
+    if (recorder) recorder->calls[ExecutionProfile::key(expr->paren.line, expr->paren.column)]++;
+    lastValue = callFunction(fn, base, expr->paren.line);
+}
+
+// --- Arrays ---
+
+namespace {
+
+// `v` as `length` elements of `elementType`: an array of that type as it
+// is, an int[] widened to floats, or a scalar repeated
+ArrayBuffer* operandArray(ArrayHeap& heap, const Value& v, TokenType elementType, size_t length) {
+    if (v.array && v.array->elementType == elementType) return v.array;
+    ArrayBuffer* buffer = heap.allocate(elementType, length);
+    if (v.array) {
+        std::copy(v.array->ints(), v.array->ints() + length, buffer->floats());
+    } else if (elementType == TokenType::TYPE_FLOAT) {
+        std::fill_n(buffer->floats(), length, v.asFloat());
+    } else {
+        std::fill_n(buffer->ints(), length, v.i);
+    }
+    return buffer;
+}
+
+size_t checkedIndex(const ArrayBuffer& array, const Value& index, const Token& bracket) {
+    if (index.i < 0 || (size_t)index.i >= array.length) {
+        throw RuntimeError(bracket.line, "Index " + std::to_string(index.i) + " is out of bounds for an array of length " +
+                                             std::to_string(array.length) + ".");
+    }
+    return (size_t)index.i;
+}
+
+void checkSameLength(const ArrayBuffer& a, const ArrayBuffer& b, int line) {
+    if (a.length != b.length) {
+        throw RuntimeError(line, "Array lengths differ (" + std::to_string(a.length) + " and " + std::to_string(b.length) + ").");
+    }
+}
+
+} // namespace
+
+Value Interpreter::arrayArithmetic(const Token& op, const Value& left, const Value& right) {
+    if (left.array && right.array) checkSameLength(*left.array, *right.array, op.line);
+    size_t length = left.array ? left.array->length : right.array->length;
+    bool floats = left.type == TokenType::TYPE_FLOAT || left.type == TokenType::TYPE_FLOAT_ARRAY ||
+                  right.type == TokenType::TYPE_FLOAT || right.type == TokenType::TYPE_FLOAT_ARRAY;
+    TokenType elementType = floats ? TokenType::TYPE_FLOAT : TokenType::TYPE_INT;
+    ArrayBuffer* a = operandArray(heap, left, elementType, length);
+    ArrayBuffer* b = operandArray(heap, right, elementType, length);
+    ArrayBuffer* result = heap.allocate(elementType, length);
+
+    const VectorKernels& kernels = VectorKernels::active();
+    if (floats) {
+        auto kernel = op.type == TokenType::PLUS ? kernels.addFloat : op.type == TokenType::MINUS ? kernels.subFloat
+                    : op.type == TokenType::STAR ? kernels.mulFloat : kernels.divFloat;
+        kernel(a->floats(), b->floats(), result->floats(), length);
+    } else if (op.type == TokenType::SLASH) {
+        // No vector integer division; same rules as the scalar operator
+        for (size_t k = 0; k < length; k++) {
+            if (b->ints()[k] == 0) throw RuntimeError(op.line, "Division by zero.");
+            result->ints()[k] = Value::wrap((long long)a->ints()[k] / b->ints()[k]);
+        }
+    } else {
+        auto kernel = op.type == TokenType::PLUS ? kernels.addInt : op.type == TokenType::MINUS ? kernels.subInt : kernels.mulInt;
+        kernel(a->ints(), b->ints(), result->ints(), length);
+    }
+    return Value::ofArray(result);
+}
+
+Value Interpreter::callBuiltin(CallExpr* expr) {
+    step();
+    Value first = evaluate(expr->arguments[0].get());
+    if (expr->builtin == Builtin::STR) return first.str ? first : Value::ofString(strings.leaf(first.toString()));
+    if (first.str) return Value::ofInt((int)first.str->length); // len
+    if (!first.array) {
+        // min(x, y) / max(x, y) of two numbers; mixed operands compare as floats
+        Value second = evaluate(expr->arguments[1].get());
+        bool min = expr->builtin == Builtin::MIN;
+        if (first.type == TokenType::TYPE_INT && second.type == TokenType::TYPE_INT) {
+            return Value::ofInt(min ? std::min(first.i, second.i) : std::max(first.i, second.i));
+        }
+        double x = first.asFloat(), y = second.asFloat();
+        return Value::ofFloat(min ? (x < y ? x : y) : (x > y ? x : y));
+    }
+    const ArrayBuffer& a = *first.array;
+    bool floats = a.elementType == TokenType::TYPE_FLOAT;
+    const VectorKernels& kernels = VectorKernels::active();
+    currentLine = expr->paren.line;
+
+    switch (expr->builtin) {
+        case Builtin::LEN:
+            return Value::ofInt((int)a.length);
+        case Builtin::SUM:
+            return floats ? Value::ofFloat(kernels.sumFloat(a.floats(), a.length)) : Value::ofInt(kernels.sumInt(a.ints(), a.length));
+        case Builtin::MIN:
+        case Builtin::MAX: {
+            bool min = expr->builtin == Builtin::MIN;
+            if (a.length == 0) throw RuntimeError(expr->paren.line, std::string(min ? "min" : "max") + " of an empty array.");
+            if (floats) return Value::ofFloat((min ? kernels.minFloat : kernels.maxFloat)(a.floats(), a.length));
+            return Value::ofInt((min ? kernels.minInt : kernels.maxInt)(a.ints(), a.length));
+        }
+        case Builtin::DOT: {
+            stack.push_back(first);
+            Value second = evaluate(expr->arguments[1].get());
+            stack.pop_back();
+            checkSameLength(a, *second.array, expr->paren.line);
+            if (!floats && second.array->elementType == TokenType::TYPE_INT) {
+                return Value::ofInt(kernels.dotInt(a.ints(), second.array->ints(), a.length));
+            }
+            ArrayBuffer* x = operandArray(heap, first, TokenType::TYPE_FLOAT, a.length);
+            ArrayBuffer* y = operandArray(heap, second, TokenType::TYPE_FLOAT, a.length);
+            return Value::ofFloat(kernels.dotFloat(x->floats(), y->floats(), a.length));
+        }
+        default:
+            throw RuntimeError(expr->paren.line, "Unknown builtin.");
+    }
+}
+
+void Interpreter::visitArrayExpr(ArrayExpr* expr) {
+    if (expr->length) {
+        Value length = evaluate(expr->length.get());
+        if (length.i < 0) {
+            throw RuntimeError(expr->bracket.line, "Array length must not be negative (got " + std::to_string(length.i) + ").");
+        }
+        try {
+            lastValue = Value::ofArray(heap.allocate(expr->elementType, (size_t)length.i));
+        } catch (std::bad_alloc&) {
+            throw RuntimeError(expr->bracket.line, "Out of memory allocating an array of " + std::to_string(length.i) + " elements.");
+        }
+        return;
+    }
+
+    ArrayBuffer* buffer = heap.allocate(expr->elementType, expr->elements.size());
+    stack.push_back(Value::ofArray(buffer));
+    for (size_t k = 0; k < expr->elements.size(); k++) {
+        Value element = evaluate(expr->elements[k].get());
+        if (expr->elementType == TokenType::TYPE_FLOAT) {
+            buffer->floats()[k] = element.asFloat();
+        } else {
+            buffer->ints()[k] = element.i;
+        }
+    }
+    stack.pop_back();
+    lastValue = Value::ofArray(buffer);
+}
+
+void Interpreter::visitIndexExpr(IndexExpr* expr) {
+    Value array = evaluate(expr->array.get());
+    stack.push_back(array);
+    Value index = evaluate(expr->index.get());
+    stack.pop_back();
+    size_t k = checkedIndex(*array.array, index, expr->bracket);
+    lastValue = array.array->elementType == TokenType::TYPE_FLOAT ? Value::ofFloat(array.array->floats()[k])
+                                                                 : Value::ofInt(array.array->ints()[k]);
+}
+
+void Interpreter::visitIndexAssignExpr(IndexAssignExpr* expr) {
+    Value array = evaluate(expr->array.get());
+    stack.push_back(array);
+    Value index = evaluate(expr->index.get());
+    Value value = evaluate(expr->value.get());
+    stack.pop_back();
+    size_t k = checkedIndex(*array.array, index, expr->bracket);
+    if (array.array->elementType == TokenType::TYPE_FLOAT) {
+        array.array->floats()[k] = value.asFloat();
+        lastValue = Value::ofFloat(value.asFloat());
+    } else {
+        array.array->ints()[k] = value.i;
+        lastValue = Value::ofInt(value.i);
+    }
+}
+
+// --- Statements ---
+
+void Interpreter::visitBlockStmt(BlockStmt* stmt) {
+    for (const auto& s : stmt->statements) {
+        execute(s.get());
+        if (returning) return;
+    }
+}
+
+void Interpreter::visitExpressionStmt(ExpressionStmt* stmt) {
+    evaluate(stmt->expression.get());
+}
+
+void Interpreter::visitFunctionStmt(FunctionStmt*) {
+    // Declarations have no runtime effect; calls use CallExpr::resolved
+}
+
+void Interpreter::visitIfStmt(IfStmt* stmt) {
+    bool taken = evaluate(stmt->condition.get()).b;
+    if (recorder) {
+        ExecutionProfile::BranchCounts& counts = recorder->ifs[ExecutionProfile::key(stmt->line, stmt->column)];
+        (taken ? counts.taken : counts.notTaken)++;
+    }
+    if (taken) {
+        execute(stmt->thenBranch.get());
+    } else if (stmt->elseBranch) {
+        execute(stmt->elseBranch.get());
+    }
+}
+
+void Interpreter::visitPrintStmt(PrintStmt* stmt) {
+    Value value = evaluate(stmt->expression.get());
+    if (value.str) {
+        value.str->forEachPiece([&](const std::string& piece) { output += piece; });
+    } else {
+        output += value.toString();
+    }
+    output += '\n';
+    if (output.size() >= kOutputBlock) flushOutput();
+}
+
+void Interpreter::visitReturnStmt(ReturnStmt* stmt) {
+    currentLine = stmt->keyword.line;
+    returnValue = stmt->value ? evaluate(stmt->value.get()) : Value();
+    returning = true;
+}
+
+void Interpreter::visitVarStmt(VarStmt* stmt) {
+    currentLine = stmt->name.line;
+    Value value = stmt->initializer ? evaluate(stmt->initializer.get()) : zeroOf(stmt->type.type);
+    value = value.convertTo(stmt->type.type);
+    if (stmt->slot.global) {
+        globals[stmt->slot.index] = value;
+    } else {
+        stack[frameBase + stmt->slot.index] = value;
+    }
+}
+
+void Interpreter::visitWhileStmt(WhileStmt* stmt) {
+    long long iterations = 0;
+    while (evaluate(stmt->condition.get()).b) {
+        iterations++;
+        execute(stmt->body.get());
+        if (returning) break;
+    }
+    if (profiler) profiler->recordLoop(stmt, iterations);
+    if (recorder) {
+        ExecutionProfile::BranchCounts& counts = recorder->loops[ExecutionProfile::key(stmt->line, stmt->column)];
+        counts.taken += iterations;
+        if (!returning) counts.notTaken++;
+    }
+}
+
+// --- Parallel loops ---
+
+namespace {
+
+Value identityOf(ReductionOp op, TokenType type, const Value& initial) {
+    bool floats = type == TokenType::TYPE_FLOAT;
+    switch (op) {
+        case ReductionOp::SUM: return floats ? Value::ofFloat(0.0) : Value::ofInt(0);
+        case ReductionOp::PRODUCT: return floats ? Value::ofFloat(1.0) : Value::ofInt(1);
+        default: return initial; // min/max: folding the initial value in again changes nothing
+    }
+}
+
+Value combine(ReductionOp op, const Value& a, const Value& b) {
+    bool ints = a.type == TokenType::TYPE_INT;
+    switch (op) {
+        case ReductionOp::SUM:
+            return ints ? Value::ofInt(Value::wrap((long long)a.i + b.i)) : Value::ofFloat(a.f + b.f);
+        case ReductionOp::PRODUCT:
+            return ints ? Value::ofInt(Value::wrap((long long)a.i * b.i)) : Value::ofFloat(a.f * b.f);
+        case ReductionOp::MIN:
+            return ints ? Value::ofInt(std::min(a.i, b.i)) : Value::ofFloat(a.f < b.f ? a.f : b.f);
+        case ReductionOp::MAX:
+            return ints ? Value::ofInt(std::max(a.i, b.i)) : Value::ofFloat(a.f > b.f ? a.f : b.f);
+        default:
+            return b;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<Interpreter> Interpreter::spawnWorker() const {
+    auto worker = std::make_unique<Interpreter>(limits, out);
+    worker->globals = globals;
+    worker->stack.assign(stack.begin() + frameBase, stack.end());
+    worker->depth = depth;
+    for (FunctionStmt* fn : memoOrder) {
+        worker->memoCaches.emplace(fn, memoCaches.at(fn).copyEntries());
+        worker->memoOrder.push_back(fn);
+    }
+    return worker;
+}
+
+bool Interpreter::writesAliasedArray(ParallelForStmt* loop) {
+    for (const SharedWrite& write : loop->writes) {
+        if (write.op != ReductionOp::NONE) continue;
+        ArrayBuffer* array = load(write.slot, write.name).array;
+        int holders = 0;
+        for (const Value& value : globals) holders += value.array == array;
+        for (size_t k = frameBase; k < stack.size(); k++) holders += stack[k].array == array;
+        if (holders > 1) return true;
+    }
+    return false;
+}
+
+void Interpreter::runIterations(ParallelForStmt* loop, long long first, long long last, const std::vector<Value>& seeds,
+                                Value* partials) {
+    const std::vector<SharedWrite>& writes = loop->writes;
+    for (size_t k = 0; k < writes.size(); k++) {
+        if (writes[k].op != ReductionOp::NONE) load(writes[k].slot, writes[k].name) = seeds[k];
+    }
+    for (long long i = first; i < last; i++) {
+        stack[frameBase + loop->slot.index] = Value::ofInt((int)i);
+        execute(loop->body.get());
+    }
+    for (size_t k = 0; k < writes.size(); k++) {
+        if (writes[k].op != ReductionOp::NONE) partials[k] = load(writes[k].slot, writes[k].name);
+    }
+}
+
+void Interpreter::visitParallelForStmt(ParallelForStmt* stmt) {
+    currentLine = stmt->keyword.line;
+    long long start = evaluate(stmt->start.get()).i;
+    long long end = evaluate(stmt->end.get()).i;
+    if (end <= start) return;
+
+    long long iterations = end - start;
+    size_t chunks = (size_t)std::min(iterations, kMaxChunks);
+    auto firstOf = [&](size_t chunk) { return start + iterations * (long long)chunk / (long long)chunks; };
+
+    const std::vector<SharedWrite>& writes = stmt->writes;
+    std::vector<Value> initials(writes.size());
+    std::vector<Value> seeds(writes.size());
+    for (size_t k = 0; k < writes.size(); k++) {
+        if (writes[k].op == ReductionOp::NONE) continue;
+        initials[k] = load(writes[k].slot, writes[k].name);
+        seeds[k] = identityOf(writes[k].op, writes[k].type, initials[k]);
+    }
+    std::vector<Value> partials(chunks * writes.size());
+
+    WorkStealingPool& pool = WorkStealingPool::shared();
+    bool parallel = pool.size() > 1 && !WorkStealingPool::insideWorker() && limits.maxSteps == 0 && !profiler &&
+                    !recorder && !writesAliasedArray(stmt);
+    if (!parallel) {
+        for (size_t c = 0; c < chunks; c++) runIterations(stmt, firstOf(c), firstOf(c + 1), seeds, &partials[c * writes.size()]);
+    } else {
+        // A failed chunk stops the ones after it; the earliest failure is
+        // the one that would have happened first in sequential order.
+        std::vector<std::unique_ptr<Interpreter>> workers(pool.size());
+        std::vector<std::exception_ptr> failures(chunks);
+        std::atomic<size_t> firstFailure{chunks};
+        pool.run(chunks, [&](unsigned worker, size_t c) {
+            if (c > firstFailure.load()) return;
+            TraceSpan span("parallel for chunk");
+            if (span.active()) {
+                span.arg("line", (long long)stmt->keyword.line);
+                span.arg("iterations", firstOf(c + 1) - firstOf(c));
+            }
+            try {
+                if (!workers[worker]) workers[worker] = spawnWorker();
+                workers[worker]->runIterations(stmt, firstOf(c), firstOf(c + 1), seeds, &partials[c * writes.size()]);
+            } catch (...) {
+                failures[c] = std::current_exception();
+                size_t seen = firstFailure.load();
+                while (c < seen && !firstFailure.compare_exchange_weak(seen, c)) {
+                }
+            }
+        });
+
+        for (const auto& worker : workers) {
+            if (!worker) continue;
+            for (const auto& entry : worker->memoCaches) memoCaches.at(entry.first).absorb(entry.second);
+        }
+        if (firstFailure.load() < chunks) std::rethrow_exception(failures[firstFailure.load()]);
+    }
+
+    for (size_t k = 0; k < writes.size(); k++) {
+        if (writes[k].op == ReductionOp::NONE) continue;
+        Value result = initials[k];
+        for (size_t c = 0; c < chunks; c++) result = combine(writes[k].op, result, partials[c * writes.size() + k]);
+        load(writes[k].slot, writes[k].name) = result;
+    }
+}
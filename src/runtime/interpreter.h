@@ -0,0 +1,157 @@
+#pragma once
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../data/AST.h"
+#include "../data/execution-profile.h"
+#include "../data/snapshot.h"
+#include "../data/value.h"
+#include "array-heap.h"
+#include "memo-cache.h"
+#include "profiler.h"
+#include "string-heap.h"
+
+class RuntimeError : public std::runtime_error {
+public:
+    int line;
+    RuntimeError(int line, const std::string& message) : std::runtime_error(message), line(line) {}
+};
+
+// Thrown when an evaluation runs past its step or recursion budget.
+class BudgetExceeded : public RuntimeError {
+public:
+    BudgetExceeded(int line, const std::string& message) : RuntimeError(line, message) {}
+};
+
+// Tree-walking interpreter for a semantically valid AST.
+// Variables are resolved to frame slots / global indices once per function
+// (see Slot in AST.h); calls go straight to CallExpr::resolved.
+class Interpreter : public ASTVisitor {
+public:
+    struct Limits {
+        long long maxSteps = 0; // Statements + calls; 0 means unlimited
+        int maxDepth = 5000;    // Nested calls before "Stack overflow."
+    };
+
+private:
+    // print appends here; written to `out` in blocks of this size and
+    // when the program ends, so printing in a loop is not a write per line
+    static const size_t kOutputBlock = 1 << 16;
+
+    Limits limits;
+    std::ostream& out;
+    std::string output;
+
+    std::unordered_map<std::string, int> globalIndex;
+    std::vector<Value> globals;
+    std::vector<Value> stack;  // Frames of all active calls
+    size_t frameBase = 0;
+    int topLevelFrameSize = 0;
+    long long steps = 0;
+    int depth = 0;
+    int currentLine = 0;
+    std::unordered_set<FunctionStmt*> prepared;
+    std::unordered_map<FunctionStmt*, MemoCache> memoCaches;
+    std::vector<FunctionStmt*> memoOrder; // For stable statistics output
+    Profiler* profiler = nullptr;
+    ExecutionProfile* recorder = nullptr;
+    ArrayHeap heap;
+    StringHeap strings;
+
+    Value lastValue;
+    bool returning = false;
+    Value returnValue;
+
+    friend class SlotResolver;
+    int globalSlot(const std::string& name);
+    void prepare(FunctionStmt* fn);
+    void step();
+    void execute(Statement* stmt);
+    Value evaluate(Expression* expr);
+    Value& load(const Slot& slot, const Token& name);
+    // Value::zero, plus a fresh empty array for array types
+    Value zeroOf(TokenType type);
+    // Frees arrays and strings not reachable from globals, the stack or the
+    // last values. C++ locals that hold an array or string while evaluating
+    // a subexpression push it on the stack so it survives collections made
+    // by nested calls.
+    void collectGarbage();
+    void flushOutput();
+    // Runs `fn` with its arguments already pushed at stack[base...]
+    Value callFunction(FunctionStmt* fn, size_t base, int line);
+    // Elementwise + - * / where at least one operand is an array
+    Value arrayArithmetic(const Token& op, const Value& left, const Value& right);
+    Value callBuiltin(CallExpr* expr);
+
+    // A parallel for is split into at most this many chunks of consecutive
+    // iterations, however many threads run them. Reductions are combined
+    // per chunk in chunk order, so results never depend on the thread count.
+    static constexpr long long kMaxChunks = 64;
+    // A fresh interpreter for one pool thread: a copy of the globals and of
+    // the current frame, sharing this one's arrays and functions
+    std::unique_ptr<Interpreter> spawnWorker() const;
+    // True if an array `loop` writes can also be reached through another
+    // variable, where the race checker could not see it
+    bool writesAliasedArray(ParallelForStmt* loop);
+    // Runs iterations [first, last) with each reduction variable starting
+    // from seeds[k], then stores its value in partials[k]
+    void runIterations(ParallelForStmt* loop, long long first, long long last, const std::vector<Value>& seeds, Value* partials);
+
+public:
+    Interpreter() : Interpreter(Limits()) {}
+    Interpreter(Limits limits, std::ostream& out = std::cout) : limits(limits), out(out) {}
+
+    // Runs a whole program
+    void run(const std::vector<std::unique_ptr<Statement>>& program);
+
+    // --snapshot: the globals after run(), in declaration order; and, in
+    // place of run(), a start from the globals a snapshot saved, without
+    // running the top-level code. Either is followed by start(main).
+    std::vector<std::pair<std::string, Value>> globalValues() const;
+    void restore(const std::vector<std::unique_ptr<Statement>>& program, const Snapshot& snapshot);
+    Value start(FunctionStmt* entry);
+
+    // Calls a single function; used for compile-time evaluation.
+    // On error the interpreter is left ready for the next call.
+    Value call(FunctionStmt* fn, std::vector<Value> args);
+
+    // Evaluates an expression that only refers to globals
+    Value evaluateConstant(Expression* expr);
+
+    // Caches the results of `fn`, which must be pure with int/bool parameters
+    void memoize(FunctionStmt* fn);
+    void printMemoStats(std::ostream& stats) const;
+
+    // Records calls and loop iterations of the next run() into `profiler`
+    void setProfiler(Profiler* p) { profiler = p; }
+    // Counts branch outcomes and calls per source position (--profile-gen)
+    void recordExecution(ExecutionProfile* p) { recorder = p; }
+
+    void setGlobal(const std::string& name, const Value& value);
+    void resetSteps() { steps = 0; }
+
+    void visitBinaryExpr(BinaryExpr* expr) override;
+    void visitGroupingExpr(GroupingExpr* expr) override;
+    void visitLiteralExpr(LiteralExpr* expr) override;
+    void visitUnaryExpr(UnaryExpr* expr) override;
+    void visitVariableExpr(VariableExpr* expr) override;
+    void visitAssignExpr(AssignExpr* expr) override;
+    void visitCallExpr(CallExpr* expr) override;
+    void visitArrayExpr(ArrayExpr* expr) override;
+    void visitIndexExpr(IndexExpr* expr) override;
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override;
+
+    void visitBlockStmt(BlockStmt* stmt) override;
+    void visitExpressionStmt(ExpressionStmt* stmt) override;
+    void visitFunctionStmt(FunctionStmt* stmt) override;
+    void visitIfStmt(IfStmt* stmt) override;
+    void visitPrintStmt(PrintStmt* stmt) override;
+    void visitReturnStmt(ReturnStmt* stmt) override;
+    void visitVarStmt(VarStmt* stmt) override;
+    void visitWhileStmt(WhileStmt* stmt) override;
+    void visitParallelForStmt(ParallelForStmt* stmt) override;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "../data/value.h"
+
+// Result cache for one memoized function: a flat open-addressing table
+// (linear probing) keyed on the argument tuple. Arguments are int or bool,
+// so a key is `arity` ints stored inline in one array.
+//
+// The table doubles while it is at most half full and stops accepting new
+// entries once it holds kMaxEntries; lookups keep working after that.
+class MemoCache {
+public:
+    static const size_t kInitialCapacity = 64;
+    static const size_t kMaxEntries = 1 << 16;
+
+    long long hits = 0;
+    long long misses = 0;
+    long long dropped = 0; // Results not stored because the cache was full
+
+private:
+    size_t arity;
+    size_t capacity = 0;
+    size_t count = 0;
+    std::vector<int> keys;     // capacity * arity
+    std::vector<Value> values;
+    std::vector<uint8_t> used;
+    std::vector<int> scratch;  // Key of the current lookup/insert
+
+    static int keyOf(const Value& v) { return v.type == TokenType::TYPE_BOOL ? (int)v.b : v.i; }
+
+    size_t hash(const int* key) const {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (size_t i = 0; i < arity; i++) {
+            h ^= (uint32_t)key[i];
+            h *= 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+        }
+        return (size_t)h;
+    }
+
+    bool matches(size_t index, const int* key) const {
+        const int* stored = &keys[index * arity];
+        for (size_t i = 0; i < arity; i++) {
+            if (stored[i] != key[i]) return false;
+        }
+        return true;
+    }
+
+    // Slot holding `key`, or the empty slot where it would go
+    size_t probe(const int* key) const {
+        size_t mask = capacity - 1;
+        size_t index = hash(key) & mask;
+        while (used[index] && !matches(index, key)) index = (index + 1) & mask;
+        return index;
+    }
+
+    void resize(size_t newCapacity) {
+        std::vector<int> oldKeys = std::move(keys);
+        std::vector<Value> oldValues = std::move(values);
+        std::vector<uint8_t> oldUsed = std::move(used);
+        size_t oldCapacity = capacity;
+
+        capacity = newCapacity;
+        keys.assign(capacity * arity, 0);
+        values.assign(capacity, Value());
+        used.assign(capacity, 0);
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (!oldUsed[i]) continue;
+            size_t index = probe(&oldKeys[i * arity]);
+            std::copy(&oldKeys[i * arity], &oldKeys[i * arity] + arity, &keys[index * arity]);
+            values[index] = oldValues[i];
+            used[index] = 1;
+        }
+    }
+
+    void makeKey(const Value* args, std::vector<int>& key) const {
+        key.resize(arity);
+        for (size_t i = 0; i < arity; i++) key[i] = keyOf(args[i]);
+    }
+
+public:
+    explicit MemoCache(size_t arity) : arity(arity) { resize(kInitialCapacity); }
+
+    size_t size() const { return count; }
+    double hitRate() const { return hits + misses == 0 ? 0.0 : (double)hits / (double)(hits + misses); }
+
+    bool lookup(const Value* args, Value& outResult) {
+        makeKey(args, scratch);
+        size_t index = probe(scratch.data());
+        if (used[index]) {
+            hits++;
+            outResult = values[index];
+            return true;
+        }
+        misses++;
+        return false;
+    }
+
+    void insert(const Value* args, const Value& result) {
+        makeKey(args, scratch);
+        insertKey(scratch.data(), result);
+    }
+
+    // Adds the entries and counters of `other`, a cache of the same function
+    // filled by another interpreter (the workers of a parallel for)
+    void absorb(const MemoCache& other) {
+        hits += other.hits;
+        misses += other.misses;
+        dropped += other.dropped;
+        for (size_t i = 0; i < other.capacity; i++) {
+            if (other.used[i]) insertKey(&other.keys[i * arity], other.values[i]);
+        }
+    }
+
+    // Same entries, counters back at zero
+    MemoCache copyEntries() const {
+        MemoCache copy = *this;
+        copy.hits = copy.misses = copy.dropped = 0;
+        return copy;
+    }
+
+private:
+    void insertKey(const int* key, const Value& result) {
+        size_t index = probe(key);
+        if (used[index]) return;
+        if (count >= kMaxEntries) {
+            dropped++;
+            return;
+        }
+        if ((count + 1) * 2 > capacity) {
+            resize(capacity * 2);
+            index = probe(key);
+        }
+        std::copy(key, key + arity, &keys[index * arity]);
+        values[index] = result;
+        used[index] = 1;
+        count++;
+    }
+};
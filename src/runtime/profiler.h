@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../data/AST.h"
+
+// Execution profile gathered by an Interpreter with a Profiler attached.
+//
+// Every executed call reads the clock twice and moves one node down a
+// calling-context tree, so there are no hash lookups on the call path.
+// Loops only report their iteration count when they finish. Calls answered
+// by a memo cache never run a body and are not counted.
+class Profiler {
+public:
+    struct FunctionProfile {
+        FunctionStmt* fn = nullptr;
+        long long calls = 0;
+        long long inclusiveNs = 0; // Outermost activations only, so recursion is not counted twice
+        long long exclusiveNs = 0;
+        int active = 0;
+    };
+
+    struct LoopProfile {
+        WhileStmt* loop = nullptr;
+        std::string function;      // Enclosing function, or "<program>"
+        long long entries = 0;
+        long long iterations = 0;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // One node per distinct call path; nodes[0] is the top-level code
+    struct Node {
+        FunctionStmt* fn = nullptr;
+        FunctionProfile* profile = nullptr;
+        int parent = -1;
+        long long selfNs = 0;
+        std::vector<std::pair<FunctionStmt*, int>> children;
+    };
+
+    struct Frame {
+        int node;
+        Clock::time_point start;
+        long long childNs = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Frame> frames;
+    std::unordered_map<FunctionStmt*, FunctionProfile> functions;
+    std::unordered_map<WhileStmt*, LoopProfile> loops;
+    long long totalNs = 0;
+
+    static long long since(Clock::time_point start, Clock::time_point now) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    }
+
+    int child(int parent, FunctionStmt* fn) {
+        for (const auto& entry : nodes[parent].children) {
+            if (entry.first == fn) return entry.second;
+        }
+        int index = (int)nodes.size();
+        nodes.emplace_back();
+        nodes.back().fn = fn;
+        nodes.back().parent = parent;
+        FunctionProfile& profile = functions[fn]; // References into the map stay valid
+        profile.fn = fn;
+        nodes.back().profile = &profile;
+        nodes[parent].children.emplace_back(fn, index);
+        return index;
+    }
+
+    std::string path(int node) const {
+        std::string result = nodes[node].fn ? nodes[node].fn->name.lexeme : "<program>";
+        for (int n = nodes[node].parent; n >= 0; n = nodes[n].parent) {
+            result = (nodes[n].fn ? nodes[n].fn->name.lexeme : "<program>") + ";" + result;
+        }
+        return result;
+    }
+
+public:
+    // Starts timing the top-level code
+    void begin() {
+        nodes.assign(1, Node());
+        frames.assign(1, Frame{0, Clock::now()});
+        functions.clear();
+        loops.clear();
+        totalNs = 0;
+    }
+
+    // Closes the top-level frame; frames left open by an error are dropped
+    void finish() {
+        if (frames.empty()) return;
+        Frame& root = frames.front();
+        totalNs = since(root.start, Clock::now());
+        nodes[0].selfNs += totalNs - root.childNs;
+        frames.clear();
+    }
+
+    void enter(FunctionStmt* fn) {
+        int node = child(frames.back().node, fn);
+        FunctionProfile* profile = nodes[node].profile;
+        profile->calls++;
+        profile->active++;
+        frames.push_back(Frame{node, Clock::now()});
+    }
+
+    void exit() {
+        Clock::time_point now = Clock::now();
+        Frame frame = frames.back();
+        frames.pop_back();
+        long long elapsed = since(frame.start, now);
+        long long self = elapsed - frame.childNs;
+        Node& node = nodes[frame.node];
+        node.selfNs += self;
+        node.profile->exclusiveNs += self;
+        if (--node.profile->active == 0) node.profile->inclusiveNs += elapsed;
+        frames.back().childNs += elapsed;
+    }
+
+    void recordLoop(WhileStmt* loop, long long iterations) {
+        LoopProfile& profile = loops[loop];
+        if (profile.entries == 0) {
+            profile.loop = loop;
+            FunctionStmt* fn = frames.empty() ? nullptr : nodes[frames.back().node].fn;
+            profile.function = fn ? fn->name.lexeme : "<program>";
+        }
+        profile.entries++;
+        profile.iterations += iterations;
+    }
+
+    // Functions by exclusive time, then loops by iteration count
+    void printReport(std::ostream& out) const {
+        std::vector<const FunctionProfile*> sorted;
+        for (const auto& entry : functions) sorted.push_back(&entry.second);
+        std::sort(sorted.begin(), sorted.end(), [](const FunctionProfile* a, const FunctionProfile* b) {
+            if (a->exclusiveNs != b->exclusiveNs) return a->exclusiveNs > b->exclusiveNs;
+            return a->fn->name.line < b->fn->name.line;
+        });
+        double total = totalNs > 0 ? (double)totalNs : 1.0;
+
+        out << "=== Profile ===" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        out << "  total " << totalNs / 1e6 << " ms, top-level code " << nodes[0].selfNs / 1e6 << " ms" << std::endl;
+        out << "  " << std::left << std::setw(16) << "function" << std::right << std::setw(12) << "calls"
+            << std::setw(12) << "incl ms" << std::setw(12) << "excl ms" << std::setw(9) << "excl %" << std::endl;
+        for (const FunctionProfile* p : sorted) {
+            out << "  " << std::left << std::setw(16) << p->fn->name.lexeme << std::right << std::setw(12) << p->calls
+                << std::setw(12) << p->inclusiveNs / 1e6 << std::setw(12) << p->exclusiveNs / 1e6
+                << std::setprecision(1) << std::setw(8) << p->exclusiveNs * 100.0 / total << "%"
+                << std::setprecision(3) << std::endl;
+        }
+
+        std::vector<const LoopProfile*> loopList;
+        for (const auto& entry : loops) loopList.push_back(&entry.second);
+        std::sort(loopList.begin(), loopList.end(), [](const LoopProfile* a, const LoopProfile* b) {
+            if (a->iterations != b->iterations) return a->iterations > b->iterations;
+            return a->loop->line < b->loop->line;
+        });
+        if (!loopList.empty()) {
+            out << "  " << std::left << std::setw(16) << "while loop" << std::right << std::setw(12) << "entries"
+                << std::setw(12) << "iterations" << std::setw(12) << "avg" << std::endl;
+            out << std::setprecision(1);
+            for (const LoopProfile* l : loopList) {
+                std::string where = "line " + std::to_string(l->loop->line) + " (" + l->function + ")";
+                out << "  " << std::left << std::setw(16) << where << std::right << std::setw(12) << l->entries
+                    << std::setw(12) << l->iterations << std::setw(12) << (double)l->iterations / l->entries << std::endl;
+            }
+        }
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+
+    // One "caller;callee self-time" line per call path, in microseconds;
+    // the format read by flamegraph.pl, inferno and speedscope.
+    void writeCollapsed(std::ostream& out) const {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            long long micros = (nodes[i].selfNs + 500) / 1000;
+            if (micros > 0) out << path((int)i) << " " << micros << "\n";
+        }
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "../data/string-node.h"
+#include "../data/value.h"
+
+// Owns every string one Interpreter builds at run time; literals live in
+// StringPool instead and are never freed.
+//
+// concat() keeps short results flat, since copying a few bytes is cheaper
+// than another node to walk, and otherwise makes a rope node that shares
+// both halves. Appending a short piece to a rope whose last piece is also
+// short merges the two, so a loop adding a character at a time builds a
+// rope of 32-byte leaves instead of one node per character.
+//
+// Collection works like ArrayHeap's, except that a rope keeps its halves
+// alive, so marking walks down into them. It stops at nodes this heap does
+// not own: those belong to the interpreter that started a parallel for, or
+// to the pool, and another thread may be marking them.
+class StringHeap {
+public:
+    static const size_t kInitialThreshold = 1 << 20;
+    static const size_t kSmallLength = 32; // Longest result concat() copies
+
+    long long collections = 0;
+
+private:
+    std::vector<StringNode*> nodes;
+    size_t bytes = 0; // Live after the last sweep + allocated since
+    size_t threshold = kInitialThreshold;
+
+    static size_t sizeOf(const StringNode* node) { return sizeof(StringNode) + node->text.capacity(); }
+
+    // Makes room before allocating, so a failed push_back cannot leak a node
+    void reserveSlot() {
+        if (nodes.size() == nodes.capacity()) nodes.reserve(nodes.size() * 2 + 16);
+    }
+
+    const StringNode* adopt(StringNode* node) {
+        node->owner = this;
+        nodes.push_back(node);
+        bytes += sizeOf(node);
+        return node;
+    }
+
+public:
+    StringHeap() = default;
+    StringHeap(const StringHeap&) = delete;
+    StringHeap& operator=(const StringHeap&) = delete;
+    ~StringHeap() {
+        for (StringNode* node : nodes) delete node;
+    }
+
+    // Throws std::bad_alloc like new
+    const StringNode* leaf(std::string text) {
+        reserveSlot();
+        return adopt(new StringNode(std::move(text)));
+    }
+
+    const StringNode* concat(const StringNode* a, const StringNode* b) {
+        if (a->length == 0) return b;
+        if (b->length == 0) return a;
+        if (a->length + b->length <= kSmallLength) return leaf(a->flatten() + b->flatten());
+        if (b->isLeaf() && !a->isLeaf() && a->right->isLeaf() && a->right->length + b->length <= kSmallLength) {
+            return concat(a->left, leaf(a->right->text + b->text));
+        }
+        reserveSlot();
+        return adopt(new StringNode(a, b));
+    }
+
+    bool wantsCollection() const { return bytes >= threshold; }
+
+    void mark(const Value& value) {
+        if (!value.str || value.str->owner != this) return;
+        std::vector<const StringNode*> pending{value.str};
+        while (!pending.empty()) {
+            const StringNode* node = pending.back();
+            pending.pop_back();
+            if (node->owner != this || node->marked) continue;
+            node->marked = true;
+            if (!node->isLeaf()) {
+                pending.push_back(node->left);
+                pending.push_back(node->right);
+            }
+        }
+    }
+
+    // Frees every string that was not marked since the last sweep
+    void sweep() {
+        size_t kept = 0;
+        bytes = 0;
+        for (StringNode* node : nodes) {
+            if (!node->marked) {
+                delete node;
+                continue;
+            }
+            node->marked = false;
+            bytes += sizeOf(node);
+            nodes[kept++] = node;
+        }
+        nodes.resize(kept);
+        threshold = bytes * 2 > kInitialThreshold ? bytes * 2 : kInitialThreshold;
+        collections++;
+    }
+};
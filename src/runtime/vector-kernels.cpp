@@ -0,0 +1,376 @@
+#include "vector-kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NANOC_X86_KERNELS 1
+#include <immintrin.h>
+#define NANOC_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+// --- Scalar ---
+
+inline int addWrap(int a, int b) { return (int)((unsigned)a + (unsigned)b); }
+inline int subWrap(int a, int b) { return (int)((unsigned)a - (unsigned)b); }
+inline int mulWrap(int a, int b) { return (int)((unsigned)a * (unsigned)b); }
+inline double add(double a, double b) { return a + b; }
+inline double sub(double a, double b) { return a - b; }
+inline double mul(double a, double b) { return a * b; }
+inline double div(double a, double b) { return a / b; }
+// Same NaN behaviour as minpd/maxpd: the second operand wins unless the comparison holds
+inline double minOf(double a, double b) { return a < b ? a : b; }
+inline double maxOf(double a, double b) { return a > b ? a : b; }
+
+template <int (*Op)(int, int)>
+void elementwiseInt(const int* a, const int* b, int* out, size_t n) {
+    for (size_t k = 0; k < n; k++) out[k] = Op(a[k], b[k]);
+}
+
+template <double (*Op)(double, double)>
+void elementwiseFloat(const double* a, const double* b, double* out, size_t n) {
+    for (size_t k = 0; k < n; k++) out[k] = Op(a[k], b[k]);
+}
+
+// The reduction order every table follows: lanes seeded with the first four
+// elements, folded four at a time, combined pairwise, then the tail.
+template <double (*Op)(double, double)>
+double reduceFloat(const double* a, size_t n) {
+    if (n < 4) {
+        double result = a[0];
+        for (size_t k = 1; k < n; k++) result = Op(result, a[k]);
+        return result;
+    }
+    double lane[4] = {a[0], a[1], a[2], a[3]};
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        for (int j = 0; j < 4; j++) lane[j] = Op(lane[j], a[k + j]);
+    }
+    double result = Op(Op(lane[0], lane[1]), Op(lane[2], lane[3]));
+    for (; k < n; k++) result = Op(result, a[k]);
+    return result;
+}
+
+double sumFloatScalar(const double* a, size_t n) { return n == 0 ? 0.0 : reduceFloat<add>(a, n); }
+double minFloatScalar(const double* a, size_t n) { return reduceFloat<minOf>(a, n); }
+double maxFloatScalar(const double* a, size_t n) { return reduceFloat<maxOf>(a, n); }
+
+double dotFloatScalar(const double* a, const double* b, size_t n) {
+    if (n < 4) {
+        double result = 0.0;
+        for (size_t k = 0; k < n; k++) result += a[k] * b[k];
+        return result;
+    }
+    double lane[4] = {a[0] * b[0], a[1] * b[1], a[2] * b[2], a[3] * b[3]};
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        for (int j = 0; j < 4; j++) lane[j] += a[k + j] * b[k + j];
+    }
+    double result = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; k < n; k++) result += a[k] * b[k];
+    return result;
+}
+
+// Wrapping int sums are associative, so int reductions need no fixed order
+int sumIntScalar(const int* a, size_t n) {
+    int sum = 0;
+    for (size_t k = 0; k < n; k++) sum = addWrap(sum, a[k]);
+    return sum;
+}
+
+int dotIntScalar(const int* a, const int* b, size_t n) {
+    int sum = 0;
+    for (size_t k = 0; k < n; k++) sum = addWrap(sum, mulWrap(a[k], b[k]));
+    return sum;
+}
+
+int minIntScalar(const int* a, size_t n) {
+    int m = a[0];
+    for (size_t k = 1; k < n; k++) m = a[k] < m ? a[k] : m;
+    return m;
+}
+
+int maxIntScalar(const int* a, size_t n) {
+    int m = a[0];
+    for (size_t k = 1; k < n; k++) m = a[k] > m ? a[k] : m;
+    return m;
+}
+
+const VectorKernels scalarKernels = {
+    "scalar",
+    elementwiseInt<addWrap>, elementwiseInt<subWrap>, elementwiseInt<mulWrap>,
+    elementwiseFloat<add>, elementwiseFloat<sub>, elementwiseFloat<mul>, elementwiseFloat<div>,
+    sumIntScalar, sumFloatScalar, dotIntScalar, dotFloatScalar,
+    minIntScalar, maxIntScalar, minFloatScalar, maxFloatScalar,
+};
+
+#ifdef NANOC_X86_KERNELS
+
+// --- SSE2 (baseline on x86-64): 2 doubles or 4 ints per register ---
+
+#define SSE2_ELEMENTWISE_PD(name, intrinsic, scalar)                                              \
+    void name(const double* a, const double* b, double* out, size_t n) {                          \
+        size_t k = 0;                                                                             \
+        for (; k + 2 <= n; k += 2) _mm_store_pd(out + k, intrinsic(_mm_load_pd(a + k), _mm_load_pd(b + k))); \
+        for (; k < n; k++) out[k] = scalar(a[k], b[k]);                                           \
+    }
+
+#define SSE2_ELEMENTWISE_EPI32(name, intrinsic, scalar)                                           \
+    void name(const int* a, const int* b, int* out, size_t n) {                                   \
+        size_t k = 0;                                                                             \
+        for (; k + 4 <= n; k += 4) {                                                              \
+            __m128i x = _mm_load_si128((const __m128i*)(a + k));                                  \
+            __m128i y = _mm_load_si128((const __m128i*)(b + k));                                  \
+            _mm_store_si128((__m128i*)(out + k), intrinsic(x, y));                                \
+        }                                                                                         \
+        for (; k < n; k++) out[k] = scalar(a[k], b[k]);                                           \
+    }
+
+SSE2_ELEMENTWISE_PD(addFloatSse2, _mm_add_pd, add)
+SSE2_ELEMENTWISE_PD(subFloatSse2, _mm_sub_pd, sub)
+SSE2_ELEMENTWISE_PD(mulFloatSse2, _mm_mul_pd, mul)
+SSE2_ELEMENTWISE_PD(divFloatSse2, _mm_div_pd, div)
+SSE2_ELEMENTWISE_EPI32(addIntSse2, _mm_add_epi32, addWrap)
+SSE2_ELEMENTWISE_EPI32(subIntSse2, _mm_sub_epi32, subWrap)
+
+// Four float lanes as two registers (lanes 0-1 and 2-3)
+#define SSE2_REDUCE_PD(name, intrinsic, scalar)                                                   \
+    double name(const double* a, size_t n) {                                                      \
+        if (n < 4) return reduceFloat<scalar>(a, n);                                              \
+        __m128d low = _mm_load_pd(a), high = _mm_load_pd(a + 2);                                  \
+        size_t k = 4;                                                                             \
+        for (; k + 4 <= n; k += 4) {                                                              \
+            low = intrinsic(low, _mm_load_pd(a + k));                                             \
+            high = intrinsic(high, _mm_load_pd(a + k + 2));                                       \
+        }                                                                                         \
+        alignas(16) double lane[4];                                                               \
+        _mm_store_pd(lane, low);                                                                  \
+        _mm_store_pd(lane + 2, high);                                                             \
+        double result = scalar(scalar(lane[0], lane[1]), scalar(lane[2], lane[3]));               \
+        for (; k < n; k++) result = scalar(result, a[k]);                                         \
+        return result;                                                                            \
+    }
+
+SSE2_REDUCE_PD(reduceAddSse2, _mm_add_pd, add)
+SSE2_REDUCE_PD(minFloatSse2, _mm_min_pd, minOf)
+SSE2_REDUCE_PD(maxFloatSse2, _mm_max_pd, maxOf)
+
+double sumFloatSse2(const double* a, size_t n) { return n == 0 ? 0.0 : reduceAddSse2(a, n); }
+
+double dotFloatSse2(const double* a, const double* b, size_t n) {
+    if (n < 4) return dotFloatScalar(a, b, n);
+    __m128d low = _mm_mul_pd(_mm_load_pd(a), _mm_load_pd(b));
+    __m128d high = _mm_mul_pd(_mm_load_pd(a + 2), _mm_load_pd(b + 2));
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        low = _mm_add_pd(low, _mm_mul_pd(_mm_load_pd(a + k), _mm_load_pd(b + k)));
+        high = _mm_add_pd(high, _mm_mul_pd(_mm_load_pd(a + k + 2), _mm_load_pd(b + k + 2)));
+    }
+    alignas(16) double lane[4];
+    _mm_store_pd(lane, low);
+    _mm_store_pd(lane + 2, high);
+    double result = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; k < n; k++) result += a[k] * b[k];
+    return result;
+}
+
+int sumIntSse2(const int* a, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) acc = _mm_add_epi32(acc, _mm_load_si128((const __m128i*)(a + k)));
+    alignas(16) int lane[4];
+    _mm_store_si128((__m128i*)lane, acc);
+    int sum = addWrap(addWrap(lane[0], lane[1]), addWrap(lane[2], lane[3]));
+    for (; k < n; k++) sum = addWrap(sum, a[k]);
+    return sum;
+}
+
+// SSE2 has no pminsd/pmaxsd; select through a compare mask
+inline __m128i select(__m128i mask, __m128i ifSet, __m128i ifClear) {
+    return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+}
+
+int minIntSse2(const int* a, size_t n) {
+    if (n < 4) return minIntScalar(a, n);
+    __m128i acc = _mm_load_si128((const __m128i*)a);
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        __m128i x = _mm_load_si128((const __m128i*)(a + k));
+        acc = select(_mm_cmplt_epi32(x, acc), x, acc);
+    }
+    alignas(16) int lane[4];
+    _mm_store_si128((__m128i*)lane, acc);
+    int m = minIntScalar(lane, 4);
+    for (; k < n; k++) m = a[k] < m ? a[k] : m;
+    return m;
+}
+
+int maxIntSse2(const int* a, size_t n) {
+    if (n < 4) return maxIntScalar(a, n);
+    __m128i acc = _mm_load_si128((const __m128i*)a);
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        __m128i x = _mm_load_si128((const __m128i*)(a + k));
+        acc = select(_mm_cmpgt_epi32(x, acc), x, acc);
+    }
+    alignas(16) int lane[4];
+    _mm_store_si128((__m128i*)lane, acc);
+    int m = maxIntScalar(lane, 4);
+    for (; k < n; k++) m = a[k] > m ? a[k] : m;
+    return m;
+}
+
+const VectorKernels sse2Kernels = {
+    "sse2",
+    addIntSse2, subIntSse2, elementwiseInt<mulWrap>, // No 32-bit multiply before SSE4.1
+    addFloatSse2, subFloatSse2, mulFloatSse2, divFloatSse2,
+    sumIntSse2, sumFloatSse2, dotIntScalar, dotFloatSse2,
+    minIntSse2, maxIntSse2, minFloatSse2, maxFloatSse2,
+};
+
+// --- AVX2: 4 doubles or 8 ints per register ---
+
+#define AVX2_ELEMENTWISE_PD(name, intrinsic, scalar)                                              \
+    NANOC_AVX2 void name(const double* a, const double* b, double* out, size_t n) {               \
+        size_t k = 0;                                                                             \
+        for (; k + 4 <= n; k += 4) {                                                              \
+            _mm256_store_pd(out + k, intrinsic(_mm256_load_pd(a + k), _mm256_load_pd(b + k)));    \
+        }                                                                                         \
+        for (; k < n; k++) out[k] = scalar(a[k], b[k]);                                           \
+    }
+
+#define AVX2_ELEMENTWISE_EPI32(name, intrinsic, scalar)                                           \
+    NANOC_AVX2 void name(const int* a, const int* b, int* out, size_t n) {                        \
+        size_t k = 0;                                                                             \
+        for (; k + 8 <= n; k += 8) {                                                              \
+            __m256i x = _mm256_load_si256((const __m256i*)(a + k));                               \
+            __m256i y = _mm256_load_si256((const __m256i*)(b + k));                               \
+            _mm256_store_si256((__m256i*)(out + k), intrinsic(x, y));                             \
+        }                                                                                         \
+        for (; k < n; k++) out[k] = scalar(a[k], b[k]);                                           \
+    }
+
+AVX2_ELEMENTWISE_PD(addFloatAvx2, _mm256_add_pd, add)
+AVX2_ELEMENTWISE_PD(subFloatAvx2, _mm256_sub_pd, sub)
+AVX2_ELEMENTWISE_PD(mulFloatAvx2, _mm256_mul_pd, mul)
+AVX2_ELEMENTWISE_PD(divFloatAvx2, _mm256_div_pd, div)
+AVX2_ELEMENTWISE_EPI32(addIntAvx2, _mm256_add_epi32, addWrap)
+AVX2_ELEMENTWISE_EPI32(subIntAvx2, _mm256_sub_epi32, subWrap)
+AVX2_ELEMENTWISE_EPI32(mulIntAvx2, _mm256_mullo_epi32, mulWrap)
+
+#define AVX2_REDUCE_PD(name, intrinsic, scalar)                                                   \
+    NANOC_AVX2 double name(const double* a, size_t n) {                                           \
+        if (n < 4) return reduceFloat<scalar>(a, n);                                              \
+        __m256d acc = _mm256_load_pd(a);                                                          \
+        size_t k = 4;                                                                             \
+        for (; k + 4 <= n; k += 4) acc = intrinsic(acc, _mm256_load_pd(a + k));                  \
+        alignas(32) double lane[4];                                                               \
+        _mm256_store_pd(lane, acc);                                                               \
+        double result = scalar(scalar(lane[0], lane[1]), scalar(lane[2], lane[3]));               \
+        for (; k < n; k++) result = scalar(result, a[k]);                                         \
+        return result;                                                                            \
+    }
+
+AVX2_REDUCE_PD(reduceAddAvx2, _mm256_add_pd, add)
+AVX2_REDUCE_PD(minFloatAvx2, _mm256_min_pd, minOf)
+AVX2_REDUCE_PD(maxFloatAvx2, _mm256_max_pd, maxOf)
+
+double sumFloatAvx2(const double* a, size_t n) { return n == 0 ? 0.0 : reduceAddAvx2(a, n); }
+
+NANOC_AVX2 double dotFloatAvx2(const double* a, const double* b, size_t n) {
+    if (n < 4) return dotFloatScalar(a, b, n);
+    __m256d acc = _mm256_mul_pd(_mm256_load_pd(a), _mm256_load_pd(b));
+    size_t k = 4;
+    for (; k + 4 <= n; k += 4) {
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_load_pd(a + k), _mm256_load_pd(b + k)));
+    }
+    alignas(32) double lane[4];
+    _mm256_store_pd(lane, acc);
+    double result = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; k < n; k++) result += a[k] * b[k];
+    return result;
+}
+
+#define AVX2_REDUCE_EPI32(name, intrinsic, scalar, pair)                                          \
+    NANOC_AVX2 int name(const int* a, size_t n) {                                                 \
+        if (n < 8) return scalar(a, n);                                                           \
+        __m256i acc = _mm256_load_si256((const __m256i*)a);                                       \
+        size_t k = 8;                                                                             \
+        for (; k + 8 <= n; k += 8) acc = intrinsic(acc, _mm256_load_si256((const __m256i*)(a + k))); \
+        alignas(32) int lane[8];                                                                  \
+        _mm256_store_si256((__m256i*)lane, acc);                                                  \
+        int result = scalar(lane, 8);                                                             \
+        for (; k < n; k++) result = pair(result, a[k]);                                           \
+        return result;                                                                            \
+    }
+
+inline int minPair(int a, int b) { return a < b ? a : b; }
+inline int maxPair(int a, int b) { return a > b ? a : b; }
+
+AVX2_REDUCE_EPI32(sumIntAvx2, _mm256_add_epi32, sumIntScalar, addWrap)
+AVX2_REDUCE_EPI32(minIntAvx2, _mm256_min_epi32, minIntScalar, minPair)
+AVX2_REDUCE_EPI32(maxIntAvx2, _mm256_max_epi32, maxIntScalar, maxPair)
+
+NANOC_AVX2 int dotIntAvx2(const int* a, const int* b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i x = _mm256_load_si256((const __m256i*)(a + k));
+        __m256i y = _mm256_load_si256((const __m256i*)(b + k));
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(x, y));
+    }
+    alignas(32) int lane[8];
+    _mm256_store_si256((__m256i*)lane, acc);
+    return addWrap(sumIntScalar(lane, 8), dotIntScalar(a + k, b + k, n - k));
+}
+
+const VectorKernels avx2Kernels = {
+    "avx2",
+    addIntAvx2, subIntAvx2, mulIntAvx2,
+    addFloatAvx2, subFloatAvx2, mulFloatAvx2, divFloatAvx2,
+    sumIntAvx2, sumFloatAvx2, dotIntAvx2, dotFloatAvx2,
+    minIntAvx2, maxIntAvx2, minFloatAvx2, maxFloatAvx2,
+};
+
+bool hasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // NANOC_X86_KERNELS
+
+const VectorKernels& automatic() {
+#ifdef NANOC_X86_KERNELS
+    return hasAvx2() ? avx2Kernels : sse2Kernels;
+#else
+    return scalarKernels;
+#endif
+}
+
+// Set on first use; select() may replace it before a program runs
+const VectorKernels*& chosen() {
+    static const VectorKernels* kernels = &automatic();
+    return kernels;
+}
+
+} // namespace
+
+const VectorKernels& VectorKernels::active() {
+    return *chosen();
+}
+
+bool VectorKernels::select(const std::string& level) {
+    if (level == "auto") {
+        chosen() = &automatic();
+    } else if (level == "scalar") {
+        chosen() = &scalarKernels;
+#ifdef NANOC_X86_KERNELS
+    } else if (level == "sse2") {
+        chosen() = &sse2Kernels;
+    } else if (level == "avx2" && hasAvx2()) {
+        chosen() = &avx2Kernels;
+#endif
+    } else {
+        return false;
+    }
+    return true;
+}
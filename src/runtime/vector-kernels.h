@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Bulk array operations behind the elementwise operators and the sum, dot,
+// min and max builtins.
+//
+// There is one table of kernels per instruction set: "avx2" and "sse2" on
+// x86-64, and a portable "scalar" one. active() picks the best table the
+// CPU supports the first time it is used. Pointers must come from an
+// ArrayBuffer (32-byte aligned).
+//
+// Float reductions keep four partial results, one per lane of a 4-wide
+// vector, and combine them as (l0 + l1) + (l2 + l3) before adding the
+// leftover elements in order. Every table uses that same order, so results
+// do not depend on the instruction set. Int arithmetic wraps at 32 bits.
+struct VectorKernels {
+    const char* name;
+
+    void (*addInt)(const int* a, const int* b, int* out, size_t n);
+    void (*subInt)(const int* a, const int* b, int* out, size_t n);
+    void (*mulInt)(const int* a, const int* b, int* out, size_t n);
+    void (*addFloat)(const double* a, const double* b, double* out, size_t n);
+    void (*subFloat)(const double* a, const double* b, double* out, size_t n);
+    void (*mulFloat)(const double* a, const double* b, double* out, size_t n);
+    void (*divFloat)(const double* a, const double* b, double* out, size_t n);
+
+    int (*sumInt)(const int* a, size_t n);
+    double (*sumFloat)(const double* a, size_t n);
+    int (*dotInt)(const int* a, const int* b, size_t n);
+    double (*dotFloat)(const double* a, const double* b, size_t n);
+
+    // n must be at least 1
+    int (*minInt)(const int* a, size_t n);
+    int (*maxInt)(const int* a, size_t n);
+    double (*minFloat)(const double* a, size_t n);
+    double (*maxFloat)(const double* a, size_t n);
+
+    static const VectorKernels& active();
+
+    // Forces "avx2", "sse2" or "scalar", or goes back to the automatic
+    // choice with "auto". Returns false if this CPU lacks the level.
+    static bool select(const std::string& level);
+};
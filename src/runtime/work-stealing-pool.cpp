@@ -0,0 +1,112 @@
+#include "work-stealing-pool.h"
+#include <algorithm>
+
+namespace {
+
+thread_local bool inWorker = false;
+unsigned configuredSize = 0; // 0: one participant per core
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned participants) {
+    participants = std::max(participants, 1u);
+    for (unsigned k = 0; k < participants; k++) queues.push_back(std::make_unique<Queue>());
+    for (unsigned k = 1; k < participants; k++) threads.emplace_back(&WorkStealingPool::threadMain, this, k);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+WorkStealingPool& WorkStealingPool::shared() {
+    static WorkStealingPool pool(configuredSize > 0 ? configuredSize : std::max(std::thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+void WorkStealingPool::configure(unsigned participants) {
+    configuredSize = participants;
+}
+
+bool WorkStealingPool::insideWorker() {
+    return inWorker;
+}
+
+void WorkStealingPool::run(size_t chunks, const Task& task) {
+    std::lock_guard<std::mutex> serial(runMutex);
+    if (chunks == 0) return;
+
+    // Contiguous blocks, the first `extra` participants taking one more
+    size_t per = chunks / size();
+    size_t extra = chunks % size();
+    size_t next = 0;
+    for (unsigned k = 0; k < size(); k++) {
+        size_t count = per + (k < extra ? 1 : 0);
+        std::lock_guard<std::mutex> lock(queues[k]->mutex);
+        for (size_t c = 0; c < count; c++) queues[k]->chunks.push_back(next++);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        busy = (unsigned)threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    inWorker = true;
+    work(0);
+    inWorker = false;
+
+    // Stolen chunks may still be running on other threads
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy == 0; });
+    this->task = nullptr;
+}
+
+bool WorkStealingPool::take(unsigned worker, size_t& chunk) {
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chunks.empty()) {
+            chunk = own.chunks.back();
+            own.chunks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned k = 1; k < size(); k++) {
+        Queue& victim = *queues[(worker + k) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(unsigned worker) {
+    size_t chunk;
+    while (take(worker, chunk)) (*task)(worker, chunk);
+}
+
+void WorkStealingPool::threadMain(unsigned worker) {
+    inWorker = true;
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+
+        lock.unlock();
+        work(worker);
+        lock.lock();
+        if (--busy == 0) done.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads that run the chunks of a parallel for.
+//
+// run() hands every participant (the calling thread is participant 0) a
+// contiguous block of chunk indices in its own deque. A participant takes
+// work from the back of its deque; once it is empty it steals from the
+// front of the others', so a block of slow chunks is shared out instead of
+// leaving the rest of the pool idle. run() returns when every chunk is done.
+//
+// Chunks are claimed one at a time under a per-deque mutex: a parallel for
+// makes at most a few dozen chunks, each running many iterations, so the
+// locks are never the bottleneck.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned worker, size_t chunk)>;
+
+    explicit WorkStealingPool(unsigned participants);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Threads that run chunks, the caller of run() included
+    unsigned size() const { return (unsigned)queues.size(); }
+
+    // Calls task(worker, chunk) once for each chunk in [0, chunks), with
+    // `worker` < size(). `task` must not throw. Not reentrant: a task that
+    // needs parallelism of its own must run it inline (see insideWorker()).
+    void run(size_t chunks, const Task& task);
+
+    // The pool shared by all interpreters, created on first use
+    static WorkStealingPool& shared();
+    // Sets the size of the shared pool; no effect once it exists
+    static void configure(unsigned participants);
+    // True on pool threads, and on the caller while run() is in progress
+    static bool insideWorker();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> chunks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per participant
+    std::vector<std::thread> threads;           // Participants 1..n-1
+
+    std::mutex runMutex; // Serializes run()
+    std::mutex mutex;    // Guards the fields below
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Task* task = nullptr;
+    unsigned long long generation = 0;
+    unsigned busy = 0; // Threads still working on the current generation
+    bool stopping = false;
+
+    bool take(unsigned worker, size_t& chunk);
+    void work(unsigned worker);
+    void threadMain(unsigned worker);
+};
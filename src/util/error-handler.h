@@ -1,19 +1,165 @@
 #pragma once
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <tuple>
+#include <vector>
+#include "../data/token.h"
 
+// One reported problem. Columns are 1-based; 0 means "unknown". `file` is
+// empty for the script named on the command line and names the module
+// otherwise.
+struct Diagnostic {
+    std::string file;
+    int line = 0;
+    int column = 0;
+    int length = 0;
+    std::string message;
+};
+
+// Collects diagnostics in a buffer and prints them in one batch on flush().
+//
+// Exact repeats (same position and message) are dropped, since one bad
+// declaration tends to produce the same error at every use. With a
+// maxErrors limit, errors past the limit are only counted and
+// limitReached() tells the scanner and parser to stop early.
+//
+// Errors are attributed to the file of the innermost FileScope on the
+// reporting thread, so modules can be compiled on several threads at once.
 class ErrorHandler {
 public:
+    enum class Format { TEXT, JSON };
+
+    class FileScope {
+    public:
+        explicit FileScope(const std::string& file) : saved(currentFile) { currentFile = file; }
+        ~FileScope() { currentFile = saved; }
+        FileScope(const FileScope&) = delete;
+        FileScope& operator=(const FileScope&) = delete;
+
+    private:
+        std::string saved;
+    };
+
     static bool hadError;
+    static inline int maxErrors = 0; // 0 = no limit
+    static inline Format format = Format::TEXT;
+
+private:
+    static inline std::mutex mutex;
+    static inline std::vector<Diagnostic> diagnostics;
+    static inline std::set<std::tuple<std::string, int, int, std::string>> seen;
+    static inline std::set<std::string> filesWithErrors;
+    static inline thread_local std::string currentFile;
+    static inline int errorCount = 0;     // Distinct errors, including ones past the limit
+    static inline int storedCount = 0;    // Errors that made it into the buffer
+    static inline int droppedReported = 0;
 
+    static std::string jsonEscape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (c == '\n') {
+                out += "\\n";
+                continue;
+            }
+            out += c;
+        }
+        return out;
+    }
+
+public:
     static void error(int line, const std::string& message) {
         report(line, "", message);
     }
 
-    static void report(int line, const std::string& where, const std::string& message) {
-        std::cerr << "[line " << line << "] Error" << where << ": " << message << std::endl;
+    static void error(const Token& token, const std::string& message) {
+        error(token.line, token.column, (int)token.lexeme.size(), message);
+    }
+
+    static void error(int line, int column, int length, const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex);
         hadError = true;
+        filesWithErrors.insert(currentFile);
+        if (!seen.insert(std::make_tuple(currentFile, line, column, message)).second) return;
+        errorCount++;
+        if (maxErrors > 0 && storedCount >= maxErrors) return;
+        diagnostics.push_back({currentFile, line, column, length, message});
+        storedCount++;
+    }
+
+    static void report(int line, const std::string& where, const std::string& message) {
+        error(line, 0, 0, where.empty() ? message : where + ": " + message);
+    }
+
+    // True if an error was reported in `file` ("" for the main script)
+    static bool hadErrorIn(const std::string& file) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return filesWithErrors.count(file) > 0;
+    }
+
+    static bool limitReached() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return maxErrors > 0 && errorCount >= maxErrors;
+    }
+
+    // Prints and clears the buffered diagnostics with a single write.
+    // In JSON mode each non-empty flush is one object on its own line.
+    static void flush(std::ostream& out = std::cerr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int dropped = errorCount - storedCount - droppedReported;
+        if (diagnostics.empty() && dropped == 0) return;
+        bool atLimit = maxErrors > 0 && errorCount >= maxErrors;
+        // Modules compiled in parallel report in any order; keep each file's together
+        std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                         [](const Diagnostic& a, const Diagnostic& b) { return a.file < b.file; });
+
+        std::ostringstream text;
+        if (format == Format::JSON) {
+            text << "{\"diagnostics\": [";
+            for (size_t i = 0; i < diagnostics.size(); i++) {
+                const Diagnostic& d = diagnostics[i];
+                text << (i ? ", " : "") << "{\"severity\": \"error\", ";
+                if (!d.file.empty()) text << "\"file\": \"" << jsonEscape(d.file) << "\", ";
+                text << "\"line\": " << d.line << ", \"column\": " << d.column
+                     << ", \"length\": " << d.length << ", \"message\": \"" << jsonEscape(d.message) << "\"}";
+            }
+            text << "], \"error_count\": " << errorCount << ", \"suppressed\": " << dropped
+                 << ", \"limit_reached\": " << (atLimit ? "true" : "false") << "}\n";
+        } else {
+            for (const Diagnostic& d : diagnostics) {
+                text << "[";
+                if (!d.file.empty()) text << d.file << " ";
+                text << "line " << d.line;
+                if (d.column > 0) text << ":" << d.column;
+                text << "] Error: " << d.message << '\n';
+            }
+            if (dropped > 0) {
+                text << "Too many errors; " << dropped << " more not shown (--max-errors=" << maxErrors << ").\n";
+            } else if (atLimit) {
+                text << "Stopping after " << maxErrors << " errors (--max-errors=" << maxErrors << ").\n";
+            }
+        }
+        out << text.str();
+        out.flush();
+        diagnostics.clear();
+        droppedReported += dropped;
+    }
+
+    // Forgets everything; for tools that compile many programs
+    static void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        hadError = false;
+        diagnostics.clear();
+        seen.clear();
+        filesWithErrors.clear();
+        errorCount = 0;
+        storedCount = 0;
+        droppedReported = 0;
     }
 };
 
-inline bool ErrorHandler::hadError = false;
\ No newline at end of file
+inline bool ErrorHandler::hadError = false;
@@ -0,0 +1,156 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+// Command line options for the compiler driver.
+struct CompilerOptions {
+    std::string scriptPath;
+
+    bool optimize = false;   // -O: run the AST-level optimizations
+    bool dumpIR = false;     // --dump-ir: print the optimized SSA IR
+    bool dumpTypedAST = false; // --dump-typed-ast: print the AST with each expression's type
+    bool timePasses = false; // --time-passes: report time spent in each IR pass
+    bool run = false;        // --run: execute the program after compiling it
+    bool memoize = true;     // --no-memo: disable result caching of pure recursive functions
+    bool memoStats = false;  // --memo-stats: report cache sizes and hit rates after --run
+    bool stats = false;      // --stats[=json]: per-phase time, allocations and memory
+    bool statsJson = false;
+    std::string tracePath;   // --trace[=file]: write a Chrome trace-event file
+    std::string profilePath; // --profile[=file]: run with the profiler, write collapsed stacks
+    std::string profileGenPath; // --profile-gen[=file]: run and record branch/call counts
+    std::string profileUsePath; // --profile-use[=file]: optimize with recorded counts
+    std::string snapshotPath; // --snapshot=file: run main() from the globals saved after the top-level code
+    bool lazy = false;       // --lazy: parse and check function bodies only once a call reaches them
+    bool strict = false;     // --strict: parse and check every body (overrides --lazy)
+    int maxErrors = 0;       // --max-errors=N: stop scanning/parsing after N errors (0 = no limit)
+    bool diagnosticsJson = false; // --diagnostics=json: machine-readable errors
+    std::string simd = "auto"; // --simd=auto|avx2|sse2|scalar: kernels for array operations
+    int threads = 0;         // --threads=N: threads running parallel for loops (0 = one per core)
+    std::string moduleCache; // --module-cache=DIR: keep imported modules' interfaces between builds
+
+    static void printUsage() {
+        std::cout << "Usage: nanoc [options] <script>" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  -O               Enable AST-level optimizations" << std::endl;
+        std::cout << "  --dump-ir        Print the optimized SSA IR" << std::endl;
+        std::cout << "  --dump-typed-ast Print the AST with each expression's type (after -O)" << std::endl;
+        std::cout << "  --time-passes    Report time spent in each IR pass" << std::endl;
+        std::cout << "  --run            Execute the program after compiling it" << std::endl;
+        std::cout << "  --no-memo        Do not cache results of pure recursive functions" << std::endl;
+        std::cout << "  --memo-stats     Report memoization cache statistics (with --run)" << std::endl;
+        std::cout << "  --stats[=json]   Report time, allocations and memory per phase" << std::endl;
+        std::cout << "  --trace[=file]   Write compiler spans to a Chrome trace (default trace.json)" << std::endl;
+        std::cout << "  --profile[=file] Run with the profiler; write collapsed stacks (default profile.folded)" << std::endl;
+        std::cout << "  --profile-gen[=f] Run and record branch and call counts (default default.nsprof)" << std::endl;
+        std::cout << "  --profile-use[=f] Optimize (-O) using recorded counts (default default.nsprof)" << std::endl;
+        std::cout << "  --lazy           Parse and check a function body only when a call reaches it" << std::endl;
+        std::cout << "  --strict         Parse and check every function body (default; overrides --lazy)" << std::endl;
+        std::cout << "  --snapshot=F     Run main() from the globals saved in F after the top-level code ran" << std::endl;
+        std::cout << "  --max-errors=N   Stop after N errors (default: no limit)" << std::endl;
+        std::cout << "  --diagnostics=F  Error format: text (default) or json" << std::endl;
+        std::cout << "  --simd=LEVEL     Array kernels: auto (default), avx2, sse2 or scalar" << std::endl;
+        std::cout << "  --threads=N      Threads for parallel for loops (default: one per core)" << std::endl;
+        std::cout << "  --module-cache=D Cache module interfaces in D; unchanged modules are not re-checked" << std::endl;
+    }
+
+    // Returns false (after printing a message) if the arguments are invalid.
+    bool parse(int argc, char* argv[]) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-O") {
+                optimize = true;
+            } else if (arg == "--dump-ir") {
+                dumpIR = true;
+            } else if (arg == "--dump-typed-ast") {
+                dumpTypedAST = true;
+            } else if (arg == "--time-passes") {
+                timePasses = true;
+            } else if (arg == "--run") {
+                run = true;
+            } else if (arg == "--no-memo") {
+                memoize = false;
+            } else if (arg == "--memo-stats") {
+                memoStats = true;
+            } else if (arg == "--stats" || arg == "--stats=text") {
+                stats = true;
+            } else if (arg == "--stats=json") {
+                stats = true;
+                statsJson = true;
+            } else if (arg == "--trace") {
+                tracePath = "trace.json";
+            } else if (arg.rfind("--trace=", 0) == 0 && arg.size() > 8) {
+                tracePath = arg.substr(8);
+            } else if (arg == "--profile") {
+                run = true;
+                profilePath = "profile.folded";
+            } else if (arg.rfind("--profile=", 0) == 0 && arg.size() > 10) {
+                run = true;
+                profilePath = arg.substr(10);
+            } else if (arg == "--profile-gen") {
+                run = true;
+                profileGenPath = "default.nsprof";
+            } else if (arg.rfind("--profile-gen=", 0) == 0 && arg.size() > 14) {
+                run = true;
+                profileGenPath = arg.substr(14);
+            } else if (arg == "--profile-use") {
+                optimize = true;
+                profileUsePath = "default.nsprof";
+            } else if (arg.rfind("--profile-use=", 0) == 0 && arg.size() > 14) {
+                optimize = true;
+                profileUsePath = arg.substr(14);
+            } else if (arg.rfind("--snapshot=", 0) == 0 && arg.size() > 11) {
+                run = true;
+                snapshotPath = arg.substr(11);
+            } else if (arg == "--lazy") {
+                lazy = true;
+            } else if (arg == "--strict") {
+                strict = true;
+            } else if (arg.rfind("--max-errors=", 0) == 0) {
+                std::string value = arg.substr(13);
+                if (value.empty() || value.size() > 9 || value.find_first_not_of("0123456789") != std::string::npos) {
+                    std::cerr << "Invalid error limit: " << arg << std::endl;
+                    return false;
+                }
+                maxErrors = std::stoi(value);
+            } else if (arg == "--diagnostics=json" || arg == "--diagnostics=text") {
+                diagnosticsJson = arg == "--diagnostics=json";
+            } else if (arg.rfind("--simd=", 0) == 0) {
+                simd = arg.substr(7);
+                if (simd != "auto" && simd != "avx2" && simd != "sse2" && simd != "scalar") {
+                    std::cerr << "Unknown SIMD level: " << simd << std::endl;
+                    return false;
+                }
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                std::string value = arg.substr(10);
+                if (value.empty() || value.size() > 4 || value.find_first_not_of("0123456789") != std::string::npos ||
+                    std::stoi(value) == 0) {
+                    std::cerr << "Invalid thread count: " << arg << std::endl;
+                    return false;
+                }
+                threads = std::stoi(value);
+            } else if (arg.rfind("--module-cache=", 0) == 0 && arg.size() > 15) {
+                moduleCache = arg.substr(15);
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            } else if (scriptPath.empty()) {
+                scriptPath = arg;
+            } else {
+                std::cerr << "Only one script can be compiled at a time." << std::endl;
+                return false;
+            }
+        }
+        if (!profileGenPath.empty() && !profileUsePath.empty()) {
+            std::cerr << "--profile-gen and --profile-use cannot be combined." << std::endl;
+            return false;
+        }
+        if (!snapshotPath.empty() && (!profilePath.empty() || !profileGenPath.empty())) {
+            std::cerr << "--snapshot cannot be combined with --profile or --profile-gen." << std::endl;
+            return false;
+        }
+        return !scriptPath.empty();
+    }
+
+    bool wantsIR() const { return dumpIR || timePasses; }
+    bool lazyParsing() const { return lazy && !strict; }
+};
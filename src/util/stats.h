@@ -0,0 +1,197 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../data/AST.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Counters fed by the replacement operator new/delete in main.cpp.
+// They only count while `enabled` is set, so other builds pay nothing.
+struct AllocationCounters {
+    static inline std::atomic<bool> enabled{false};
+    static inline std::atomic<long long> allocations{0};
+    static inline std::atomic<long long> bytes{0};
+    static inline std::atomic<long long> frees{0};
+
+    static void recordAllocation(size_t size) {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add((long long)size, std::memory_order_relaxed);
+    }
+    static void recordFree() {
+        if (!enabled.load(std::memory_order_relaxed)) return;
+        frees.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// Counts AST nodes by class
+class ASTNodeCounter : public ASTWalker {
+public:
+    std::map<std::string, long long> counts;
+    long long total = 0;
+
+    void count(const char* kind) {
+        counts[kind]++;
+        total++;
+    }
+
+    void visitBinaryExpr(BinaryExpr* expr) override { count("BinaryExpr"); ASTWalker::visitBinaryExpr(expr); }
+    void visitGroupingExpr(GroupingExpr* expr) override { count("GroupingExpr"); ASTWalker::visitGroupingExpr(expr); }
+    void visitLiteralExpr(LiteralExpr*) override { count("LiteralExpr"); }
+    void visitUnaryExpr(UnaryExpr* expr) override { count("UnaryExpr"); ASTWalker::visitUnaryExpr(expr); }
+    void visitVariableExpr(VariableExpr*) override { count("VariableExpr"); }
+    void visitAssignExpr(AssignExpr* expr) override { count("AssignExpr"); ASTWalker::visitAssignExpr(expr); }
+    void visitCallExpr(CallExpr* expr) override { count("CallExpr"); ASTWalker::visitCallExpr(expr); }
+    void visitArrayExpr(ArrayExpr* expr) override { count("ArrayExpr"); ASTWalker::visitArrayExpr(expr); }
+    void visitIndexExpr(IndexExpr* expr) override { count("IndexExpr"); ASTWalker::visitIndexExpr(expr); }
+    void visitIndexAssignExpr(IndexAssignExpr* expr) override { count("IndexAssignExpr"); ASTWalker::visitIndexAssignExpr(expr); }
+    void visitBlockStmt(BlockStmt* stmt) override { count("BlockStmt"); ASTWalker::visitBlockStmt(stmt); }
+    void visitExpressionStmt(ExpressionStmt* stmt) override { count("ExpressionStmt"); ASTWalker::visitExpressionStmt(stmt); }
+    void visitFunctionStmt(FunctionStmt* stmt) override { count("FunctionStmt"); ASTWalker::visitFunctionStmt(stmt); }
+    void visitIfStmt(IfStmt* stmt) override { count("IfStmt"); ASTWalker::visitIfStmt(stmt); }
+    void visitPrintStmt(PrintStmt* stmt) override { count("PrintStmt"); ASTWalker::visitPrintStmt(stmt); }
+    void visitReturnStmt(ReturnStmt* stmt) override { count("ReturnStmt"); ASTWalker::visitReturnStmt(stmt); }
+    void visitVarStmt(VarStmt* stmt) override { count("VarStmt"); ASTWalker::visitVarStmt(stmt); }
+    void visitWhileStmt(WhileStmt* stmt) override { count("WhileStmt"); ASTWalker::visitWhileStmt(stmt); }
+    void visitParallelForStmt(ParallelForStmt* stmt) override {
+        count("ParallelForStmt");
+        ASTWalker::visitParallelForStmt(stmt);
+    }
+};
+
+// Per-phase measurements for --stats
+class CompilerStats {
+public:
+    struct Phase {
+        std::string name;
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        long long allocations = 0;
+        long long allocatedBytes = 0;
+        long long frees = 0;
+        long peakRssKB = 0; // Process high-water mark at the end of the phase
+    };
+
+    long long tokens = 0;
+    size_t maxScopeDepth = 0;
+    std::map<std::string, long long> nodeCounts;
+    long long totalNodes = 0;
+
+private:
+    std::vector<Phase> phases;
+    std::chrono::steady_clock::time_point wallStart;
+    std::clock_t cpuStart = 0;
+    long long allocationsStart = 0, bytesStart = 0, freesStart = 0;
+    bool open = false;
+
+    static long peakRss() {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+        return usage.ru_maxrss;        // Kilobytes on Linux
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    static std::string jsonEscape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+public:
+    CompilerStats() { AllocationCounters::enabled = true; }
+    ~CompilerStats() { AllocationCounters::enabled = false; }
+
+    void beginPhase(const std::string& name) {
+        if (open) endPhase();
+        phases.emplace_back();
+        phases.back().name = name;
+        open = true;
+        allocationsStart = AllocationCounters::allocations.load();
+        bytesStart = AllocationCounters::bytes.load();
+        freesStart = AllocationCounters::frees.load();
+        cpuStart = std::clock();
+        wallStart = std::chrono::steady_clock::now();
+    }
+
+    void endPhase() {
+        if (!open) return;
+        Phase& phase = phases.back();
+        phase.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        phase.cpuSeconds = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        phase.allocations = AllocationCounters::allocations.load() - allocationsStart;
+        phase.allocatedBytes = AllocationCounters::bytes.load() - bytesStart;
+        phase.frees = AllocationCounters::frees.load() - freesStart;
+        phase.peakRssKB = peakRss();
+        open = false;
+    }
+
+    // Adds to the counts, once per parsed module
+    void countNodes(const std::vector<std::unique_ptr<Statement>>& program) {
+        ASTNodeCounter counter;
+        counter.walk(program);
+        for (const auto& entry : counter.counts) nodeCounts[entry.first] += entry.second;
+        totalNodes += counter.total;
+    }
+
+    void printText(std::ostream& out) const {
+        out << "=== Compiler statistics ===" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        out << "  " << std::left << std::setw(10) << "phase" << std::right << std::setw(12) << "wall ms"
+            << std::setw(12) << "cpu ms" << std::setw(12) << "allocs" << std::setw(14) << "alloc bytes"
+            << std::setw(12) << "frees" << std::setw(14) << "peak RSS KB" << std::endl;
+        double wall = 0.0, cpu = 0.0;
+        for (const auto& p : phases) {
+            wall += p.wallSeconds;
+            cpu += p.cpuSeconds;
+            out << "  " << std::left << std::setw(10) << p.name << std::right
+                << std::setw(12) << p.wallSeconds * 1000.0 << std::setw(12) << p.cpuSeconds * 1000.0
+                << std::setw(12) << p.allocations << std::setw(14) << p.allocatedBytes
+                << std::setw(12) << p.frees << std::setw(14) << p.peakRssKB << std::endl;
+        }
+        out << "  " << std::left << std::setw(10) << "total" << std::right
+            << std::setw(12) << wall * 1000.0 << std::setw(12) << cpu * 1000.0 << std::endl;
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+
+        out << "  tokens: " << tokens << std::endl;
+        out << "  max scope depth: " << maxScopeDepth << std::endl;
+        out << "  AST nodes: " << totalNodes << std::endl;
+        for (const auto& entry : nodeCounts) {
+            out << "    " << std::left << std::setw(16) << entry.first << std::right << std::setw(10) << entry.second << std::endl;
+        }
+    }
+
+    void printJson(std::ostream& out) const {
+        out << "{\"phases\": [";
+        for (size_t i = 0; i < phases.size(); i++) {
+            const Phase& p = phases[i];
+            out << (i ? ", " : "") << "{\"name\": \"" << jsonEscape(p.name) << "\", \"wall_seconds\": "
+                << std::setprecision(9) << p.wallSeconds << ", \"cpu_seconds\": " << p.cpuSeconds
+                << ", \"allocations\": " << p.allocations << ", \"allocated_bytes\": " << p.allocatedBytes
+                << ", \"frees\": " << p.frees << ", \"peak_rss_kb\": " << p.peakRssKB << "}";
+        }
+        out << "], \"tokens\": " << tokens << ", \"max_scope_depth\": " << maxScopeDepth
+            << ", \"ast_nodes\": {\"total\": " << totalNodes;
+        for (const auto& entry : nodeCounts) out << ", \"" << entry.first << "\": " << entry.second;
+        out << "}}" << std::endl;
+        out << std::setprecision(6);
+    }
+};
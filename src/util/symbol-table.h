@@ -1,19 +1,38 @@
 #pragma once
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <vector>
 #include <string>
 #include "../data/token-type.h"
 
-// Struct to hold info about a declared variable
+class FunctionStmt;
+
+// Full signature of a declared function
+struct FunctionSignature {
+    std::string name;
+    TokenType returnType;
+    std::vector<TokenType> paramTypes;
+    FunctionStmt* declaration;
+};
+
+// Struct to hold info about a declared variable or function
 struct SymbolInfo {
-    TokenType type; // TYPE_INT, TYPE_FLOAT, etc.
+    TokenType type; // TYPE_INT, TYPE_FLOAT, etc. (return type for functions)
     bool initialized;
+    size_t order = 0; // How many declarations came before this one
+    const FunctionSignature* signature = nullptr; // Set for functions only
 };
 
 class SymbolTable {
 private:
     // A stack of scopes. Each scope is a map of Name -> Info
     std::vector<std::map<std::string, SymbolInfo>> scopes;
+    // Signatures outlive the scope that declared them; deque keeps pointers stable
+    std::deque<FunctionSignature> signatures;
+    size_t maxDepth = 0; // Deepest nesting seen, global scope included
+    size_t declarations = 0;
+    size_t visibleGlobals = SIZE_MAX; // Globals declared later are hidden
 
 public:
     SymbolTable() {
@@ -23,6 +42,7 @@ public:
 
     void beginScope() {
         scopes.push_back(std::map<std::string, SymbolInfo>());
+        if (scopes.size() > maxDepth) maxDepth = scopes.size();
     }
 
     void endScope() {
@@ -35,19 +55,43 @@ public:
         if (scopes.back().find(name) != scopes.back().end()) {
             return false; // Already exists
         }
-        scopes.back()[name] = {type, true};
+        scopes.back()[name] = {type, true, declarations++};
         return true;
     }
 
+    bool declareFunction(const FunctionSignature& signature) {
+        if (!declare(signature.name, signature.returnType)) return false;
+        signatures.push_back(signature);
+        scopes.back()[signature.name].signature = &signatures.back();
+        return true;
+    }
+
+    // Checking a function body after the code that follows it (a body
+    // skipped by --lazy) hides the globals declared since, so the body sees
+    // what it would have seen in order
+    size_t declarationCount() const { return declarations; }
+    void hideGlobalsFrom(size_t count) { visibleGlobals = count; }
+
+    const std::deque<FunctionSignature>& allSignatures() const { return signatures; }
+    size_t maxScopeDepth() const { return maxDepth; }
+
     // Look up a variable in any scope, starting from innermost
     bool get(std::string name, SymbolInfo& outInfo) {
         for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
             auto found = it->find(name);
-            if (found != it->end()) {
+            if (found != it->end() && (it + 1 != scopes.rend() || found->second.order < visibleGlobals)) {
                 outInfo = found->second;
                 return true;
             }
         }
         return false;
     }
+
+    // True if the innermost declaration of `name` is in the global scope
+    bool isGlobal(const std::string& name) const {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            if (it->count(name)) return it + 1 == scopes.rend();
+        }
+        return false;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Span tracing in the Chrome trace-event format (chrome://tracing, Perfetto).
+//
+// Spans are recorded as complete ("X") events into a buffer owned by the
+// calling thread, so recording never takes a lock; buffers are registered
+// once per thread and stay alive after the thread exits. When tracing is
+// off, a TraceSpan costs one relaxed atomic load.
+struct TraceEvent {
+    std::string name;
+    std::string args;     // Rendered JSON members, without braces
+    long long start = 0;  // Microseconds since Tracer::enable()
+    long long duration = 0;
+};
+
+class Tracer {
+private:
+    struct Buffer {
+        int tid = 0;
+        std::vector<TraceEvent> events;
+    };
+
+    static inline std::atomic<bool> active{false};
+    static inline std::chrono::steady_clock::time_point origin;
+    static inline std::mutex registryMutex;
+    static inline std::vector<std::shared_ptr<Buffer>> buffers;
+
+    static std::shared_ptr<Buffer> registerBuffer() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto buffer = std::make_shared<Buffer>();
+        buffer->tid = (int)buffers.size() + 1;
+        buffers.push_back(buffer);
+        return buffer;
+    }
+
+    static Buffer& localBuffer() {
+        thread_local std::shared_ptr<Buffer> buffer = registerBuffer();
+        return *buffer;
+    }
+
+public:
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    static void enable() {
+        origin = std::chrono::steady_clock::now();
+        active.store(true);
+    }
+
+    static long long nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    static void record(TraceEvent event) { localBuffer().events.push_back(std::move(event)); }
+
+    static std::string escape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    // Writes every recorded event. Call once worker threads have finished.
+    static bool write(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const auto& buffer : buffers) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+                << ", \"args\": {\"name\": \"" << (buffer->tid == 1 ? "main" : "worker " + std::to_string(buffer->tid - 1)) << "\"}}";
+            first = false;
+            for (const auto& e : buffer->events) {
+                out << ",\n{\"name\": \"" << escape(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+                    << ", \"ts\": " << e.start << ", \"dur\": " << e.duration;
+                if (!e.args.empty()) out << ", \"args\": {" << e.args << "}";
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+        return true;
+    }
+};
+
+// Records the time between construction and destruction as one span.
+class TraceSpan {
+private:
+    bool recording;
+    TraceEvent event;
+
+public:
+    explicit TraceSpan(const char* name) : recording(Tracer::enabled()) {
+        if (!recording) return;
+        event.name = name;
+        event.start = Tracer::nowMicros();
+    }
+    ~TraceSpan() {
+        if (!recording) return;
+        event.duration = Tracer::nowMicros() - event.start;
+        Tracer::record(std::move(event));
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Check before building names or arguments so disabled tracing stays free
+    bool active() const { return recording; }
+
+    void rename(const std::string& name) {
+        if (recording) event.name = name;
+    }
+    void arg(const char* key, const std::string& value) {
+        if (!recording) return;
+        if (!event.args.empty()) event.args += ", ";
+        event.args += "\"" + std::string(key) + "\": \"" + Tracer::escape(value) + "\"";
+    }
+    void arg(const char* key, long long value) {
+        if (!recording) return;
+        if (!event.args.empty()) event.args += ", ";
+        event.args += "\"" + std::string(key) + "\": " + std::to_string(value);
+    }
+};